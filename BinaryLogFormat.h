@@ -0,0 +1,203 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef BINARYLOGFORMAT_H
+#define BINARYLOGFORMAT_H
+
+# include <QtGlobal>
+
+/********************************************************************//*
+**   @file BinaryLogFormat.h
+**   
+**   PROJECT QcjLib
+**   
+**   Description:  Layout  of  the  binary  log  files written by
+**   BinaryLogWriter  and  read  back  by  the  LogDecode tool. All
+**   values are stored in the byte order of the writing host.
+**
+**   A  file  starts  with  a  FileHeader followed by a stream of
+**   records.  Each record starts with a one byte kind. Category
+**   and  function  names  are  interned,  a StringRecord defining
+**   an  id  is  written  ahead  of  the first MessageRecord using
+**   it,  so  a  file  cut  short  by  a  crash  still  decodes up
+**   to the last complete record.
+**
+**   Flight  recorder  files,  written  by  FlightRecorder,  start with
+**   a  FlightHeader  followed  by  a  fixed size data area used as a
+**   ring.  Records  there  are  self contained since older ones are
+**   overwritten,  and  never  wrap  around  the end of the area, a
+**   pad record fills the space left at the end instead.
+***********************************************************************/
+
+namespace QcjLib
+{
+   namespace BinaryLog
+   {
+      static const char    MAGIC[8]    = { 'Q', 'C', 'J', 'B', 'L', 'O', 'G', '1' };
+      static const quint32 VERSION     = 2;
+
+      enum RecordKind
+      {
+         KindString     = 1,
+         KindMessage    = 2,
+         KindStructured = 3
+      };
+
+      enum StringKind
+      {
+         StringCategory = 1,
+         StringFunction = 2,
+         StringFormat   = 3,
+         StringKey      = 4
+      };
+
+      /********************************************************************//*
+      **   Written  once  at  the start of the file. start_epoch_ms and
+      **   start_monotonic_ns  are  taken at the same moment, so record
+      **   time  stamps  can  be  turned  back  into wall clock time.
+      ***********************************************************************/
+      struct FileHeader
+      {
+         char        magic[8];
+         quint32     version;
+         quint32     header_size;
+         qint64      start_epoch_ms;
+         qint64      start_monotonic_ns;
+      };
+
+      /********************************************************************//*
+      **   Defines  string id for the given kind. Followed by length
+      **   bytes of UTF-8 text.
+      ***********************************************************************/
+      struct StringRecord
+      {
+         quint8      kind;             /* KindString */
+         quint8      string_kind;
+         quint16     reserved;
+         quint32     id;
+         quint32     length;
+      };
+
+      /********************************************************************//*
+      **   One  log  message. Followed by length bytes of UTF-8 text.
+      **   Id  0  is  used for the category and function of messages
+      **   that were handed to the Logger already formatted, in which
+      **   case the text is the complete line.
+      ***********************************************************************/
+      struct MessageRecord
+      {
+         quint8      kind;             /* KindMessage */
+         quint8      msg_type;         /* QtMsgType */
+         quint16     level;
+         quint32     thread_id;
+         quint32     category_id;
+         quint32     function_id;
+         qint64      timestamp_ns;     /* monotonic */
+         quint32     length;
+         quint32     reserved;
+      };
+
+      /********************************************************************//*
+      **   One  structured  log  message.  Followed  by  arg_count
+      **   ArgRecords.
+      ***********************************************************************/
+      struct StructuredRecord
+      {
+         quint8      kind;             /* KindStructured */
+         quint8      msg_type;         /* QtMsgType */
+         quint16     level;
+         quint32     thread_id;
+         quint32     category_id;
+         quint32     function_id;
+         qint64      timestamp_ns;     /* monotonic */
+         quint32     format_id;
+         quint32     arg_count;
+      };
+
+      /********************************************************************//*
+      **   One  argument  of  a  StructuredRecord.  key_id  is  0  for
+      **   positional  arguments.  value  holds  the  LogArg  value  for
+      **   numbers  and pointers, for strings it holds the length of
+      **   the UTF-8 text that follows.
+      ***********************************************************************/
+      struct ArgRecord
+      {
+         quint8      type;             /* LogArg::Type */
+         quint8      reserved[3];
+         quint32     key_id;
+         quint64     value;
+      };
+
+      static const char    FLIGHT_MAGIC[8]      = { 'Q', 'C', 'J', 'F', 'L', 'I', 'T', '1' };
+      static const quint32 FLIGHT_VERSION       = 1;
+      static const quint32 FLIGHT_RECORD_MARKER = 0x52544c46;   /* "FLTR" */
+      static const quint32 FLIGHT_PAD_MARKER    = 0x44415046;   /* "FPAD" */
+      static const quint32 FLIGHT_ALIGN         = 8;
+
+      /********************************************************************//*
+      **   Start  of  a flight recorder file. head and tail are absolute
+      **   byte  positions  in  the  stream  of records written, the ring
+      **   offset  is  the  position  modulo capacity. Records from tail
+      **   up  to  head  are complete, head is only advanced once the
+      **   record before it has been written out.
+      ***********************************************************************/
+      struct FlightHeader
+      {
+         char        magic[8];
+         quint32     version;
+         quint32     header_size;
+         qint64      start_epoch_ms;
+         qint64      start_monotonic_ns;
+         quint64     capacity;
+         quint64     head;
+         quint64     tail;
+      };
+
+      /********************************************************************//*
+      **   One  log  message  in  the  ring.  Followed  by  the UTF-8
+      **   category,  function and text, then padding to FLIGHT_ALIGN.
+      **   length  covers all of it. A pad record only uses marker and
+      **   length.
+      ***********************************************************************/
+      struct FlightRecord
+      {
+         quint32     marker;           /* FLIGHT_RECORD_MARKER or FLIGHT_PAD_MARKER */
+         quint32     length;
+         quint64     sequence;
+         qint64      timestamp_ns;     /* monotonic */
+         quint32     thread_id;
+         quint8      msg_type;         /* QtMsgType */
+         quint8      reserved;
+         quint16     level;
+         quint16     category_length;
+         quint16     function_length;
+         quint32     text_length;
+      };
+   }
+};
+
+#endif
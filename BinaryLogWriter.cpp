@@ -0,0 +1,267 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+# include "BinaryLogWriter.h"
+# include "Logger.h"
+
+# include <QDateTime>
+# include <QVarLengthArray>
+
+# include <string.h>
+
+using namespace QcjLib;
+
+BinaryLogWriter::BinaryLogWriter() :
+   m_nextId(1)
+{
+}
+
+BinaryLogWriter::~BinaryLogWriter()
+{
+   Close();
+}
+
+/********************************************************************//*
+**   bool BinaryLogWriter::Open(QString filename)
+**   
+**   Creates  filename,  replacing  any existing file, and writes
+**   the file header.
+**   
+**   Returns true if the file could be opened.
+***********************************************************************/
+bool BinaryLogWriter::Open(QString filename)
+{
+   Close();
+
+   m_file.setFileName(filename);
+   if ( ! m_file.open(QIODevice::WriteOnly | QIODevice::Truncate) ) 
+   {
+      return(false);
+   }
+
+   BinaryLog::FileHeader hdr;
+   memcpy(hdr.magic, BinaryLog::MAGIC, sizeof(hdr.magic));
+   hdr.version = BinaryLog::VERSION;
+   hdr.header_size = sizeof(hdr);
+   hdr.start_epoch_ms = QDateTime::currentMSecsSinceEpoch();
+   hdr.start_monotonic_ns = Logger::MonotonicNs();
+   m_file.write((const char*)&hdr, sizeof(hdr));
+   return(true);
+}
+
+void BinaryLogWriter::Close()
+{
+   if ( m_file.isOpen() ) 
+   {
+      m_file.close();
+   }
+   m_categoryIds.clear();
+   m_functionIds.clear();
+   m_formatIds.clear();
+   m_keyIds.clear();
+   m_nextId = 1;
+}
+
+void BinaryLogWriter::Flush()
+{
+   if ( m_file.isOpen() ) 
+   {
+      m_file.flush();
+   }
+}
+
+/********************************************************************//*
+**   void BinaryLogWriter::Write(const LogRecord &rec)
+**   
+**   Appends  one  record  to  the file, defining its category and
+**   function names first if this is their first use.
+**   
+**   Returns N/A
+***********************************************************************/
+void BinaryLogWriter::Write(const LogRecord &rec)
+{
+   BinaryLog::MessageRecord msg;
+   QByteArray text;
+
+   if ( rec.isStructured() && ! rec.isFormatted() ) 
+   {
+      WriteStructured(rec);
+      return;
+   }
+
+   if ( rec.isFormatted() ) 
+   {
+      msg.category_id = 0;
+      msg.function_id = 0;
+      text = rec.text.toUtf8();
+   }
+   else 
+   {
+      msg.category_id = CategoryId(rec.category);
+      msg.function_id = FunctionId(rec.function);
+      text = rec.message.toUtf8();
+   }
+
+   msg.kind = BinaryLog::KindMessage;
+   msg.msg_type = (quint8)rec.type;
+   msg.level = (quint16)rec.level;
+   msg.thread_id = rec.threadId;
+   msg.timestamp_ns = rec.monotonic;
+   msg.length = text.size();
+   msg.reserved = 0;
+
+   m_file.write((const char*)&msg, sizeof(msg));
+   m_file.write(text);
+}
+
+quint32 BinaryLogWriter::CategoryId(const QString &name)
+{
+   quint32 rv = m_categoryIds.value(name, 0);
+   if ( rv == 0 ) 
+   {
+      rv = m_nextId++;
+      m_categoryIds.insert(name, rv);
+      WriteString(BinaryLog::StringCategory, rv, name.toUtf8());
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   quint32 BinaryLogWriter::FunctionId(const QByteArray &function)
+**   
+**   Returns  the  id  of  a  function  name,  looked up by its text,
+**   defining it in the file on first use. No name is id 0.
+***********************************************************************/
+quint32 BinaryLogWriter::FunctionId(const QByteArray &function)
+{
+   if ( function.isEmpty() ) 
+   {
+      return(0);
+   }
+
+   quint32 rv = m_functionIds.value(function, 0);
+   if ( rv == 0 ) 
+   {
+      rv = m_nextId++;
+      m_functionIds.insert(function, rv);
+      WriteString(BinaryLog::StringFunction, rv, function);
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   quint32 BinaryLogWriter::PointerId(QHash<const char*, quint32> &ids,
+**                                      quint8 string_kind, const char *str)
+**   
+**   Returns  the  id of a string in static storage, looked up by its
+**   address, defining it in the file on first use. NULL is id 0.
+***********************************************************************/
+quint32 BinaryLogWriter::PointerId(QHash<const char*, quint32> &ids, quint8 string_kind, const char *str)
+{
+   if ( str == NULL ) 
+   {
+      return(0);
+   }
+
+   quint32 rv = ids.value(str, 0);
+   if ( rv == 0 ) 
+   {
+      rv = m_nextId++;
+      ids.insert(str, rv);
+      WriteString(string_kind, rv, QByteArray(str));
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   void BinaryLogWriter::WriteStructured(const LogRecord &rec)
+**   
+**   Writes  a  structured record as its format id and arguments.
+**   Only string arguments are converted, to UTF-8.
+***********************************************************************/
+void BinaryLogWriter::WriteStructured(const LogRecord &rec)
+{
+   BinaryLog::StructuredRecord hdr;
+   hdr.kind = BinaryLog::KindStructured;
+   hdr.msg_type = (quint8)rec.type;
+   hdr.level = (quint16)rec.level;
+   hdr.thread_id = rec.threadId;
+   hdr.category_id = CategoryId(rec.category);
+   hdr.function_id = FunctionId(rec.function);
+   hdr.timestamp_ns = rec.monotonic;
+   hdr.format_id = PointerId(m_formatIds, BinaryLog::StringFormat, rec.format);
+   hdr.arg_count = rec.args.size();
+
+   /***********************************************/
+   /*   Keys have to be defined before the        */
+   /*   record that uses them.                    */
+   /***********************************************/
+   QVarLengthArray<quint32, 16> key_ids;
+   foreach (const LogArg &arg, rec.args)
+   {
+      key_ids.append(PointerId(m_keyIds, BinaryLog::StringKey, arg.key));
+   }
+
+   m_file.write((const char*)&hdr, sizeof(hdr));
+   for (int x = 0; x < rec.args.size(); x++) 
+   {
+      const LogArg &arg = rec.args.at(x);
+      BinaryLog::ArgRecord ar;
+      QByteArray text;
+
+      memset(&ar, 0, sizeof(ar));
+      ar.type = arg.type;
+      ar.key_id = key_ids[x];
+      if ( arg.type == LogArg::String ) 
+      {
+         text = arg.str.toUtf8();
+         ar.value = text.size();
+      }
+      else 
+      {
+         memcpy(&ar.value, &arg.i, sizeof(ar.value));
+      }
+      m_file.write((const char*)&ar, sizeof(ar));
+      if ( ! text.isEmpty() ) 
+      {
+         m_file.write(text);
+      }
+   }
+}
+
+void BinaryLogWriter::WriteString(quint8 string_kind, quint32 id, const QByteArray &text)
+{
+   BinaryLog::StringRecord str;
+   str.kind = BinaryLog::KindString;
+   str.string_kind = string_kind;
+   str.reserved = 0;
+   str.id = id;
+   str.length = text.size();
+
+   m_file.write((const char*)&str, sizeof(str));
+   m_file.write(text);
+}
@@ -0,0 +1,81 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef BINARYLOGWRITER_H
+#define BINARYLOGWRITER_H
+
+# include <QByteArray>
+# include <QFile>
+# include <QHash>
+# include <QString>
+
+# include "BinaryLogFormat.h"
+# include "LogRecord.h"
+
+namespace QcjLib
+{
+   /********************************************************************//*
+   **   class BinaryLogWriter
+   **   
+   **   Writes  log  records  to  a  file  in  the compact layout of
+   **   BinaryLogFormat.h  without  formatting  them  as text. Used
+   **   by  the  Logger for its binary sink, the caller is expected
+   **   to serialize access.
+   ***********************************************************************/
+   class BinaryLogWriter
+   {
+   public:
+      BinaryLogWriter();
+      ~BinaryLogWriter();
+
+      bool Open(QString filename);
+      void Close();
+      void Flush();
+      void Write(const LogRecord &rec);
+
+      bool IsOpen() const
+      {
+         return(m_file.isOpen());
+      }
+
+   private:
+      quint32 CategoryId(const QString &name);
+      quint32 FunctionId(const QByteArray &function);
+      quint32 PointerId(QHash<const char*, quint32> &ids, quint8 string_kind, const char *str);
+      void    WriteStructured(const LogRecord &rec);
+      void    WriteString(quint8 string_kind, quint32 id, const QByteArray &text);
+
+      QFile                         m_file;
+      QHash<QString, quint32>       m_categoryIds;
+      QHash<QByteArray, quint32>    m_functionIds;
+      QHash<const char*, quint32>   m_formatIds;
+      QHash<const char*, quint32>   m_keyIds;
+      quint32                       m_nextId;
+   };
+};
+
+#endif
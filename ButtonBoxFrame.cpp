@@ -27,6 +27,7 @@
 /******************************************************************************/
 #include "QcjLib/ButtonBoxFrame.h"
 #include "QcjLib/LinkedCheckBox.h"
+#include "QcjLib/QueryCache.h"
 #include "QcjData/QcjDataLogin.h"
 #include "QcjData/QcjDataStatics.h"
 #include "QcjData/QcjDataXML.h"
@@ -78,40 +79,36 @@ void QcjLib::ButtonBoxFrame::setDatabase(const QStringList &items)
    qDebug() << "field_defs size:" << field_defs.size();
 
    /********************************************************************/
-   /* Create a model for the table and fetch all of the records (there */
-   /* shouldn't bee too many)                                          */
+   /* Fetch all of the records for the table (there shouldn't bee too  */
+   /* many) through the query cache, the item values are bound.        */
    /********************************************************************/
    QSqlDriver *drv = pDb->driver();
    QString db_table = pFormDef->getTable(m_xmldef);
    qDebug() << "table =" << db_table;
-   QSqlTableModel model(nullptr, *pDb);
-   model.setTable(db_table);
+   QString sql = "select * from " + drv->escapeIdentifier(db_table, QSqlDriver::TableName);
+   QVariantList values;
    if (field_defs.size() > 1)
    {
       QString fn = drv->escapeIdentifier(field_defs[1].dataName, QSqlDriver::FieldName);
       QString fv;
       foreach (QString val, items)
       {
-         val.remove("'");
          if (fv.length() > 0)
          {
             fv += ", ";
          }
-         fv += QString("'%1'").arg(val);
+         fv += "?";
+         values.append(val);
       }
-      model.setFilter(QString("%1 in (%2)").arg(fn).arg(fv));
-      qDebug() << "filter = " << model.filter();
-   }
-   model.select();
-   while (model.canFetchMore())
-   {
-      model.fetchMore();
+      sql += QString(" where %1 in (%2)").arg(fn).arg(fv);
+      qDebug() << "sql = " << sql << ", values = " << values;
    }
+   CachedResult_t items_rows = QueryCache::instance()->Exec(*pDb, sql, values, QStringList(db_table));
 
    /**********************************************************/
    /* Now calculate the number columns of buttons to present */
    /**********************************************************/
-   int rows = model.rowCount();
+   int rows = items_rows.isNull() ? 0 : items_rows->rows;
    qDebug() << "rows:" << rows;
    if (rows > 0)
    {
@@ -132,7 +129,7 @@ void QcjLib::ButtonBoxFrame::setDatabase(const QStringList &items)
       QAbstractButton *btn = nullptr;
       for (int recidx = 0; recidx < rows; recidx++)
       {
-         QSqlRecord rec = model.record(recidx);
+         QSqlRecord rec = items_rows->Record(recidx);
          QString btn_text = rec.value(field_defs[0].dataName).toString();
          if (field_defs[0].fieldType.contains("radio"))
          {
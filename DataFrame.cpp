@@ -28,9 +28,11 @@
 # include <QAbstractButton>
 # include <QDebug>
 # include <QMessageBox>
+# include <QSqlDatabase>
 
 # include "DataFrame.h"
 # include "QcjData/QcjDataStatics.h"
+# include "QcjLib/DbgTimer.h"
 # include "QcjLib/WidgetUtils.h"
 
 using namespace QcjLib;
@@ -371,6 +373,7 @@ void DataFrame::haveNewAction(bool)
 void DataFrame::haveSaveAction(bool)
 {
 #ifndef QT4_DESIGNER_PLUGIN
+   QCJ_TIME_SCOPE("DataFrame::haveSaveAction");
    if ( m_state != Qcj::Search ) 
    {
       printf("QcjLib::DataFrame::haveSaveAction(): Enter\n");
@@ -570,7 +573,10 @@ void DataFrame::haveUpdated()
    fflush(stdout);
 
    if ( m_table != 0 ) 
+   {
+      QCJ_TIME_SCOPE("DataFrame::haveUpdated refresh");
       m_table->refresh(true);
+   }
 
    setState(Qcj::Updated);
    printf("QcjLib::DataFrame::haveUpdated(): Exit\n");
@@ -616,6 +622,18 @@ void DataFrame::setTableFilter(QString filter)
    }
 }
 
+/********************************************************************//*
+**   void DataFrame::setTableFilter(const SqlFilter &filter)
+**   
+**   QcjDataTable  only takes a where string, so the values of filter
+**   are  written  into  it  as literals escaped by the driver of the
+**   default connection.
+***********************************************************************/
+void DataFrame::setTableFilter(const SqlFilter &filter)
+{
+   setTableFilter(filter.InlineSql(QSqlDatabase::database().driver()));
+}
+
 int DataFrame::rowCount() const
 {
    return(m_table->rowCount());
@@ -32,6 +32,7 @@
 # include <QFrame>
 # include "CancelableFrame.h"
 # include "DataWidgets.h"
+# include "SqlFilter.h"
 # include "../QcjData/Qcj.h"
 # include "../QcjData/QcjDataTable.h"
 #include <stdlib.h>
@@ -98,6 +99,7 @@ namespace QcjLib
 
       void  setDatabase();
       void  setTableFilter(QString filter);
+      void  setTableFilter(const SqlFilter &filter);
       bool  validate();
       int   rowCount() const;
 
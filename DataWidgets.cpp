@@ -66,6 +66,9 @@
 #include "QcjData/QcjDataStatics.h"
 #include "QcjData/QcjPhotoSelect.h"
 #include "QcjLib/CameraCaptureDialog.h"
+#include "QcjLib/DbgTimer.h"
+#include "QcjLib/MetricBuilder.h"
+#include "QcjLib/QueryCache.h"
 #include "QcjLib/Sql.h"
 #include "QcjLib/SqlError.h"
 
@@ -318,6 +321,7 @@ void AutoDataForm::deleteRecord()
       rollbackTransaction();
       return;
    }
+   QueryCache::instance()->Invalidate(m_model.tableName());
    emit(updated());
 }
 
@@ -439,6 +443,10 @@ QSqlRecord AutoDataForm::insertRecord(const VariantMap &predefined_fields)
       SqlError::showError("inserting record", q1, this);
       rollbackTransaction();
    }
+   else
+   {
+      QueryCache::instance()->Invalidate(m_tableName);
+   }
    QSqlRecord rec;
    if (q1.next())
    {
@@ -480,6 +488,9 @@ void AutoDataForm::refresh(QSqlRecord *record)
 
 void AutoDataForm::refresh(QSqlRecord *record, bool no_transaction)
 {
+   static MetricHistogram refresh_latency("qcjlib_form_refresh_seconds", "Time taken to refresh a data form from the database");
+   MetricTimer refresh_timer(refresh_latency);
+   QCJ_TIME_SCOPE("AutoDataForm::refresh");
    qDebug() << objectName() << "enter...";
    /*
    if (! no_transaction && hasChanges())
@@ -515,7 +526,12 @@ void AutoDataForm::refresh(QSqlRecord *record, bool no_transaction)
    qDebug() << "sql: " << sql;
    QSqlQuery q1;
    q1.prepare(sql);
-   if ( ! q1.exec())
+   bool ok;
+   {
+      QCJ_TIME_SCOPE("AutoDataForm::refresh exec");
+      ok = q1.exec();
+   }
+   if ( ! ok)
    {
       SqlError::showError("fetching selected record", q1, this);
       rollbackTransaction();
@@ -530,6 +546,7 @@ void AutoDataForm::refresh(QSqlRecord *record, bool no_transaction)
 
 void AutoDataForm::updateRecord()
 {
+   QCJ_TIME_SCOPE("AutoDataForm::updateRecord");
    QString fields;
    QString filter = pFormDef->getWhereClause(m_xmldef, &m_record, &m_db);
    QSqlRecord record = formToRecord(m_model.record());
@@ -563,12 +580,18 @@ void AutoDataForm::updateRecord()
    //      qDebug() << "Binding " << data_wdt->getValue().toString() << QString(" to :%1").arg(field_name);
          q1.bindValue(QString(":%1").arg(field_name), data_wdt->getValue());
       }
-      if ( ! q1.exec())
+      bool ok;
+      {
+         QCJ_TIME_SCOPE("AutoDataForm::updateRecord exec");
+         ok = q1.exec();
+      }
+      if ( ! ok)
       {
          SqlError::showError("updating record", q1, this);
          rollbackTransaction();
          return;
       }
+      QueryCache::instance()->Invalidate(m_model.tableName());
       emit(updated());
    }
    qDebug() << "Exit";
@@ -1427,8 +1450,14 @@ void PhotoEntry::setValue(const QVariant &value)
  
 void PhotoEntry::showImage()
 {
+   static MetricHistogram decode_time("qcjlib_image_decode_seconds", "Time taken to decode a photo field's image");
    QPixmap pm;
-   if ( ! pm.loadFromData(m_ba))
+   bool loaded;
+   {
+      MetricTimer decode_timer(decode_time);
+      loaded = pm.loadFromData(m_ba);
+   }
+   if ( ! loaded)
    {
       qDebug() << "Error loading data";
    }
@@ -29,50 +29,127 @@
 #define DBGTIMER_H
 
 #include "LogBuilder.h"
+#include "ScopeProfiler.h"
+#include "ScopeStack.h"
+#include "TraceRecorder.h"
 
 #include <QDebug>
 #include <QElapsedTimer>
 #include <QString>
 
+#include <atomic>
+
 namespace QcjLib
 {
+   /********************************************************************//*
+   **   class DbgTimer
+   **   
+   **   Times  the  scope  it  lives  in.  Constructed with a function
+   **   name  and  line  it  logs  when  it  starts  and how long the
+   **   scope took.
+   **
+   **   Constructed  with  a  ProfileSite it logs nothing and adds the
+   **   time  to  the  ScopeProfiler  totals for the site instead, which
+   **   is cheap enough for hot functions. See QCJ_PROFILE_SCOPE() and
+   **   QCJ_TIME_SCOPE().
+   **
+   **   Either  way,  while  the TraceRecorder is on, the scope is also
+   **   recorded  as a trace span, and while the ScopeStack is active
+   **   timers  built  from  a  const char* name or a ProfileSite are
+   **   pushed on the thread's scope stack.
+   ***********************************************************************/
    class DbgTimer : public QElapsedTimer
    {
    public:
-      DbgTimer(QString funct, int line, int dbg = 1, int dbgThreshhold = 0)
+      DbgTimer(QString funct, int line, int dbg = 1, int dbgThreshhold = 0) :
+         m_site(NULL),
+         m_line(line),
+         m_dbg(dbg),
+         m_dbgThreshhold(dbgThreshhold)
+      {
+         m_traced = TraceRecorder::IsEnabled() && TraceRecorder::Begin(funct, line);
+         m_stacked = false;
+         if ( m_dbg > m_dbgThreshhold ) 
+            Started(funct);
+      }
+
+      /***********************************************/
+      /*   funct must outlive the timer, as string   */
+      /*   literals and __FUNCTION__ do. It is only  */
+      /*   copied if the timer logs.                 */
+      /***********************************************/
+      DbgTimer(const char *funct, int line, int dbg = 1, int dbgThreshhold = 0) :
+         m_site(NULL),
+         m_line(line),
+         m_dbg(dbg),
+         m_dbgThreshhold(dbgThreshhold)
       {
-         static int  m_nextId = 0;
-         m_dbg = dbg;
-         m_dbgThreshhold = dbgThreshhold;
+         m_traced = TraceRecorder::IsEnabled() && TraceRecorder::Begin(funct, line);
+         m_stacked = ScopeStack::IsActive() && ScopeStack::Push(funct, line);
          if ( m_dbg > m_dbgThreshhold ) 
+            Started(QString(funct));
+      }
+
+      DbgTimer(const ProfileSite &site) :
+         m_site(site.IsEnabled() ? &site : NULL),
+         m_traced(false),
+         m_stacked(false),
+         m_line(site.line),
+         m_dbg(0),
+         m_dbgThreshhold(0)
+      {
+         if ( m_site != NULL ) 
          {
-            m_timerId = m_nextId++;
-            m_funct = funct;
-            m_line = line;
-            qDebug(*QcjLib::log(LOG, 1)) << "ST:0    Timer [" << m_timerId << ":" << m_funct << "@" << m_line << "] started!";
+            m_traced = TraceRecorder::IsEnabled() && TraceRecorder::Begin(site.funct, site.line);
+            m_stacked = ScopeStack::IsActive() && ScopeStack::Push(site.funct, site.line);
             start();
          }
       }
 
       ~DbgTimer()
       {
-         if ( m_dbg > m_dbgThreshhold ) 
+         if ( m_site != NULL ) 
+         {
+            ScopeProfiler::Record(*m_site, nsecsElapsed());
+         }
+         else if ( m_dbg > m_dbgThreshhold ) 
          {
-            qDebug(*QcjLib::log(LOG, 1)) << "ET:" << elapsed() <<"\tTimer [" << m_timerId << ":" << m_funct << "@" << m_line << "]";
+            qcjDebug(LOG, 1) << "ET:" << elapsed() <<"\tTimer [" << m_timerId << ":" << m_funct << "@" << m_line << "]";
          }
+         if ( m_traced ) 
+            TraceRecorder::End();
+         if ( m_stacked ) 
+            ScopeStack::Pop();
       }
 
       void snapShot()
       {
          if ( m_dbg > m_dbgThreshhold ) 
          {
-            qDebug(*QcjLib::log(LOG, 1)) << "SS:" << elapsed() <<"\tTimer [" << m_timerId << ":" << m_funct << "@" << m_line << "]";
+            qcjDebug(LOG, 1) << "SS:" << elapsed() <<"\tTimer [" << m_timerId << ":" << m_funct << "@" << m_line << "]";
          }
       }
 
       static const QString LOG;
 
    private:
+      static int NextId()
+      {
+         static std::atomic<int> next_id(0);
+         return(next_id.fetch_add(1, std::memory_order_relaxed));
+      }
+
+      void Started(QString funct)
+      {
+         m_timerId = NextId();
+         m_funct = funct;
+         qcjDebug(LOG, 1) << "ST:0    Timer [" << m_timerId << ":" << m_funct << "@" << m_line << "] started!";
+         start();
+      }
+
+      const ProfileSite *m_site;
+      bool        m_traced;
+      bool        m_stacked;
       int         m_timerId;
       QString     m_funct;
       int         m_line;
@@ -81,4 +158,37 @@ namespace QcjLib
    };
 }
 
+/***********************************************/
+/*   Adds the time until the end of the        */
+/*   enclosing scope to the ScopeProfiler      */
+/*   totals for this function and line.        */
+/***********************************************/
+# define QCJ_PROFILE_SCOPE() \
+   static QcjLib::ProfileSite qcj_profile_site(__FUNCTION__, __LINE__); \
+   QcjLib::DbgTimer qcj_profile_timer(qcj_profile_site)
+
+/********************************************************************//*
+**   QCJ_TIME_SCOPE(name)
+**   
+**   Times  the  rest of the enclosing scope under name, which must
+**   be  a string literal. The site is registered the first time the
+**   line  runs,  as  the  log "timer.<name>", after that each use
+**   costs  a  level  test  and,  when enabled, two clock reads. It
+**   adds  to  the ScopeProfiler totals and records a trace span
+**   while the TraceRecorder is on.
+**
+**   Defining  QCJ_DISABLE_TIME_SCOPES  when  building removes the
+**   timers completely.
+***********************************************************************/
+# define QCJ_CONCAT_(a, b) a##b
+# define QCJ_CONCAT(a, b) QCJ_CONCAT_(a, b)
+
+# ifndef QCJ_DISABLE_TIME_SCOPES
+#  define QCJ_TIME_SCOPE(name) \
+   static const QcjLib::ProfileSite QCJ_CONCAT(qcj_time_site_, __LINE__)(name, __FILE__, __LINE__); \
+   QcjLib::DbgTimer QCJ_CONCAT(qcj_time_scope_, __LINE__)(QCJ_CONCAT(qcj_time_site_, __LINE__))
+# else
+#  define QCJ_TIME_SCOPE(name) do { } while ( 0 )
+# endif
+
 #endif
@@ -0,0 +1,259 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+# include "FlightRecorder.h"
+# include "Logger.h"
+
+# include <QDateTime>
+
+# include <string.h>
+#include <atomic>
+
+using namespace QcjLib;
+
+const qint64  FlightRecorder::DEFAULT_CAPACITY = 4 * 1024 * 1024;
+const QString FlightRecorder::PREVIOUS_SUFFIX(".prev");
+
+static quint64 Align(quint64 size)
+{
+   return((size + BinaryLog::FLIGHT_ALIGN - 1) & ~(quint64)(BinaryLog::FLIGHT_ALIGN - 1));
+}
+
+FlightRecorder::FlightRecorder() :
+   m_header(NULL),
+   m_data(NULL),
+   m_capacity(0),
+   m_sequence(0)
+{
+}
+
+FlightRecorder::~FlightRecorder()
+{
+   Close();
+}
+
+/********************************************************************//*
+**   bool FlightRecorder::Open(QString filename, qint64 capacity)
+**   
+**   Creates  and  maps  filename  with room for capacity bytes of
+**   records.  An  existing  file  is  most  likely  the record of a
+**   previous  crash,  so  rather  than  being  overwritten  it  is
+**   renamed with PREVIOUS_SUFFIX appended.
+**   
+**   Returns true if the file could be created and mapped.
+***********************************************************************/
+bool FlightRecorder::Open(QString filename, qint64 capacity)
+{
+   Close();
+
+   if ( QFile::exists(filename) ) 
+   {
+      QFile::remove(filename + PREVIOUS_SUFFIX);
+      QFile::rename(filename, filename + PREVIOUS_SUFFIX);
+   }
+
+   capacity = Align(qMax(capacity, (qint64)(64 * 1024)));
+   qint64 size = sizeof(BinaryLog::FlightHeader) + capacity;
+
+   m_file.setFileName(filename);
+   if ( ! m_file.open(QIODevice::ReadWrite | QIODevice::Truncate) || ! m_file.resize(size) ) 
+   {
+      m_file.close();
+      return(false);
+   }
+
+   uchar *base = m_file.map(0, size);
+   if ( base == NULL ) 
+   {
+      m_file.close();
+      return(false);
+   }
+
+   m_header = (BinaryLog::FlightHeader*)base;
+   m_data = base + sizeof(BinaryLog::FlightHeader);
+   m_capacity = capacity;
+   m_sequence = 0;
+
+   memcpy(m_header->magic, BinaryLog::FLIGHT_MAGIC, sizeof(m_header->magic));
+   m_header->version = BinaryLog::FLIGHT_VERSION;
+   m_header->header_size = sizeof(BinaryLog::FlightHeader);
+   m_header->start_epoch_ms = QDateTime::currentMSecsSinceEpoch();
+   m_header->start_monotonic_ns = Logger::MonotonicNs();
+   m_header->capacity = m_capacity;
+   m_header->head = 0;
+   m_header->tail = 0;
+   return(true);
+}
+
+void FlightRecorder::Close()
+{
+   if ( m_header != NULL ) 
+   {
+      m_file.unmap((uchar*)m_header);
+      m_header = NULL;
+      m_data = NULL;
+   }
+   if ( m_file.isOpen() ) 
+   {
+      m_file.close();
+   }
+}
+
+/********************************************************************//*
+**   void FlightRecorder::Write(const LogRecord &rec)
+**   
+**   Copies  one  record  into  the  ring,  dropping  the  oldest
+**   records  to make room. Structured records are formatted since
+**   the format strings are not kept in the file.
+**   
+**   Returns N/A
+***********************************************************************/
+void FlightRecorder::Write(const LogRecord &rec)
+{
+   if ( m_header == NULL ) 
+   {
+      return;
+   }
+
+   QByteArray category;
+   QByteArray function;
+   QByteArray text;
+
+   if ( rec.isFormatted() ) 
+   {
+      text = rec.text.toUtf8();
+   }
+   else 
+   {
+      category = rec.category.toUtf8().left(0xffff);
+      function = rec.function.left(0xffff);
+      if ( rec.isStructured() ) 
+      {
+         m_text.resize(0);
+         Logger::FormatMessage(rec, m_text);
+         text = m_text.toUtf8();
+      }
+      else 
+      {
+         text = rec.message.toUtf8();
+      }
+   }
+
+   /***************************************************************/
+   /*   A single record may use at most a quarter of the ring so a  */
+   /*   runaway message does not wipe out everything before it.   */
+   /***************************************************************/
+   quint64 fixed = sizeof(BinaryLog::FlightRecord) + category.size() + function.size();
+   if ( fixed > m_capacity / 4 ) 
+   {
+      return;
+   }
+   else if ( fixed + text.size() > m_capacity / 4 ) 
+   {
+      text.truncate(m_capacity / 4 - fixed);
+   }
+   quint64 length = Align(fixed + text.size());
+
+   quint64 head = m_header->head;
+   quint64 offset = head % m_capacity;
+   if ( m_capacity - offset < length ) 
+   {
+      /************************************************************/
+      /*   Not  enough  room before the end of the ring, fill the   */
+      /*   rest with a pad record and start over at the beginning.  */
+      /************************************************************/
+      quint64 pad = m_capacity - offset;
+      Reserve(head + pad);
+
+      BinaryLog::FlightRecord *pad_rec = (BinaryLog::FlightRecord*)(m_data + offset);
+      pad_rec->marker = BinaryLog::FLIGHT_PAD_MARKER;
+      pad_rec->length = pad;
+      std::atomic_thread_fence(std::memory_order_release);
+      head += pad;
+      m_header->head = head;
+      offset = 0;
+   }
+   Reserve(head + length);
+
+   BinaryLog::FlightRecord *out = (BinaryLog::FlightRecord*)(m_data + offset);
+   out->marker = BinaryLog::FLIGHT_RECORD_MARKER;
+   out->length = length;
+   out->sequence = m_sequence++;
+   out->timestamp_ns = rec.monotonic;
+   out->thread_id = rec.threadId;
+   out->msg_type = (quint8)rec.type;
+   out->reserved = 0;
+   out->level = (quint16)rec.level;
+   out->category_length = category.size();
+   out->function_length = function.size();
+   out->text_length = text.size();
+
+   uchar *dest = m_data + offset + sizeof(BinaryLog::FlightRecord);
+   WriteBytes(dest, category);
+   dest += category.size();
+   WriteBytes(dest, function);
+   dest += function.size();
+   WriteBytes(dest, text);
+
+   /***************************************************************/
+   /*   The record must be complete before head moves past it, in   */
+   /*   case we are interrupted half way through.                  */
+   /***************************************************************/
+   std::atomic_thread_fence(std::memory_order_release);
+   m_header->head = head + length;
+}
+
+/********************************************************************//*
+**   void FlightRecorder::Reserve(quint64 end) private
+**   
+**   Moves  the  tail  past  the  oldest  records  until the ring can
+**   hold  everything  up to the absolute position end. The tail is
+**   updated before any of those records are overwritten.
+***********************************************************************/
+void FlightRecorder::Reserve(quint64 end)
+{
+   quint64 tail = m_header->tail;
+   while ( end - tail > m_capacity ) 
+   {
+      const BinaryLog::FlightRecord *old = (const BinaryLog::FlightRecord*)(m_data + tail % m_capacity);
+      tail += old->length;
+   }
+
+   if ( tail != m_header->tail ) 
+   {
+      m_header->tail = tail;
+      std::atomic_thread_fence(std::memory_order_release);
+   }
+}
+
+void FlightRecorder::WriteBytes(uchar *dest, const QByteArray &bytes)
+{
+   if ( ! bytes.isEmpty() ) 
+   {
+      memcpy(dest, bytes.constData(), bytes.size());
+   }
+}
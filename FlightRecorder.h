@@ -0,0 +1,84 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+# include <QByteArray>
+# include <QFile>
+# include <QString>
+
+# include "BinaryLogFormat.h"
+# include "LogRecord.h"
+
+namespace QcjLib
+{
+   /********************************************************************//*
+   **   class FlightRecorder
+   **   
+   **   Keeps  the  last  few  megabytes  of log records in a memory
+   **   mapped  file  laid  out  as  a  ring,  see BinaryLogFormat.h.
+   **   Writes  only  touch  the mapping, nothing is flushed, yet the
+   **   records  survive  the  process  crashing or aborting since the
+   **   pages  belong  to the operating system. Use LogDecode on the
+   **   file to get the records back in order.
+   **
+   **   Used  by  the  Logger for its flight recorder sink, the caller
+   **   is expected to serialize access.
+   ***********************************************************************/
+   class FlightRecorder
+   {
+   public:
+      FlightRecorder();
+      ~FlightRecorder();
+
+      bool Open(QString filename, qint64 capacity = DEFAULT_CAPACITY);
+      void Close();
+      void Write(const LogRecord &rec);
+
+      bool IsOpen() const
+      {
+         return(m_header != NULL);
+      }
+
+      static const qint64  DEFAULT_CAPACITY;
+      static const QString PREVIOUS_SUFFIX;
+
+   private:
+      void Reserve(quint64 end);
+      void WriteBytes(uchar *dest, const QByteArray &bytes);
+
+      QFile                      m_file;
+      BinaryLog::FlightHeader    *m_header;
+      uchar                      *m_data;
+      quint64                    m_capacity;
+      quint64                    m_sequence;
+      QString                    m_text;
+   };
+};
+
+#endif
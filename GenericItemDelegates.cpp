@@ -84,7 +84,7 @@ QWidget *GenericIntDelegate::createEditor(QWidget *parent, const QStyleOptionVie
 {
    QSpinBox *templ = dynamic_cast<QSpinBox*>(m_fieldData.widget);
    QSpinBox *editor = new QSpinBox(parent);
-   qDebug(*log(LOG, 1)) << "editor =" << (unsigned long)editor;
+   qcjDebug(LOG, 1) << "editor =" << (unsigned long)editor;
    editor->setMinimum(templ->minimum());
    editor->setMaximum(templ->maximum());
    editor->setSingleStep(templ->singleStep());
@@ -128,7 +128,7 @@ QWidget *GenericDoubleDelegate::createEditor(QWidget *parent, const QStyleOption
 {
    QDoubleSpinBox *templ = dynamic_cast<QDoubleSpinBox*>(m_fieldData.widget);
    QDoubleSpinBox *editor = new QDoubleSpinBox(parent);
-   qDebug(*log(LOG, 1)) << "editor =" << (unsigned long)editor;
+   qcjDebug(LOG, 1) << "editor =" << (unsigned long)editor;
    editor->setDecimals(templ->decimals());
    editor->setMinimum(templ->minimum());
    editor->setMaximum(templ->maximum());
@@ -172,7 +172,7 @@ GenericReadOnlyDelegate::GenericReadOnlyDelegate(const QcjDataFields &fieldData,
 QWidget *GenericReadOnlyDelegate::createEditor(QWidget *parent, const QStyleOptionViewItem &, const QModelIndex &) const
 {
    QLabel *editor = new QLabel(parent);
-   qDebug(*log(LOG, 1)) << "editor =" << (unsigned long)editor;
+   qcjDebug(LOG, 1) << "editor =" << (unsigned long)editor;
    connect(editor, SIGNAL(editingFinished()), this, SLOT(closeCommitEditor()), Qt::UniqueConnection);
    return(editor);
 }
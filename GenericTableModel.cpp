@@ -42,7 +42,7 @@ GenericTableModel::GenericTableModel(QObject *parent) :
 
 QStringList GenericTableModel::Headers() const
 {
-   qDebug(*log(LOG, 1)) << "Enter";
+   qcjDebug(LOG, 1) << "Enter";
    QMutexLocker locker(&m_lock);
    QStringList rv;
 
@@ -57,32 +57,32 @@ QStringList GenericTableModel::Headers() const
          qDebug() << "bad header";
       }
    }
-   qDebug(*log(LOG, 1)) << "Exit";
+   qcjDebug(LOG, 1) << "Exit";
    return(rv);
 }
 
 int GenericTableModel::FindColumn(QString col_name) const
 {
-   qDebug(*log(LOG, 1)) << "Enter- name: " << col_name;
+   qcjDebug(LOG, 1) << "Enter- name: " << col_name;
    QMutexLocker locker(&m_lock);
    int rv = -1;
-   qDebug(*log(LOG, 1))  << "columnCount = " << columnCount();
+   qcjDebug(LOG, 1)  << "columnCount = " << columnCount();
    for (rv = 0; rv < columnCount(); rv++) 
    {
-      qDebug(*log(LOG, 1))  << "Testing " << col_name << " against column header " << horizontalHeaderItem(rv)->text();
+      qcjDebug(LOG, 1)  << "Testing " << col_name << " against column header " << horizontalHeaderItem(rv)->text();
       if ( horizontalHeaderItem(rv)->text().toLower() == col_name.toLower() )
       {
-         qDebug(*log(LOG, 1))  << "found match- col_name: " << col_name << ", column = " << rv;
+         qcjDebug(LOG, 1)  << "found match- col_name: " << col_name << ", column = " << rv;
          break;
       }
    }
-   qDebug(*log(LOG, 1)) << "Exit";
+   qcjDebug(LOG, 1) << "Exit";
    return(rv);
 }
 
 int GenericTableModel::FindRow(QString col_name, QString value) const
 {
-   qDebug(*log(LOG, 1)) << "Enter";
+   qcjDebug(LOG, 1) << "Enter";
    QMutexLocker locker(&m_lock);
    int rv = -1;
    int col = FindColumn(col_name);
@@ -90,13 +90,13 @@ int GenericTableModel::FindRow(QString col_name, QString value) const
    {
       rv = FindRow(col, value);
    }
-   qDebug(*log(LOG, 1)) << "Exit";
+   qcjDebug(LOG, 1) << "Exit";
    return(rv);
 }
 
 int GenericTableModel::FindRow(int col, QString value) const
 {
-   qDebug(*log(LOG, 1)) << "Enter";
+   qcjDebug(LOG, 1) << "Enter";
    QMutexLocker locker(&m_lock);
    int rv = -1;
 
@@ -107,13 +107,13 @@ int GenericTableModel::FindRow(int col, QString value) const
          rv = row;
       }
    }
-   qDebug(*log(LOG, 1)) << "Exit";
+   qcjDebug(LOG, 1) << "Exit";
    return(rv);
 }
 
 VariantHash GenericTableModel::GetVariantRow(int row) const
 {
-   qDebug(*log(LOG, 1)) << "Enter";
+   qcjDebug(LOG, 1) << "Enter";
    QMutexLocker locker(&m_lock);
    VariantHash rv;
 
@@ -125,13 +125,13 @@ VariantHash GenericTableModel::GetVariantRow(int row) const
       qDebug() << "Value: " << Value(row, field);
       rv.insert(field, QVariant(Value(row, field)));
    }
-   qDebug(*log(LOG, 1)) << "Exit";
+   qcjDebug(LOG, 1) << "Exit";
    return(rv);
 }
 
 GenericTableModel::ModelRow_t GenericTableModel::GetRow(int row) const
 {
-   qDebug(*log(LOG, 1)) << "Enter";
+   qcjDebug(LOG, 1) << "Enter";
    QMutexLocker locker(&m_lock);
    ModelRow_t rv;
 
@@ -140,97 +140,97 @@ GenericTableModel::ModelRow_t GenericTableModel::GetRow(int row) const
    {
       rv.insert(field, Value(row, field));
    }
-   qDebug(*log(LOG, 1)) << "Exit";
+   qcjDebug(LOG, 1) << "Exit";
    return(rv);
 }
 
 int GenericTableModel::AddColumn(QString col_name, QString data_name)
 {
-   qDebug(*log(LOG, 1)) << "Enter";
+   qcjDebug(LOG, 1) << "Enter";
    QMutexLocker locker(&m_lock);
    QRegExp re(": *$");
    col_name = col_name.replace(re, "");
    int rv = FindColumn(col_name);
    if ( rv < 0 ) 
    {
-      qDebug(*log(LOG, 1))  << "New column, setting the new colCount()";
+      qcjDebug(LOG, 1)  << "New column, setting the new colCount()";
       rv = columnCount();
       setColumnCount(rv + 1);
    }
-   qDebug(*log(LOG, 1))  << "Adding column named " << col_name << " to column " << rv;
+   qcjDebug(LOG, 1)  << "Adding column named " << col_name << " to column " << rv;
    QStandardItem *hdr_item = new QStandardItem(col_name);
    hdr_item->setData(QVariant(data_name));
    setHorizontalHeaderItem(rv, hdr_item);
-   qDebug(*log(LOG, 1)) << "Exit";
+   qcjDebug(LOG, 1) << "Exit";
    return(rv);
 }
 
 int GenericTableModel::AddColumn(int row, QString col_name, QString text, QString data_name)
 {
-   qDebug(*log(LOG, 1)) << "Enter";
+   qcjDebug(LOG, 1) << "Enter";
    QMutexLocker locker(&m_lock);
-   qDebug(*log(LOG, 1))  << "Adding column with data " << col_name;
+   qcjDebug(LOG, 1)  << "Adding column with data " << col_name;
    int rv = AddColumn(col_name, data_name);
-   qDebug(*log(LOG, 1))  << "Adding to column " << rv << ", row " << row;
+   qcjDebug(LOG, 1)  << "Adding to column " << rv << ", row " << row;
    SetValue(row, rv, text);
-   qDebug(*log(LOG, 1)) << "Exit";
+   qcjDebug(LOG, 1) << "Exit";
    return(rv);
 }
 
 bool GenericTableModel::RemoveColumn(QString col_name)
 {
-   qDebug(*log(LOG, 1)) << "Enter";
+   qcjDebug(LOG, 1) << "Enter";
    QMutexLocker locker(&m_lock);
    int idx = FindColumn(col_name);
-   qDebug(*log(LOG, 1))  << "Removing column " << col_name << ", column num: " << idx;
-   qDebug(*log(LOG, 1)) << "Exit";
+   qcjDebug(LOG, 1)  << "Removing column " << col_name << ", column num: " << idx;
+   qcjDebug(LOG, 1) << "Exit";
    return(removeColumns(idx, 1));
 }
 
 void GenericTableModel::SetValue(int row, QString col_name, QString text)
 {
-   qDebug(*log(LOG, 1)) << "Enter";
+   qcjDebug(LOG, 1) << "Enter";
    QMutexLocker locker(&m_lock);
    int col = FindColumn(col_name);
-//   qDebug(*log(LOG, 1))  << "1 Enter col_name = " << col_name << ", col = " << col << ", row = " << row;
+//   qcjDebug(LOG, 1)  << "1 Enter col_name = " << col_name << ", col = " << col << ", row = " << row;
    SetValue(row, col, text);
 }
 
 void GenericTableModel::SetValue(int row, int col, QString text)
 {
-   qDebug(*log(LOG, 1))  << "2 Enter row = " << row << ", col = " << col << ", text = " << text;
+   qcjDebug(LOG, 1)  << "2 Enter row = " << row << ", col = " << col << ", text = " << text;
 //   QMutexLocker locker(&m_lock);
-   qDebug(*log(LOG, 1))  << "have lock";
+   qcjDebug(LOG, 1)  << "have lock";
    QStandardItem *item = new QStandardItem(text);
    Qt::Alignment align = static_cast<Qt::Alignment>(data(index(row, col), Qt::TextAlignmentRole).toInt());
-   qDebug(*log(LOG, 1)) << "Alignment = " << align;
+   qcjDebug(LOG, 1) << "Alignment = " << align;
    item->setTextAlignment(align);
    setItem(row, col, item);
 }
 
 QString GenericTableModel::Value(int row, QString col_name) const
 {
-   qDebug(*log(LOG, 1)) << "Enter";
+   qcjDebug(LOG, 1) << "Enter";
    QMutexLocker locker(&m_lock);
    int col = FindColumn(col_name);
-   qDebug(*log(LOG, 1))  << "3 Enter row = " << row << ", col_name = " << col_name << ", col = " << col << ", rowCount() " << rowCount();
-   qDebug(*log(LOG, 1)) << "Exit";
+   qcjDebug(LOG, 1)  << "3 Enter row = " << row << ", col_name = " << col_name << ", col = " << col << ", rowCount() " << rowCount();
+   qcjDebug(LOG, 1) << "Exit";
    return(Value(row, col));
 }
 
 QString GenericTableModel::Value(int row, int col) const
 {
-   qDebug(*log(LOG, 1)) << "Enter";
+   qcjDebug(LOG, 1) << "Enter";
    QMutexLocker locker(&m_lock);
    QStandardItem *val_item = item(row, col);
    if ( val_item != NULL ) 
    {
-      qDebug(*log(LOG, 1)) << "Exit";
+      qcjDebug(LOG, 1) << "Exit";
       return(item(row, col)->text());
    }
    else 
    {
-      qDebug(*log(LOG, 1)) << "Exit";
+      qcjDebug(LOG, 1) << "Exit";
       return(QString("empty"));
    }
 }
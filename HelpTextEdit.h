@@ -55,7 +55,7 @@ namespace QcjLib
 
       void initialize()
       {
-         qDebug(*QcjLib::log(LOG, 1)) << __FUNCTION__ << "have properties: " << dynamicPropertyNames();
+         qcjDebug(LOG, 1) << __FUNCTION__ << "have properties: " << dynamicPropertyNames();
          const QDomNode& help_node = QDomNode();
          QVariant help_property = property("help_resource");
          QString help_block = help_property.toString();
@@ -66,9 +66,9 @@ namespace QcjLib
             help_block = sl[1];
          }
 
-         qDebug(*QcjLib::log(LOG, 1)) << __FUNCTION__ << "help_property = " << help_property;
-         qDebug(*QcjLib::log(LOG, 1)) << __FUNCTION__ << "resource_name = " << resource_name;
-         qDebug(*QcjLib::log(LOG, 1)) << __FUNCTION__ << "help_block = " << help_block;
+         qcjDebug(LOG, 1) << __FUNCTION__ << "help_property = " << help_property;
+         qcjDebug(LOG, 1) << __FUNCTION__ << "resource_name = " << resource_name;
+         qcjDebug(LOG, 1) << __FUNCTION__ << "help_block = " << help_block;
 
          if ( ! m_helpMap.contains(resource_name) ) 
          {
@@ -91,7 +91,7 @@ namespace QcjLib
                                              );
                      exit(0);
                   }
-                  qDebug(*QcjLib::log(LOG, 1)) << __FUNCTION__ << __FUNCTION__ << "help file parsed!";
+                  qcjDebug(LOG, 1) << __FUNCTION__ << __FUNCTION__ << "help file parsed!";
                }
                else 
                {
@@ -102,7 +102,7 @@ namespace QcjLib
             }
             else 
             {
-               qDebug(*QcjLib::log(LOG, 1)) << __FUNCTION__ << "No Config file found!! name: " << resource_name;
+               qcjDebug(LOG, 1) << __FUNCTION__ << "No Config file found!! name: " << resource_name;
             }
             m_helpMap.insert(resource_name, doc);
          }
@@ -113,23 +113,23 @@ namespace QcjLib
          while ( !n1.isNull() ) 
          {
             QDomElement e1 = n1.toElement();
-            qDebug(*QcjLib::log(LOG, 1)) << __FUNCTION__ << "Found tagName: " << e1.tagName();
+            qcjDebug(LOG, 1) << __FUNCTION__ << "Found tagName: " << e1.tagName();
             
             if ( ! e1.isNull() && e1.tagName() == "help" )
             {
                if ( e1.hasAttribute("name") )
                {
-                  qDebug(*QcjLib::log(LOG, 1)) << __FUNCTION__ << "Found name: " << e1.attribute("name");
+                  qcjDebug(LOG, 1) << __FUNCTION__ << "Found name: " << e1.attribute("name");
                   QString name = e1.attribute("name");
                   if ( name == help_block ) 
                   {
-                     qDebug(*QcjLib::log(LOG, 1)) << __FUNCTION__ << "Found help block!";
-                     qDebug(*QcjLib::log(LOG, 1)) << __FUNCTION__ << "node type = " << n1.nodeType();
+                     qcjDebug(LOG, 1) << __FUNCTION__ << "Found help block!";
+                     qcjDebug(LOG, 1) << __FUNCTION__ << "node type = " << n1.nodeType();
 
                      QDomNode textNode = n1.firstChild();
                      if ( textNode.isText() ) 
                      {
-                        qDebug(*QcjLib::log(LOG, 1)) << __FUNCTION__ << "Found text node: " << n1.nodeValue();
+                        qcjDebug(LOG, 1) << __FUNCTION__ << "Found text node: " << n1.nodeValue();
                         setText(textNode.nodeValue());
                      }
                   }
@@ -37,12 +37,19 @@ namespace QcjLib
    class LogBuilder 
    {
    public:
-      LogBuilder(QString cat_name, unsigned int levels = 1, QString description = QString())
+      LogBuilder(QString cat_name, unsigned int levels = 1, QString description = QString()) :
+         m_name(cat_name)
       {
          LogRegistery::instance()->RegisterLog(cat_name, levels, description);
       }
 
+      LogHandle Handle(unsigned int level = 1) const
+      {
+         return(LogHandle(m_name, level));
+      }
+
    private:
+      QString  m_name;
    protected:
    };
 }
@@ -0,0 +1,449 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+/********************************************************************//*
+**   @file LogDecode.cpp
+**   
+**   PROJECT QcjLib
+**   
+**   Description:  Command  line  tool converting a binary log file
+**   written  by  Logger::SetBinaryLogFile()  back into the Logger's
+**   text  format.  The  file is memory mapped and streamed through
+**   record by record, so its size is not limited by memory.
+**
+**   It  also  extracts  the  records  of  a flight recorder file
+**   written  by  Logger::SetFlightRecorderFile(),  oldest  first,
+**   for instance after the application crashed.
+**
+**   Usage: LogDecode [options] <file>
+**
+**   --category <names>   Only show these comma separated logs
+**   --level <n>          Only show messages at level n or below
+**   --from <time>        Only show messages at or after time
+**   --to <time>          Only show messages at or before time
+**   --output <file>      Write to file instead of stdout
+**
+**   Times are either ISO date/times or hh:mm:ss on the day the log
+**   was started.
+***********************************************************************/
+# include "../BinaryLogFormat.h"
+# include "../Logger.h"
+
+# include <QCommandLineParser>
+# include <QCoreApplication>
+# include <QDateTime>
+# include <QFile>
+# include <QHash>
+# include <QSet>
+# include <QStringList>
+# include <QTextStream>
+
+# include <limits.h>
+# include <stdio.h>
+# include <string.h>
+
+using namespace QcjLib;
+
+/********************************************************************//*
+**   The record selection given on the command line.
+***********************************************************************/
+struct RecordFilter
+{
+   bool Accept(const LogRecord &rec) const
+   {
+      return(rec.level <= max_level &&
+             rec.timestamp >= from_ms && rec.timestamp <= to_ms &&
+             (categories.isEmpty() || categories.contains(rec.category)));
+   }
+
+   QSet<QString>  categories;
+   unsigned int   max_level;
+   qint64         from_ms;
+   qint64         to_ms;
+};
+
+/********************************************************************//*
+**   static int DecodeFlight(const uchar *base, qint64 size, 
+**                           const RecordFilter &filter, QTextStream &stream)
+**   
+**   Writes  the records of a mapped flight recorder file from its
+**   tail  up  to  its  head.  Anything  that does not look like a
+**   complete record ends the walk, as the file may have been cut
+**   short by a crash.
+**   
+**   Returns the exit code of the tool.
+***********************************************************************/
+static int DecodeFlight(const uchar *base, qint64 size, const RecordFilter &filter, QTextStream &stream)
+{
+   BinaryLog::FlightHeader hdr;
+   memcpy(&hdr, base, sizeof(hdr));
+   if ( hdr.version < 1 || hdr.version > BinaryLog::FLIGHT_VERSION || hdr.capacity == 0 ||
+        (qint64)(hdr.header_size + hdr.capacity) > size || hdr.head < hdr.tail ||
+        hdr.head - hdr.tail > hdr.capacity ) 
+   {
+      fprintf(stderr, "Flight recorder header is damaged\n");
+      return(1);
+   }
+
+   const uchar *data = base + hdr.header_size;
+   QString line;
+   quint64 pos = hdr.tail;
+   while ( pos < hdr.head ) 
+   {
+      quint64 offset = pos % hdr.capacity;
+      BinaryLog::FlightRecord fr;
+      memset(&fr, 0, sizeof(fr));
+      memcpy(&fr, data + offset, qMin((quint64)sizeof(fr), hdr.capacity - offset));
+
+      if ( fr.length == 0 || fr.length % BinaryLog::FLIGHT_ALIGN != 0 || offset + fr.length > hdr.capacity ) 
+      {
+         fprintf(stderr, "Damaged record at offset %llu, stopping\n", (unsigned long long)offset);
+         break;
+      }
+      pos += fr.length;
+      if ( fr.marker == BinaryLog::FLIGHT_PAD_MARKER ) 
+      {
+         continue;
+      }
+      else if ( fr.marker != BinaryLog::FLIGHT_RECORD_MARKER || 
+                sizeof(fr) + fr.category_length + fr.function_length + fr.text_length > fr.length ) 
+      {
+         fprintf(stderr, "Damaged record at offset %llu, stopping\n", (unsigned long long)offset);
+         break;
+      }
+
+      const char *str = (const char*)data + offset + sizeof(fr);
+      QByteArray function(str + fr.category_length, fr.function_length);
+
+      LogRecord rec;
+      rec.type = (QtMsgType)fr.msg_type;
+      rec.level = fr.level;
+      rec.threadId = fr.thread_id;
+      rec.monotonic = fr.timestamp_ns;
+      rec.timestamp = hdr.start_epoch_ms + (fr.timestamp_ns - hdr.start_monotonic_ns) / 1000000;
+
+      QString text = QString::fromUtf8(str + fr.category_length + fr.function_length, fr.text_length);
+      if ( fr.category_length == 0 && fr.function_length == 0 ) 
+      {
+         rec.text = text;
+      }
+      else 
+      {
+         rec.category = QString::fromUtf8(str, fr.category_length);
+         rec.function = function;
+         rec.message = text;
+      }
+
+      if ( ! filter.Accept(rec) ) 
+      {
+         continue;
+      }
+
+      line.resize(0);
+      Logger::FormatRecord(rec, line);
+      stream << line;
+   }
+   stream.flush();
+   return(0);
+}
+
+static qint64 ParseTime(QString str, const QDateTime &start)
+{
+   QDateTime dt = QDateTime::fromString(str, Qt::ISODate);
+   if ( ! dt.isValid() ) 
+   {
+      QTime tm = QTime::fromString(str, "hh:mm:ss");
+      if ( ! tm.isValid() ) 
+      {
+         return(-1);
+      }
+      dt = QDateTime(start.date(), tm);
+   }
+   return(dt.toMSecsSinceEpoch());
+}
+
+int main(int argc, char **argv)
+{
+   QCoreApplication app(argc, argv);
+   QCoreApplication::setApplicationName("LogDecode");
+
+   QCommandLineParser parser;
+   parser.setApplicationDescription("Converts a QcjLib binary log or flight recorder file to text");
+   parser.addHelpOption();
+   parser.addPositionalArgument("file", "Binary log or flight recorder file to decode");
+   QCommandLineOption category_opt("category", "Only show these comma separated logs.", "names");
+   QCommandLineOption level_opt("level", "Only show messages at this level or below.", "n");
+   QCommandLineOption from_opt("from", "Only show messages at or after this time.", "time");
+   QCommandLineOption to_opt("to", "Only show messages at or before this time.", "time");
+   QCommandLineOption output_opt("output", "Write to this file instead of stdout.", "file");
+   parser.addOption(category_opt);
+   parser.addOption(level_opt);
+   parser.addOption(from_opt);
+   parser.addOption(to_opt);
+   parser.addOption(output_opt);
+   parser.process(app);
+
+   if ( parser.positionalArguments().count() != 1 ) 
+   {
+      parser.showHelp(1);
+   }
+
+   QFile in(parser.positionalArguments().first());
+   if ( ! in.open(QIODevice::ReadOnly) ) 
+   {
+      fprintf(stderr, "Could not open %s\n", qPrintable(in.fileName()));
+      return(1);
+   }
+
+   qint64 size = in.size();
+   const uchar *base = in.map(0, size);
+   if ( base == NULL || size < (qint64)sizeof(BinaryLog::FileHeader) ) 
+   {
+      fprintf(stderr, "Could not map %s\n", qPrintable(in.fileName()));
+      return(1);
+   }
+
+   BinaryLog::FileHeader hdr;
+   memcpy(&hdr, base, sizeof(hdr));
+   bool is_flight = (memcmp(hdr.magic, BinaryLog::FLIGHT_MAGIC, sizeof(hdr.magic)) == 0 && 
+                     size >= (qint64)sizeof(BinaryLog::FlightHeader));
+   if ( ! is_flight && 
+        (memcmp(hdr.magic, BinaryLog::MAGIC, sizeof(hdr.magic)) != 0 || 
+         hdr.version < 1 || hdr.version > BinaryLog::VERSION) ) 
+   {
+      fprintf(stderr, "%s is not a binary log file\n", qPrintable(in.fileName()));
+      return(1);
+   }
+
+   QFile out;
+   if ( parser.isSet(output_opt) ) 
+   {
+      out.setFileName(parser.value(output_opt));
+      if ( ! out.open(QIODevice::WriteOnly) ) 
+      {
+         fprintf(stderr, "Could not create %s\n", qPrintable(out.fileName()));
+         return(1);
+      }
+   }
+   else 
+   {
+      out.open(stdout, QIODevice::WriteOnly);
+   }
+   QTextStream stream(&out);
+
+   /***************************************************************/
+   /*   Both headers start with the magic, version, header size    */
+   /*   and start times, so hdr is good for those either way.      */
+   /***************************************************************/
+   QDateTime start = QDateTime::fromMSecsSinceEpoch(hdr.start_epoch_ms);
+   RecordFilter filter;
+   filter.max_level = parser.isSet(level_opt) ? parser.value(level_opt).toUInt() : UINT_MAX;
+   filter.from_ms = parser.isSet(from_opt) ? ParseTime(parser.value(from_opt), start) : LLONG_MIN;
+   filter.to_ms = parser.isSet(to_opt) ? ParseTime(parser.value(to_opt), start) : LLONG_MAX;
+   if ( parser.isSet(category_opt) ) 
+   {
+      foreach (QString name, parser.value(category_opt).split(",", Qt::SkipEmptyParts))
+      {
+         filter.categories.insert(name.trimmed());
+      }
+   }
+
+   if ( is_flight ) 
+   {
+      return(DecodeFlight(base, size, filter, stream));
+   }
+
+   QHash<quint32, QString>    category_names;
+   QHash<quint32, QByteArray> function_names;
+   QHash<quint32, QByteArray> format_strings;
+   QHash<quint32, QByteArray> key_names;
+   QString line;
+
+   qint64 pos = hdr.header_size;
+   while ( pos < size ) 
+   {
+      quint8 kind = base[pos];
+      if ( kind == BinaryLog::KindString ) 
+      {
+         BinaryLog::StringRecord str;
+         if ( pos + (qint64)sizeof(str) > size ) 
+         {
+            break;
+         }
+         memcpy(&str, base + pos, sizeof(str));
+         pos += sizeof(str);
+         if ( pos + str.length > size ) 
+         {
+            break;
+         }
+
+         QByteArray text((const char*)base + pos, str.length);
+         if ( str.string_kind == BinaryLog::StringCategory ) 
+         {
+            category_names.insert(str.id, QString::fromUtf8(text));
+         }
+         else if ( str.string_kind == BinaryLog::StringFormat ) 
+         {
+            format_strings.insert(str.id, text);
+         }
+         else if ( str.string_kind == BinaryLog::StringKey ) 
+         {
+            key_names.insert(str.id, text);
+         }
+         else 
+         {
+            function_names.insert(str.id, text);
+         }
+         pos += str.length;
+      }
+      else if ( kind == BinaryLog::KindMessage ) 
+      {
+         BinaryLog::MessageRecord msg;
+         if ( pos + (qint64)sizeof(msg) > size ) 
+         {
+            break;
+         }
+         memcpy(&msg, base + pos, sizeof(msg));
+         pos += sizeof(msg);
+         if ( pos + msg.length > size ) 
+         {
+            break;
+         }
+
+         LogRecord rec;
+         rec.type = (QtMsgType)msg.msg_type;
+         rec.level = msg.level;
+         rec.threadId = msg.thread_id;
+         rec.monotonic = msg.timestamp_ns;
+         rec.timestamp = hdr.start_epoch_ms + (msg.timestamp_ns - hdr.start_monotonic_ns) / 1000000;
+
+         QString text = QString::fromUtf8((const char*)base + pos, msg.length);
+         pos += msg.length;
+
+         if ( msg.category_id == 0 && msg.function_id == 0 ) 
+         {
+            rec.text = text;
+         }
+         else 
+         {
+            rec.category = category_names.value(msg.category_id);
+            rec.message = text;
+            QHash<quint32, QByteArray>::const_iterator fn = function_names.constFind(msg.function_id);
+            rec.function = (fn != function_names.constEnd()) ? fn.value() : QByteArray();
+         }
+
+         if ( ! filter.Accept(rec) ) 
+         {
+            continue;
+         }
+
+         line.resize(0);
+         Logger::FormatRecord(rec, line);
+         stream << line;
+      }
+      else if ( kind == BinaryLog::KindStructured ) 
+      {
+         BinaryLog::StructuredRecord msg;
+         if ( pos + (qint64)sizeof(msg) > size ) 
+         {
+            break;
+         }
+         memcpy(&msg, base + pos, sizeof(msg));
+         pos += sizeof(msg);
+
+         LogRecord rec;
+         rec.type = (QtMsgType)msg.msg_type;
+         rec.level = msg.level;
+         rec.threadId = msg.thread_id;
+         rec.monotonic = msg.timestamp_ns;
+         rec.timestamp = hdr.start_epoch_ms + (msg.timestamp_ns - hdr.start_monotonic_ns) / 1000000;
+         rec.category = category_names.value(msg.category_id);
+
+         /***********************************************/
+         /*   The strings live in the hashes, which     */
+         /*   are not changed while rec is in use.      */
+         /***********************************************/
+         QHash<quint32, QByteArray>::const_iterator fn = function_names.constFind(msg.function_id);
+         rec.function = (fn != function_names.constEnd()) ? fn.value() : QByteArray();
+         QHash<quint32, QByteArray>::const_iterator fmt = format_strings.constFind(msg.format_id);
+         rec.format = (fmt != format_strings.constEnd()) ? fmt.value().constData() : "";
+
+         bool complete = true;
+         for (quint32 x = 0; x < msg.arg_count && complete; x++) 
+         {
+            BinaryLog::ArgRecord ar;
+            if ( pos + (qint64)sizeof(ar) > size ) 
+            {
+               complete = false;
+               break;
+            }
+            memcpy(&ar, base + pos, sizeof(ar));
+            pos += sizeof(ar);
+
+            LogArg arg;
+            arg.type = ar.type;
+            QHash<quint32, QByteArray>::const_iterator key = key_names.constFind(ar.key_id);
+            arg.key = (key != key_names.constEnd()) ? key.value().constData() : NULL;
+            if ( ar.type == LogArg::String ) 
+            {
+               if ( pos + (qint64)ar.value > size ) 
+               {
+                  complete = false;
+                  break;
+               }
+               arg.str = QString::fromUtf8((const char*)base + pos, (int)ar.value);
+               pos += ar.value;
+            }
+            else 
+            {
+               memcpy(&arg.i, &ar.value, sizeof(ar.value));
+            }
+            rec.args.append(arg);
+         }
+         if ( ! complete ) 
+         {
+            break;
+         }
+
+         if ( ! filter.Accept(rec) ) 
+         {
+            continue;
+         }
+
+         line.resize(0);
+         Logger::FormatRecord(rec, line);
+         stream << line;
+      }
+      else 
+      {
+         fprintf(stderr, "Unknown record kind %d at offset %lld, stopping\n", kind, (long long)pos);
+         break;
+      }
+   }
+   stream.flush();
+   return(0);
+}
@@ -36,6 +36,8 @@
 #include <iostream>
 
 # include "Logger.h"
+# include "LogViewModel.h"
+# include "StallDetector.h"
 
 using namespace QcjLib;
 
@@ -58,15 +60,43 @@ void LogDialog::accept()
       Logger::instance()->SetLogFile("");
    }
 
+   /***************************************************************/
+   /*   Only restart the database sink if its settings changed.    */
+   /***************************************************************/
+   QSettings db_settings;
+   bool db_enable = m_ui.databaseCheckBox->isChecked();
+   bool db_changed = db_enable != db_settings.value(QcjLib::LOG_DB_ENABLE, false).toBool() ||
+                     m_ui.databaseNameEdit->text() != db_settings.value(QcjLib::LOG_DB_NAME).toString() ||
+                     m_ui.retentionSpinBox->value() != db_settings.value(QcjLib::LOG_DB_RETENTION, 0).toInt();
+   if ( valid && db_changed ) 
+   {
+      if ( ! db_enable ) 
+      {
+         Logger::instance()->SetDatabaseLogFile("");
+      }
+      else if ( ! Logger::instance()->SetDatabaseLogFile(m_ui.databaseNameEdit->text(), m_ui.retentionSpinBox->value()) ) 
+      {
+         QMessageBox::critical(NULL, "Error Opening Log Database", "Database '" 
+                                   + m_ui.databaseNameEdit->text()
+                                   + " could not be opened");
+         valid = false;
+      }
+   }
+
    if ( valid ) 
    {
       Logger::instance()->EnableConsole(m_ui.consoleCheckBox->isChecked());
+      m_ui.logQueryWidget->SetDatabaseName(db_enable ? m_ui.databaseNameEdit->text() : QString());
+      LogViewModel::Attach(m_ui.viewCheckBox->isChecked());
 
       QSettings settings;
       settings.setValue(QcjLib::LOG_CONSOLE_ENABLE, m_ui.consoleCheckBox->isChecked());
       settings.setValue(QcjLib::LOG_VIEW_ENABLE,    m_ui.viewCheckBox->isChecked());
       settings.setValue(QcjLib::LOG_FILE_ENABLE,    m_ui.fileCheckBox->isChecked());
       settings.setValue(QcjLib::LOG_FILE_NAME,      m_ui.fileNameEdit->text());
+      settings.setValue(QcjLib::LOG_DB_ENABLE,      db_enable);
+      settings.setValue(QcjLib::LOG_DB_NAME,        m_ui.databaseNameEdit->text());
+      settings.setValue(QcjLib::LOG_DB_RETENTION,   m_ui.retentionSpinBox->value());
 
       qDebug() << __FUNCTION__ << "Saving settings";
       m_ui.logTableWidget->ApplySettings();
@@ -91,13 +121,57 @@ void LogDialog::SlotBrowseFiles()
 void LogDialog::InitializeLogger()
 {
    QSettings settings;
+   Logger::instance()->SetRotationPolicy(settings.value(QcjLib::LOG_ROTATE_MAX_BYTES, 0).toLongLong(),
+                                         settings.value(QcjLib::LOG_ROTATE_MAX_AGE, 0).toInt(),
+                                         settings.value(QcjLib::LOG_ROTATE_KEEP, 0).toInt(),
+                                         settings.value(QcjLib::LOG_ROTATE_COMPRESS, false).toBool());
    if ( settings.value(QcjLib::LOG_FILE_ENABLE, true).toBool() )
    {
       Logger::instance()->SetLogFile(settings.value(QcjLib::LOG_FILE_NAME, "").toString());
    }
 
+   QString binary_file = settings.value(QcjLib::LOG_BINARY_FILE_NAME, "").toString();
+   if ( ! binary_file.isEmpty() ) 
+   {
+      Logger::instance()->SetBinaryLogFile(binary_file);
+   }
+
+   if ( settings.value(QcjLib::LOG_DB_ENABLE, false).toBool() ) 
+   {
+      Logger::instance()->SetDatabaseLogFile(settings.value(QcjLib::LOG_DB_NAME, "").toString(),
+                                             settings.value(QcjLib::LOG_DB_RETENTION, 0).toInt());
+   }
+
+   QString flight_file = settings.value(QcjLib::LOG_FLIGHT_FILE_NAME, "").toString();
+   if ( ! flight_file.isEmpty() ) 
+   {
+      Logger::instance()->SetFlightRecorderFile(flight_file, 
+                                                settings.value(QcjLib::LOG_FLIGHT_SIZE, FlightRecorder::DEFAULT_CAPACITY).toLongLong());
+   }
+
    bool console_enable = settings.value(QcjLib::LOG_CONSOLE_ENABLE, true).toBool();
    std::cout << "console_enable: " << (int)console_enable << std::endl;
    Logger::instance()->EnableConsole(console_enable);
-}
 
+   Logger::instance()->SetEntryBatching(settings.value(QcjLib::LOG_VIEW_BATCH_SIZE, Logger::DEFAULT_BATCH_SIZE).toInt(),
+                                        settings.value(QcjLib::LOG_VIEW_BATCH_MS, Logger::DEFAULT_BATCH_INTERVAL_MS).toInt());
+
+   if ( isViewEnabled() ) 
+   {
+      LogViewModel::instance()->SetCapacity(settings.value(QcjLib::LOG_VIEW_CAPACITY, LogViewModel::DEFAULT_CAPACITY).toInt());
+      LogViewModel::Attach(true);
+   }
+
+   if ( settings.value(QcjLib::LOG_ASYNC_ENABLE, false).toBool() ) 
+   {
+      int queue_size = settings.value(QcjLib::LOG_ASYNC_QUEUE_SIZE, Logger::DEFAULT_QUEUE_SIZE).toInt();
+      QString overflow = settings.value(QcjLib::LOG_ASYNC_OVERFLOW, "block").toString();
+      Logger::instance()->SetAsync(true, queue_size, Logger::OverflowPolicyFromString(overflow));
+   }
+
+   int stall_threshold = settings.value(QcjLib::STALL_THRESHOLD_MS, 0).toInt();
+   if ( stall_threshold > 0 ) 
+   {
+      StallDetector::instance()->Start(stall_threshold);
+   }
+}
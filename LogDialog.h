@@ -58,6 +58,9 @@ namespace QcjLib
          m_ui.viewCheckBox->setChecked(settings.value(LOG_VIEW_ENABLE, true).toBool());
          m_ui.fileCheckBox->setChecked(settings.value(LOG_FILE_ENABLE, true).toBool());
          m_ui.fileNameEdit->setText(settings.value(LOG_FILE_NAME, "./app.log").toString());
+         m_ui.databaseCheckBox->setChecked(settings.value(LOG_DB_ENABLE, false).toBool());
+         m_ui.databaseNameEdit->setText(settings.value(LOG_DB_NAME, "./app-log.db").toString());
+         m_ui.retentionSpinBox->setValue(settings.value(LOG_DB_RETENTION, 0).toInt());
          std::cout << "here" << std::endl;
       }
 
@@ -0,0 +1,273 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef LOGHANDLE_H
+#define LOGHANDLE_H
+
+# include <QLoggingCategory>
+# include <QString>
+# include <QVector>
+
+# include "LogRecord.h"
+
+#include <atomic>
+#include <chrono>
+
+namespace QcjLib
+{
+   typedef QVector<QLoggingCategory*> LogCategoryList_t;
+
+   /********************************************************************//*
+   **   struct LogLimits
+   **   
+   **   How  much  of  a log's output is let through. rate is the
+   **   number  of  messages  per  second  allowed  on  average,  with
+   **   bursts  of up to burst messages, and sample keeps only one in
+   **   every  sample  messages.  Zero  for rate or sample means no
+   **   limit.
+   ***********************************************************************/
+   struct LogLimits
+   {
+      LogLimits() :
+         rate(0),
+         burst(0),
+         sample(0)
+      {}
+
+      bool IsLimited() const
+      {
+         return(rate > 0 || sample > 1);
+      }
+
+      unsigned int   rate;
+      unsigned int   burst;
+      unsigned int   sample;
+   };
+
+   /********************************************************************//*
+   **   struct LogDescriptor
+   **   
+   **   Per  log  state  owned  by  the LogRegistery. Descriptors are
+   **   created  once  and  never  freed,  so handles may keep plain
+   **   pointers to them. The current level is kept in an atomic so
+   **   it can be tested without going through the registry. The
+   **   category  list  is  replaced,  never  modified, when the log
+   **   is registered.
+   ***********************************************************************/
+   struct LogDescriptor
+   {
+      LogDescriptor(QString log_name, unsigned int log_level = 1) :
+         name(log_name),
+         level(log_level),
+         sinks(LogSinkAll),
+         categories(new LogCategoryList_t()),
+         rateLimit(0),
+         rateBurst(0),
+         sampleEvery(0),
+         rateTat(0),
+         sampleCount(0),
+         suppressed(0),
+         lastSummary(0)
+      {}
+
+      static qint64 Now()
+      {
+         return(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count());
+      }
+
+      /***********************************************/
+      /*   Decides whether a message that passed    */
+      /*   the level test is kept. Sampling keeps   */
+      /*   every sampleEvery'th message, the rate   */
+      /*   limit is a GCRA token bucket. Dropped    */
+      /*   messages are counted in suppressed.      */
+      /***********************************************/
+      bool Admit(qint64 now)
+      {
+         unsigned int every = sampleEvery.load(std::memory_order_relaxed);
+         unsigned int rate = rateLimit.load(std::memory_order_relaxed);
+         if ( every <= 1 && rate == 0 ) 
+            return(true);
+
+         if ( every > 1 && sampleCount.fetch_add(1, std::memory_order_relaxed) % every != 0 ) 
+         {
+            suppressed.fetch_add(1, std::memory_order_relaxed);
+            return(false);
+         }
+
+         if ( rate > 0 ) 
+         {
+            qint64 interval = 1000000000LL / rate;
+            qint64 tolerance = interval * qMax(rateBurst.load(std::memory_order_relaxed), 1u);
+            qint64 tat = rateTat.load(std::memory_order_relaxed);
+            qint64 new_tat;
+            do
+            {
+               new_tat = qMax(tat, now) + interval;
+               if ( new_tat - now > tolerance ) 
+               {
+                  suppressed.fetch_add(1, std::memory_order_relaxed);
+                  return(false);
+               }
+            } while ( ! rateTat.compare_exchange_weak(tat, new_tat, std::memory_order_relaxed) );
+         }
+         return(true);
+      }
+
+      /***********************************************/
+      /*   True, once per SUMMARY_INTERVAL_NS, if    */
+      /*   messages have been suppressed. The       */
+      /*   caller then logs the summary.            */
+      /***********************************************/
+      bool SummaryDue(qint64 now)
+      {
+         if ( suppressed.load(std::memory_order_relaxed) == 0 ) 
+            return(false);
+
+         qint64 last = lastSummary.load(std::memory_order_relaxed);
+         return(now - last >= SUMMARY_INTERVAL_NS && 
+                lastSummary.compare_exchange_strong(last, now, std::memory_order_relaxed));
+      }
+
+      void SetLimits(const LogLimits &limits)
+      {
+         rateLimit.store(limits.rate, std::memory_order_relaxed);
+         rateBurst.store(limits.burst, std::memory_order_relaxed);
+         sampleEvery.store(limits.sample, std::memory_order_relaxed);
+      }
+
+      QString                                name;
+      std::atomic<unsigned int>              level;
+      std::atomic<unsigned int>              sinks;       /* LogSink bits */
+      std::atomic<const LogCategoryList_t*>  categories;  /* index is level - 1 */
+      std::atomic<unsigned int>              rateLimit;   /* messages per second */
+      std::atomic<unsigned int>              rateBurst;
+      std::atomic<unsigned int>              sampleEvery;
+      std::atomic<qint64>                    rateTat;     /* GCRA theoretical arrival time */
+      std::atomic<quint64>                   sampleCount;
+      std::atomic<quint64>                   suppressed;
+      std::atomic<qint64>                    lastSummary;
+
+      static const qint64  SUMMARY_INTERVAL_NS = 5000000000LL;
+   };
+
+   /********************************************************************//*
+   **   struct LogCategoryInfo
+   **   
+   **   What  the  message  handler  needs to know about one of the
+   **   registry's  Qt  categories, looked up by the category name
+   **   pointer Qt hands it in the QMessageLogContext.
+   ***********************************************************************/
+   struct LogCategoryInfo
+   {
+      LogCategoryInfo(LogDescriptor *descr, unsigned int lvl) :
+         descriptor(descr),
+         level(lvl)
+      {}
+
+      bool IsEnabled() const
+      {
+         return(descriptor->level.load(std::memory_order_relaxed) >= level);
+      }
+
+      LogDescriptor  *descriptor;
+      unsigned int   level;
+   };
+
+   /********************************************************************//*
+   **   class LogHandle
+   **   
+   **   A  log  name  and  level  resolved  to  its descriptor once,
+   **   typically  stored  in  a  static at the call site. Checking
+   **   whether  the  handle  is enabled is a single relaxed atomic
+   **   load and does not allocate.
+   **   
+   **   The  handle also acts as a category function so it can be
+   **   passed straight to qCDebug().
+   ***********************************************************************/
+   class LogHandle
+   {
+   public:
+      LogHandle(QString log_name, unsigned int level = 1);
+
+      bool IsEnabled() const
+      {
+         return(m_descriptor->level.load(std::memory_order_relaxed) >= m_level);
+      }
+
+      unsigned int Level() const
+      {
+         return(m_level);
+      }
+
+      LogDescriptor *Descriptor() const
+      {
+         return(m_descriptor);
+      }
+
+      bool Admit() const
+      {
+         return(m_descriptor->Admit(LogDescriptor::Now()));
+      }
+
+      const QLoggingCategory &Category() const;
+
+      const QLoggingCategory &operator()() const
+      {
+         return(Category());
+      }
+
+   private:
+      LogDescriptor  *m_descriptor;
+      unsigned int   m_level;
+   };
+};
+
+/********************************************************************//*
+**   QCJ_LOG_HANDLE(log_name, level)
+**   
+**   Evaluates  to  a  LogHandle  held  in  a static local, so the
+**   name  is  looked up in the registry the first time the call
+**   site runs and never again. log_name must not refer to local
+**   variables, the usual case being a class's LOG constant.
+**
+**   qcjDebug(log_name, level)
+**   
+**   Replacement  for  qDebug(*log(log_name,  level)). The stream
+**   arguments  are only evaluated when the log is enabled at the
+**   given level.
+***********************************************************************/
+#define QCJ_LOG_HANDLE(log_name, level) \
+   ([]() -> const QcjLib::LogHandle & { static const QcjLib::LogHandle qcj_handle((log_name), (level)); return(qcj_handle); }())
+
+#define qcjDebug(log_name, level) \
+   for (const QcjLib::LogHandle *qcj_handle = &QCJ_LOG_HANDLE(log_name, level); \
+        qcj_handle != NULL && qcj_handle->IsEnabled(); qcj_handle = NULL) \
+      qDebug(qcj_handle->Category())
+
+#endif
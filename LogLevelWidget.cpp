@@ -30,8 +30,15 @@
 const int   QcjLib::LogLevelWidget::COL_LOG_NAME     = 0;
 const int   QcjLib::LogLevelWidget::COL_LOG_DESCR    = 1;
 const int   QcjLib::LogLevelWidget::COL_LEVEL_SELECT = 2;
+const int   QcjLib::LogLevelWidget::COL_RATE         = 3;
+const int   QcjLib::LogLevelWidget::COL_BURST        = 4;
+const int   QcjLib::LogLevelWidget::COL_SAMPLE       = 5;
+const int   QcjLib::LogLevelWidget::COLUMN_COUNT     = 6;
 
 const QString   QcjLib::LogLevelWidget::HEADER_LOG_NAME      ("Name");
 const QString   QcjLib::LogLevelWidget::HEADER_LOG_DESCR     ("Description");
 const QString   QcjLib::LogLevelWidget::HEADER_LEVEL_SELECT  ("Level");
+const QString   QcjLib::LogLevelWidget::HEADER_RATE          ("Rate/s");
+const QString   QcjLib::LogLevelWidget::HEADER_BURST         ("Burst");
+const QString   QcjLib::LogLevelWidget::HEADER_SAMPLE        ("Sample 1/N");
 
@@ -28,6 +28,7 @@
 #ifndef LOGLEVELWIDGET_H
 #define LOGLEVELWIDGET_H
 
+# include <QSpinBox>
 # include <QStringList>
 # include <QTableWidget>
 
@@ -44,9 +45,10 @@ namespace QcjLib
       LogLevelWidget(QWidget *parent = NULL) : QTableWidget(parent)
       {
 //         LogRegistery::instance()->RegisterLog("log_lvl_widget", 2);
-         setColumnCount(3);
+         setColumnCount(COLUMN_COUNT);
          QStringList header_list;
-         header_list << HEADER_LOG_NAME << HEADER_LOG_DESCR << HEADER_LEVEL_SELECT;
+         header_list << HEADER_LOG_NAME << HEADER_LOG_DESCR << HEADER_LEVEL_SELECT
+                     << HEADER_RATE << HEADER_BURST << HEADER_SAMPLE;
          setHorizontalHeaderLabels(header_list);
 
       }
@@ -54,15 +56,31 @@ namespace QcjLib
    public slots:
       void ApplySettings()
       {
+         LogLevelsMap_t levels;
+         LogLimitsMap_t limits;
          for (int row = 0; row < rowCount(); row++) 
          {
             LogLevelSelect *level_select = dynamic_cast<LogLevelSelect*>(cellWidget(row, COL_LEVEL_SELECT));
             if ( level_select != NULL ) 
             {
                unsigned int level = level_select->currentText().toUInt();
-               LogRegistery::instance()->SetLogLevel(item(row, COL_LOG_NAME)->text(),  level);
+               levels.insert(item(row, COL_LOG_NAME)->text(),  level);
+            }
+
+            QSpinBox *rate = dynamic_cast<QSpinBox*>(cellWidget(row, COL_RATE));
+            QSpinBox *burst = dynamic_cast<QSpinBox*>(cellWidget(row, COL_BURST));
+            QSpinBox *sample = dynamic_cast<QSpinBox*>(cellWidget(row, COL_SAMPLE));
+            if ( rate != NULL && burst != NULL && sample != NULL ) 
+            {
+               LogLimits limit;
+               limit.rate = rate->value();
+               limit.burst = burst->value();
+               limit.sample = sample->value();
+               limits.insert(item(row, COL_LOG_NAME)->text(), limit);
             }
          }
+         LogRegistery::instance()->SetLogLevels(levels);
+         LogRegistery::instance()->SetLogLimits(limits);
       }
 
       void Initialize()
@@ -72,7 +90,7 @@ namespace QcjLib
          cat_names.sort();
          int row = 0;
 //         clear();
-         setColumnCount(3);
+         setColumnCount(COLUMN_COUNT);
          foreach (QString cat_name, cat_names)
          {
             if ( cat_name.isEmpty() ) 
@@ -87,6 +105,11 @@ namespace QcjLib
             Qt::ItemFlags item_flags = Qt::ItemIsEnabled;
 
             setCellWidget(row - 1, COL_LEVEL_SELECT, new LogLevelSelect(cat_name));
+
+            LogLimits limits = LogRegistery::instance()->LogLimit(cat_name);
+            setCellWidget(row - 1, COL_RATE, LimitSpinBox(limits.rate, 0, "Off"));
+            setCellWidget(row - 1, COL_BURST, LimitSpinBox(limits.burst, 0, "1"));
+            setCellWidget(row - 1, COL_SAMPLE, LimitSpinBox(limits.sample, 1, "Off"));
           
             item = new QTableWidgetItem(LogRegistery::instance()->LogDescription(cat_name));
             item->setFlags(item_flags);
@@ -100,13 +123,33 @@ namespace QcjLib
 
    protected:
    private:
+      /***********************************************/
+      /*   The lowest value of each limit is its    */
+      /*   default and is shown as off_text.        */
+      /***********************************************/
+      QSpinBox *LimitSpinBox(unsigned int value, int off_value, QString off_text)
+      {
+         QSpinBox *rv = new QSpinBox();
+         rv->setRange(off_value, 1000000);
+         rv->setSpecialValueText(off_text);
+         rv->setValue(qMax((int)value, off_value));
+         return(rv);
+      }
+
       static const int  COL_LEVEL_SELECT;
       static const int  COL_LOG_DESCR;
       static const int  COL_LOG_NAME;
+      static const int  COL_RATE;
+      static const int  COL_BURST;
+      static const int  COL_SAMPLE;
+      static const int  COLUMN_COUNT;
 
       static const QString  HEADER_LEVEL_SELECT;
       static const QString  HEADER_LOG_DESCR;
       static const QString  HEADER_LOG_NAME;
+      static const QString  HEADER_RATE;
+      static const QString  HEADER_BURST;
+      static const QString  HEADER_SAMPLE;
    };
 }
 #endif
@@ -0,0 +1,244 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+# include "LogQueryWidget.h"
+# include "LogRegistery.h"
+# include "SqlLogSink.h"
+
+# include <QElapsedTimer>
+# include <QFontDatabase>
+# include <QHBoxLayout>
+# include <QHeaderView>
+# include <QPushButton>
+# include <QSettings>
+# include <QSqlDatabase>
+# include <QSqlError>
+# include <QSqlQuery>
+# include <QVBoxLayout>
+
+#include <utility>
+
+using namespace QcjLib;
+
+const int   LogQueryWidget::DEFAULT_LIMIT = 10000;
+
+LogQueryWidget::LogQueryWidget(QWidget *parent) :
+   QWidget(parent),
+   m_connection(QString("QcjLib_log_query_%1").arg((quintptr)this))
+{
+   QVBoxLayout *layout = new QVBoxLayout(this);
+   QHBoxLayout *filter_layout = new QHBoxLayout();
+   QPushButton *query_btn = new QPushButton("Query", this);
+
+   m_fromEdit = new QDateTimeEdit(QDateTime::currentDateTime().addSecs(-3600), this);
+   m_fromEdit->setCalendarPopup(true);
+   m_toEdit = new QDateTimeEdit(QDateTime::currentDateTime().addSecs(3600), this);
+   m_toEdit->setCalendarPopup(true);
+   m_categoryCombo = new QComboBox(this);
+   m_levelSpin = new QSpinBox(this);
+   m_levelSpin->setRange(0, 9);
+   m_levelSpin->setSpecialValueText("All");
+   m_textEdit = new QLineEdit(this);
+   m_textEdit->setPlaceholderText("Message contains");
+   m_textEdit->setClearButtonEnabled(true);
+   m_limitSpin = new QSpinBox(this);
+   m_limitSpin->setRange(1, 10000000);
+   m_limitSpin->setValue(DEFAULT_LIMIT);
+
+   filter_layout->addWidget(new QLabel("From", this));
+   filter_layout->addWidget(m_fromEdit);
+   filter_layout->addWidget(new QLabel("To", this));
+   filter_layout->addWidget(m_toEdit);
+   filter_layout->addWidget(new QLabel("Log", this));
+   filter_layout->addWidget(m_categoryCombo);
+   filter_layout->addWidget(new QLabel("Level", this));
+   filter_layout->addWidget(m_levelSpin);
+   filter_layout->addWidget(m_textEdit, 1);
+   filter_layout->addWidget(new QLabel("Limit", this));
+   filter_layout->addWidget(m_limitSpin);
+   filter_layout->addWidget(query_btn);
+   layout->addLayout(filter_layout);
+
+   m_model = new QSqlQueryModel(this);
+   m_tableView = new QTableView(this);
+   m_tableView->setModel(m_model);
+   m_tableView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+   m_tableView->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+   m_tableView->horizontalHeader()->setStretchLastSection(true);
+   m_tableView->verticalHeader()->hide();
+   layout->addWidget(m_tableView);
+
+   m_statusLabel = new QLabel(this);
+   layout->addWidget(m_statusLabel);
+
+   connect(query_btn, SIGNAL(clicked()), this, SLOT(SlotRunQuery()));
+   connect(m_textEdit, SIGNAL(returnPressed()), this, SLOT(SlotRunQuery()));
+
+   QSettings settings;
+   if ( settings.value(LOG_DB_ENABLE, false).toBool() ) 
+   {
+      SetDatabaseName(settings.value(LOG_DB_NAME, "").toString());
+   }
+   Initialize();
+}
+
+LogQueryWidget::~LogQueryWidget()
+{
+   m_model->clear();
+   if ( QSqlDatabase::contains(m_connection) ) 
+   {
+      QSqlDatabase::database(m_connection, false).close();
+      QSqlDatabase::removeDatabase(m_connection);
+   }
+}
+
+/********************************************************************//*
+**   void LogQueryWidget::SetDatabaseName(QString filename)
+**   
+**   Selects  the  database to query, normally the one the Logger's
+**   database sink writes to.
+***********************************************************************/
+void LogQueryWidget::SetDatabaseName(QString filename)
+{
+   m_fileName = filename;
+   m_model->clear();
+   if ( QSqlDatabase::contains(m_connection) ) 
+   {
+      QSqlDatabase::database(m_connection, false).close();
+      QSqlDatabase::removeDatabase(m_connection);
+   }
+}
+
+/********************************************************************//*
+**   void LogQueryWidget::Initialize()
+**   
+**   Fills the log name selector from the LogRegistery.
+***********************************************************************/
+void LogQueryWidget::Initialize()
+{
+   QString current = m_categoryCombo->currentData().toString();
+   QStringList cat_names = LogRegistery::instance()->LogList();
+
+   cat_names.sort();
+   m_categoryCombo->clear();
+   m_categoryCombo->addItem("All", QString());
+   foreach (QString cat_name, cat_names)
+   {
+      if ( ! cat_name.isEmpty() ) 
+         m_categoryCombo->addItem(cat_name, cat_name);
+   }
+   m_categoryCombo->setCurrentIndex(qMax(m_categoryCombo->findData(current), 0));
+}
+
+/********************************************************************//*
+**   void LogQueryWidget::SlotRunQuery()
+**   
+**   Runs  the  query  for  the current filter, newest records first.
+**   Every  condition  is  bound  rather  than  pasted into the SQL,
+**   and  each  one  has  an  index  starting with its column and the
+**   time stamp.
+***********************************************************************/
+void LogQueryWidget::SlotRunQuery()
+{
+   if ( m_fileName.isEmpty() ) 
+   {
+      m_statusLabel->setText("No log database is configured");
+      return;
+   }
+
+   QSqlDatabase db;
+   if ( QSqlDatabase::contains(m_connection) ) 
+   {
+      db = QSqlDatabase::database(m_connection);
+   }
+   else 
+   {
+      db = QSqlDatabase::addDatabase("QSQLITE", m_connection);
+      db.setDatabaseName(m_fileName);
+      db.setConnectOptions("QSQLITE_OPEN_READONLY");
+      db.open();
+   }
+
+   if ( ! db.isOpen() ) 
+   {
+      m_statusLabel->setText("Could not open " + m_fileName + ": " + db.lastError().text());
+      return;
+   }
+
+   QString category = m_categoryCombo->currentData().toString();
+   QString sql = "select strftime('%Y-%m-%d %H:%M:%f', timestamp / 1000.0, 'unixepoch', 'localtime') as time, "
+                 "thread, category, level, function, message from " + SqlLogSink::TABLE_NAME + 
+                 " where timestamp between ? and ?";
+   if ( ! category.isEmpty() ) 
+   {
+      sql += " and category = ?";
+   }
+   if ( m_levelSpin->value() > 0 ) 
+   {
+      sql += " and level <= ?";
+   }
+   if ( ! m_textEdit->text().isEmpty() ) 
+   {
+      sql += " and message like ? escape '\\'";
+   }
+   sql += " order by timestamp desc limit ?";
+
+   QSqlQuery q1(db);
+   q1.prepare(sql);
+   q1.addBindValue(m_fromEdit->dateTime().toMSecsSinceEpoch());
+   q1.addBindValue(m_toEdit->dateTime().toMSecsSinceEpoch());
+   if ( ! category.isEmpty() ) 
+   {
+      q1.addBindValue(category);
+   }
+   if ( m_levelSpin->value() > 0 ) 
+   {
+      q1.addBindValue(m_levelSpin->value());
+   }
+   if ( ! m_textEdit->text().isEmpty() ) 
+   {
+      QString pattern = m_textEdit->text();
+      pattern.replace("\\", "\\\\").replace("%", "\\%").replace("_", "\\_");
+      q1.addBindValue("%" + pattern + "%");
+   }
+   q1.addBindValue(m_limitSpin->value());
+
+   QElapsedTimer timer;
+   timer.start();
+   if ( ! q1.exec() ) 
+   {
+      m_statusLabel->setText("Query failed: " + q1.lastError().text());
+      return;
+   }
+
+   m_model->setQuery(std::move(q1));
+   while ( m_model->canFetchMore() ) 
+   {
+      m_model->fetchMore();
+   }
+   m_statusLabel->setText(QString("%1 records in %2 ms").arg(m_model->rowCount()).arg(timer.elapsed()));
+}
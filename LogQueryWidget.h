@@ -0,0 +1,81 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef LOGQUERYWIDGET_H
+#define LOGQUERYWIDGET_H
+
+# include <QComboBox>
+# include <QDateTimeEdit>
+# include <QLabel>
+# include <QLineEdit>
+# include <QSpinBox>
+# include <QSqlQueryModel>
+# include <QTableView>
+# include <QWidget>
+
+namespace QcjLib
+{
+   /********************************************************************//*
+   **   class LogQueryWidget
+   **   
+   **   Searches  the  database written by the Logger's database sink,
+   **   see  SqlLogSink,  by  time  range, log name, level and message
+   **   text.  It  uses  a read only connection of its own, so queries
+   **   do not get in the way of the sink.
+   ***********************************************************************/
+   class LogQueryWidget : public QWidget
+   {
+      Q_OBJECT
+
+   public:
+      LogQueryWidget(QWidget *parent = NULL);
+      ~LogQueryWidget();
+
+      void SetDatabaseName(QString filename);
+
+   public slots:
+      void Initialize();
+      void SlotRunQuery();
+
+   private:
+      QString           m_fileName;
+      QString           m_connection;
+      QDateTimeEdit     *m_fromEdit;
+      QDateTimeEdit     *m_toEdit;
+      QComboBox         *m_categoryCombo;
+      QSpinBox          *m_levelSpin;
+      QLineEdit         *m_textEdit;
+      QSpinBox          *m_limitSpin;
+      QLabel            *m_statusLabel;
+      QTableView        *m_tableView;
+      QSqlQueryModel    *m_model;
+
+      static const int  DEFAULT_LIMIT;
+   };
+}
+
+#endif
@@ -0,0 +1,153 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef LOGRECORD_H
+#define LOGRECORD_H
+
+# include <QByteArray>
+# include <QMetaType>
+# include <QString>
+# include <QVector>
+# include <QtGlobal>
+
+namespace QcjLib
+{
+   /********************************************************************//*
+   **   Bits  selecting  which of the Logger's outputs a record goes
+   **   to. Each log carries a mask of these in its descriptor.
+   ***********************************************************************/
+   enum LogSink
+   {
+      LogSinkConsole    = 0x01,
+      LogSinkFile       = 0x02,
+      LogSinkView       = 0x04,
+      LogSinkBinary     = 0x08,
+      LogSinkFlight     = 0x10,
+      LogSinkDatabase   = 0x20,
+      LogSinkAll        = 0xff
+   };
+
+   /********************************************************************//*
+   **   struct LogArg
+   **   
+   **   One  typed  argument  of  a  structured  record. Positional
+   **   arguments  have  no  key  and fill the %1 .. %9 markers of the
+   **   record's  format,  keyed  ones are fields that are listed after
+   **   the message and can be filtered on in the log view.
+   **
+   **   key must point to static storage, normally a string literal.
+   ***********************************************************************/
+   struct LogArg
+   {
+      enum Type
+      {
+         Int      = 1,
+         UInt     = 2,
+         Double   = 3,
+         String   = 4,
+         Pointer  = 5
+      };
+
+      LogArg() :
+         key(NULL),
+         type(Int),
+         i(0)
+      {}
+
+      const char     *key;
+      quint8         type;
+      union
+      {
+         qint64      i;
+         quint64     u;
+         double      d;
+         quintptr    p;
+      };
+      QString        str;
+   };
+
+   typedef QVector<LogArg> LogArgs_t;
+
+   /********************************************************************//*
+   **   struct LogRecord
+   **   
+   **   A  single  log  message  as  it travels from the Qt message
+   **   handler  to  the  Logger's  sinks.  A record is either pre-
+   **   formatted,  in which case text holds the finished line, or
+   **   deferred,  in  which  case  the  sink  formats it from the
+   **   remaining fields.
+   **
+   **   A  deferred  record  built  by  the  structured  front end, see
+   **   qcjLog(),  carries  a  format  and its typed args instead of a
+   **   message,  the  message  is  only rendered if a text sink needs
+   **   it.
+   **
+   **   function  is  a  copy of the function name, the context.function
+   **   of  a  Qt  message  is  only valid during the handler call.
+   **   format  and  the  argument keys must point to static storage,
+   **   the qcjLog() macros only pass string literals.
+   ***********************************************************************/
+   struct LogRecord
+   {
+      LogRecord() :
+         type(QtDebugMsg),
+         level(1),
+         sinks(LogSinkAll),
+         threadId(0),
+         format(NULL),
+         timestamp(0),
+         monotonic(0)
+      {}
+
+      bool isFormatted() const
+      {
+         return(! text.isEmpty());
+      }
+
+      bool isStructured() const
+      {
+         return(format != NULL);
+      }
+
+      QtMsgType      type;
+      unsigned int   level;
+      unsigned int   sinks;
+      quint32        threadId;      /* Logger::CurrentThreadId() */
+      QByteArray     function;
+      const char     *format;
+      qint64         timestamp;     /* msecs since epoch */
+      qint64         monotonic;     /* Logger::MonotonicNs() */
+      QString        category;
+      QString        message;
+      QString        text;
+      LogArgs_t      args;
+   };
+};
+
+Q_DECLARE_METATYPE(QcjLib::LogRecord)
+
+#endif
@@ -28,13 +28,15 @@
 # include "LogRegistery.h"
 
 # include "LogBuilder.h"
+# include "Logger.h"
+
+# include <QCoreApplication>
+# include <QThread>
 
 using namespace QcjLib;
 
 static LogBuilder mylog("default", 1, "Catches the undefined debug messages");
 
-LogRegistery* QcjLib::LogRegistery::m_instance = NULL;
-
 /********************************************************************//*
 **   LogRegistery::LogRegistery(QObject *parent) constructor
 **   
@@ -47,8 +49,84 @@ LogRegistery* QcjLib::LogRegistery::m_instance = NULL;
 **   
 **   Returns N/A
 ***********************************************************************/
-LogRegistery::LogRegistery(QObject *parent) : QObject(parent), m_defaultCategory(new QLoggingCategory("default"))
+LogRegistery::LogRegistery(QObject *parent) : 
+   QObject(parent), 
+   m_defaultCategory(new QLoggingCategory("default")),
+   m_snapshot(new LogRegisterySnapshot()),
+   m_summaryTimer(NULL)
 {
+   s_registery.store(this, std::memory_order_release);
+   s_previousFilter = QLoggingCategory::installFilter(CategoryFilter);
+}
+
+std::atomic<LogRegistery*> LogRegistery::s_registery(NULL);
+QLoggingCategory::CategoryFilter LogRegistery::s_previousFilter = NULL;
+
+/********************************************************************//*
+**   static void LogRegistery::CategoryFilter(QLoggingCategory *category) private
+**   
+**   Installed  as  Qt's  category  filter. Qt re-evaluates every
+**   category's  enabled  state  when  its  filter rules change or a
+**   new  category  is created, which would undo the level set by
+**   ApplyLogLevel().  The  previous  filter  runs first, then debug
+**   and  info  output  of  the  registry's  categories  is set from
+**   the  log's  current  level. Qt may call this from any thread, it
+**   only reads the published snapshot.
+***********************************************************************/
+void LogRegistery::CategoryFilter(QLoggingCategory *category)
+{
+   if ( s_previousFilter != NULL ) 
+   {
+      s_previousFilter(category);
+   }
+
+   LogRegistery *registery = s_registery.load(std::memory_order_acquire);
+   if ( registery != NULL ) 
+   {
+      const LogCategoryInfo *info = registery->CategoryInfo(category->categoryName());
+      if ( info != NULL ) 
+      {
+         bool enable = info->IsEnabled();
+         category->setEnabled(QtDebugMsg, enable);
+         category->setEnabled(QtInfoMsg, enable);
+      }
+   }
+}
+
+/********************************************************************//*
+**   Reads  the  settings  from  QSettings for the logging and
+**   configures  each  of  the  loggers  defined. Each entry is
+**   name:description:level,  optionally  followed by :rate:burst:sample
+**   for the log's limits.
+***********************************************************************/
+void LogRegistery::RestoreLogSettings()
+{
+   QSettings settings;
+   QStringList log_info = settings.value(LOG_STATUS, "").toString().split(",");
+
+   QMutexLocker lock(&m_updateLock);
+   LogRegisterySnapshot *snap = new LogRegisterySnapshot(*Snapshot());
+   foreach (QString log_setting, log_info)
+   {
+      QStringList setting = log_setting.split(":");
+      QString log_name = setting[0];
+      QString cat_desc = (setting.count() > 1) ? setting[1] : "";
+      QString cat_levl = (setting.count() > 2) ? setting[2] : "0";
+
+      snap->logLevels.insert(log_name, cat_levl.toInt()); 
+      snap->logDescriptions.insert(log_name, cat_desc); 
+      if ( setting.count() > 5 ) 
+      {
+         LogLimits limits;
+         limits.rate = setting[3].toUInt();
+         limits.burst = setting[4].toUInt();
+         limits.sample = setting[5].toUInt();
+         snap->logLimits.insert(log_name, limits);
+      }
+      ApplyLogLevel(snap, log_name);
+   }
+   Publish(snap);
+   UpdateSummaryTimer(snap);
 }
 
 /********************************************************************//*
@@ -70,16 +148,25 @@ LogRegistery::LogRegistery(QObject *parent) : QObject(parent), m_defaultCategory
 void LogRegistery::RegisterLog(QString log_name, unsigned int levels, QString description)
 {
 //   std::cout << __FUNCTION__ <<  " log_name: " << qPrintable(log_name) << std::endl;
-//   std::cout << __FUNCTION__ <<  " log_name: " << std::endl;
-//   m_logLevels.insert(log_name, levels);
-   if ( ! m_logLevels.contains(log_name) ) 
+   QMutexLocker lock(&m_updateLock);
+   LogRegisterySnapshot *snap = new LogRegisterySnapshot(*Snapshot());
+
+   if ( ! snap->logLevels.contains(log_name) ) 
    {
-      m_logLevels.insert(log_name, 1);
+      snap->logLevels.insert(log_name, 1);
    }
 
-   m_logDescriptions.insert(log_name, description);
+   snap->logDescriptions.insert(log_name, description);
+   snap->logMaxLevels.insert(log_name, levels);
 
-   m_logMaxLevels.insert(log_name, levels);
+   LogDescriptor *descr = snap->descriptors.value(log_name, NULL);
+   if ( descr == NULL ) 
+   {
+      descr = new LogDescriptor(log_name, snap->logLevels.value(log_name));
+      snap->descriptors.insert(log_name, descr);
+   }
+
+   LogCategoryList_t *categories = new LogCategoryList_t();
    for (unsigned int level = 1; level <= levels; level++) 
    {
       QString full_name = BuildName(log_name, level);
@@ -87,19 +174,136 @@ void LogRegistery::RegisterLog(QString log_name, unsigned int levels, QString de
       strncpy(name_buf, qPrintable(full_name), strlen(qPrintable(full_name)) + 1);
 //      std::cout << __FUNCTION__ << " full_name: " << name_buf << std::endl;
 
-//      std::cout << __FUNCTION__ << " full_name: " << std::endl;
       QLoggingCategory *category = new QLoggingCategory(name_buf);
 //      std::cout << __FUNCTION__ <<  " cat->name(" << (unsigned long)category << "): " << category->categoryName() << " (" << (unsigned long long)(category->categoryName()) << ")" << std::endl;
-      m_logMap.insert(full_name, category);
-//      foreach (QString name, m_logMap.keys())
-//      {
-//         QLoggingCategory *cat = m_logMap.value(name);
-//         std::cout << __FUNCTION__ << " cat(" << (unsigned long)cat << "): " << qPrintable(name) << ", cat->name: " << (unsigned long long)(cat->categoryName()) << std::endl;
-//      }
+      snap->logMap.insert(full_name, category);
+      snap->categoryInfo.insert(category->categoryName(), new LogCategoryInfo(descr, level));
+      categories->append(category);
    }
+   /***************************************************************/
+   /*   The  old  list,  if  any,  is  left  alone as a handle may  */
+   /*   still be reading it.                                       */
+   /***************************************************************/
+   descr->categories.store(categories, std::memory_order_release);
+   ApplyLogLevel(snap, log_name);
+   Publish(snap);
 //         emit LogRegistered();
 }
 
+/********************************************************************//*
+**   LogDescriptor *LogRegistery::Descriptor(QString log_name)
+**   
+**   Function  returning  the descriptor of the named log, creating
+**   it  if the log has not been registered yet. A new descriptor
+**   starts  with  the  saved  level and limits of the log and the
+**   rest is filled in when the log is registered.
+**   
+**   Parameters
+**   
+**   log_name     Name of the log
+**   
+**   Returns pointer to the descriptor, which is never freed
+***********************************************************************/
+LogDescriptor *LogRegistery::Descriptor(QString log_name)
+{
+   LogDescriptor *rv = Snapshot()->descriptors.value(log_name, NULL);
+   if ( rv == NULL ) 
+   {
+      QMutexLocker lock(&m_updateLock);
+      rv = Snapshot()->descriptors.value(log_name, NULL);
+      if ( rv == NULL ) 
+      {
+         LogRegisterySnapshot *snap = new LogRegisterySnapshot(*Snapshot());
+         rv = new LogDescriptor(log_name, snap->logLevels.value(log_name, 1));
+         rv->SetLimits(snap->logLimits.value(log_name));
+         snap->descriptors.insert(log_name, rv);
+         Publish(snap);
+      }
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   void  SetLogLevel(QString  log_name, unsigned int level = 1)
+**   
+**   Dunction  to  set  the  logging  level  of the named log.
+**   Parameters
+**   
+**   log_name Name of the log
+**   
+**   level Logging level
+**   
+**   Returns N/A
+***********************************************************************/
+void LogRegistery::SetLogLevel(QString log_name, unsigned int level)
+{
+   LogLevelsMap_t levels;
+   levels.insert(log_name, level);
+   SetLogLevels(levels);
+}
+
+/********************************************************************//*
+**   void SetLogLevels(const LogLevelsMap_t &levels)
+**   
+**   Sets the levels of several logs at once, publishing a single
+**   new snapshot for all of them.
+**   
+**   Parameters
+**   
+**   levels   Map of log names to their new levels
+**   
+**   Returns N/A
+***********************************************************************/
+void LogRegistery::SetLogLevels(const LogLevelsMap_t &levels)
+{
+   QMutexLocker lock(&m_updateLock);
+   LogRegisterySnapshot *snap = new LogRegisterySnapshot(*Snapshot());
+
+   LogLevelsMap_t::const_iterator it;
+   for (it = levels.constBegin(); it != levels.constEnd(); ++it) 
+   {
+      snap->logLevels.insert(it.key(), it.value());
+      ApplyLogLevel(snap, it.key());
+   }
+   Publish(snap);
+}
+
+/********************************************************************//*
+**   void SetLogLimits(const LogLimitsMap_t &limits)
+**   
+**   Sets  the  rate  limits  and  sampling of several logs at once.
+**   While  any  log  is  limited,  a  timer sweeps the logs every
+**   LOG_SUMMARY_SWEEP_MS  and  reports  messages  suppressed by logs
+**   that have gone quiet since.
+**   
+**   Parameters
+**   
+**   limits   Map of log names to their new limits
+**   
+**   Returns N/A
+***********************************************************************/
+void LogRegistery::SetLogLimits(const LogLimitsMap_t &limits)
+{
+   QMutexLocker lock(&m_updateLock);
+   LogRegisterySnapshot *snap = new LogRegisterySnapshot(*Snapshot());
+
+   LogLimitsMap_t::const_iterator it;
+   for (it = limits.constBegin(); it != limits.constEnd(); ++it) 
+   {
+      if ( it.value().IsLimited() ) 
+      {
+         snap->logLimits.insert(it.key(), it.value());
+      }
+      else 
+      {
+         snap->logLimits.remove(it.key());
+      }
+      ApplyLogLevel(snap, it.key());
+   }
+   Publish(snap);
+   UpdateSummaryTimer(snap);
+}
+
 /********************************************************************//*
 **   Function  saves the settings for each of the individual logs to
 **   QSettings
@@ -109,22 +313,143 @@ void LogRegistery::RegisterLog(QString log_name, unsigned int levels, QString de
 void QcjLib::LogRegistery::SaveLogSettings()
 {
    QSettings settings;
+   const LogRegisterySnapshot *snap = Snapshot();
 
    QString log_settings;
-   foreach (QString log_name, m_logLevels.keys())
+   foreach (QString log_name, snap->logLevels.keys())
    {
-      QString descr = m_logDescriptions.value(log_name);
-      QString level = QString::number(m_logLevels.value(log_name));
+      QString descr = snap->logDescriptions.value(log_name);
+      QString level = QString::number(snap->logLevels.value(log_name));
       log_settings += (log_settings.size() > 0) ? "," : "";
       log_settings += log_name + ":" + descr + ":" + level;
+
+      if ( snap->logLimits.contains(log_name) ) 
+      {
+         LogLimits limits = snap->logLimits.value(log_name);
+         log_settings += ":" + QString::number(limits.rate) + 
+                         ":" + QString::number(limits.burst) + 
+                         ":" + QString::number(limits.sample);
+      }
    }
    settings.setValue(LOG_STATUS, log_settings);
 }
 
+/********************************************************************//*
+**   void ApplyLogLevel(const LogRegisterySnapshot *snap, QString log_name) private
+**   
+**   Pushes  the  level  the  named  log has in snap out to its
+**   handles  and  to  the  Qt  categories registered for each of
+**   its  levels.  Categories  above  the  current level have debug
+**   and  info output turned off so Qt drops those messages before
+**   they  ever  reach  the  message handler. CategoryFilter() puts
+**   the same state back whenever Qt recomputes it.
+***********************************************************************/
+void LogRegistery::ApplyLogLevel(const LogRegisterySnapshot *snap, QString log_name)
+{
+   LogDescriptor *descr = snap->descriptors.value(log_name, NULL);
+   if ( descr != NULL ) 
+   {
+      unsigned int level = snap->logLevels.value(log_name, 1);
+      const LogCategoryList_t *categories = descr->categories.load(std::memory_order_acquire);
+
+      descr->level.store(level, std::memory_order_relaxed);
+      descr->SetLimits(snap->logLimits.value(log_name));
+      for (int x = 0; x < categories->count(); x++) 
+      {
+         bool enable = ((unsigned int)x + 1) <= level;
+         categories->at(x)->setEnabled(QtDebugMsg, enable);
+         categories->at(x)->setEnabled(QtInfoMsg, enable);
+      }
+   }
+}
+
+/********************************************************************//*
+**   void Publish(LogRegisterySnapshot *snap) private
+**   
+**   Makes  snap  the  current  snapshot. The caller must hold
+**   m_updateLock and must not modify snap afterwards.
+***********************************************************************/
+void LogRegistery::Publish(LogRegisterySnapshot *snap)
+{
+   const LogRegisterySnapshot *old = m_snapshot.exchange(snap, std::memory_order_acq_rel);
+   m_retired.append(old);
+}
+
+/********************************************************************//*
+**   void UpdateSummaryTimer(const LogRegisterySnapshot *snap) private
+**   
+**   Runs  the  suppression  sweep only while some log is limited.
+**   The  timer  needs  the  application's event loop, so without one
+**   summaries are only written with the next admitted message.
+***********************************************************************/
+void LogRegistery::UpdateSummaryTimer(const LogRegisterySnapshot *snap)
+{
+   if ( QCoreApplication::instance() == NULL || QThread::currentThread() != thread() ) 
+   {
+      return;
+   }
+
+   if ( m_summaryTimer == NULL ) 
+   {
+      m_summaryTimer = new QTimer(this);
+      connect(m_summaryTimer, SIGNAL(timeout()), this, SLOT(ReportSuppressed()));
+   }
+
+   if ( snap->logLimits.isEmpty() ) 
+   {
+      m_summaryTimer->stop();
+   }
+   else if ( ! m_summaryTimer->isActive() ) 
+   {
+      m_summaryTimer->start(LOG_SUMMARY_SWEEP_MS);
+   }
+}
+
+/********************************************************************//*
+**   void ReportSuppressed() private slot
+**   
+**   Reports  the  messages  suppressed  by  each  log since its last
+**   summary.  Logs  still  busy  have  their summary written with
+**   their next admitted message instead.
+***********************************************************************/
+void LogRegistery::ReportSuppressed()
+{
+   const LogRegisterySnapshot *snap = Snapshot();
+   qint64 now = Logger::MonotonicNs();
+
+   foreach (LogDescriptor *descr, snap->descriptors)
+   {
+      if ( descr->suppressed.load(std::memory_order_relaxed) > 0 ) 
+      {
+         Logger::instance()->ReportSuppressed(descr, now);
+      }
+   }
+}
+
 QLoggingCategory *QcjLib::log(QString log_name, unsigned int level)
 {
    return(QcjLib::LogRegistery::instance()->category(log_name, level));
 }
 
+QcjLib::LogHandle::LogHandle(QString log_name, unsigned int level) :
+   m_descriptor(LogRegistery::instance()->Descriptor(log_name)),
+   m_level(level)
+{
+}
 
-
+/********************************************************************//*
+**   const QLoggingCategory &LogHandle::Category() const
+**   
+**   Returns  the  Qt  category  for  this  handle's log and level,
+**   or  the  registry's  default  category if the log has no such
+**   level.
+***********************************************************************/
+const QLoggingCategory &QcjLib::LogHandle::Category() const
+{
+   const LogCategoryList_t *categories = m_descriptor->categories.load(std::memory_order_acquire);
+   if ( m_level > 0 && m_level <= (unsigned int)categories->count() ) 
+   {
+      return(*categories->at(m_level - 1));
+   }
+   return(*LogRegistery::instance()->category(m_descriptor->name, m_level));
+}
@@ -28,11 +28,18 @@
 #ifndef LOGREGISTERY_H
 #define LOGREGISTERY_H
 
+# include <QHash>
 # include <QLoggingCategory>
+# include <QList>
 # include <QMap>
+# include <QMutex>
 # include <QSettings>
 # include <QString>
+# include <QTimer>
 
+# include "LogHandle.h"
+
+#include <atomic>
 #include <iostream>
 
 /********************************************************************//*
@@ -47,15 +54,34 @@
 **
 **   It  is  expected  to  be onle one instance of this class in the
 **   application.
+**
+**   Lookups  read  an  immutable  snapshot  of  the  registry  and
+**   never  lock,  so  worker  threads  can  log  while  the  levels
+**   are  being  changed.  Changes  copy  the  current snapshot under
+**   a  mutex,  modify  the copy and publish it with an atomic pointer
+**   swap.  Replaced  snapshots are retired rather than freed because
+**   a  reader  may  still  be  looking at one. Changes are rare and
+**   the  copies  share  their  unchanged  maps,  so this costs very
+**   little memory.
 ***********************************************************************/
 
 namespace QcjLib
 {
+   /********************************************************************//*
+   **   The  categories  returned  here  have  debug  output disabled
+   **   above  the  log's  current  level,  so  qDebug(*log(...)) no
+   **   longer  reaches  the  message handler when the level is off.
+   **   qDebug()  still  evaluates its stream arguments though, use
+   **   qcjDebug() from LogHandle.h to skip those as well.
+   ***********************************************************************/
    QLoggingCategory *log(QString category_name, unsigned int level = 1);
 
    typedef QMap<QString, QString> LogDescriptionMap_t;
    typedef QMap<QString, unsigned int> LogLevelsMap_t;
+   typedef QMap<QString, LogLimits> LogLimitsMap_t;
    typedef QMap<QString, QLoggingCategory*> LogRegisteryMap_t;
+   typedef QMap<QString, LogDescriptor*> LogDescriptorMap_t;
+   typedef QHash<const char*, LogCategoryInfo*> LogCategoryInfoMap_t;
 
    static const QString MSG_DEBUG_TYPE       ("debug");
    static const QString MSG_INFO_TYPE        ("info");
@@ -64,9 +90,44 @@ namespace QcjLib
 
    static const QString LOG_CONSOLE_ENABLE   ("LogConsoleEnable");
    static const QString LOG_VIEW_ENABLE      ("LogViewEnable");
+   static const QString LOG_VIEW_BATCH_SIZE  ("LogViewBatchSize");
+   static const QString LOG_VIEW_BATCH_MS    ("LogViewBatchInterval");
+   static const QString LOG_VIEW_CAPACITY    ("LogViewCapacity");
    static const QString LOG_FILE_ENABLE      ("LogFileEnable");
    static const QString LOG_FILE_NAME        ("LogFileName");
+   static const QString LOG_BINARY_FILE_NAME ("LogBinaryFileName");
+   static const QString LOG_FLIGHT_FILE_NAME ("LogFlightFileName");
+   static const QString LOG_FLIGHT_SIZE      ("LogFlightSize");
+   static const QString LOG_DB_ENABLE        ("LogDatabaseEnable");
+   static const QString LOG_DB_NAME          ("LogDatabaseName");
+   static const QString LOG_DB_RETENTION     ("LogDatabaseRetentionDays");
    static const QString LOG_STATUS           ("LogStatus");
+   static const int     LOG_SUMMARY_SWEEP_MS = 5000;
+   static const QString LOG_ASYNC_ENABLE     ("LogAsyncEnable");
+   static const QString LOG_ASYNC_QUEUE_SIZE ("LogAsyncQueueSize");
+   static const QString LOG_ASYNC_OVERFLOW   ("LogAsyncOverflow");
+   static const QString LOG_ROTATE_MAX_BYTES ("LogRotateMaxBytes");
+   static const QString LOG_ROTATE_MAX_AGE   ("LogRotateMaxAge");
+   static const QString LOG_ROTATE_KEEP      ("LogRotateKeep");
+   static const QString LOG_ROTATE_COMPRESS  ("LogRotateCompress");
+
+   /********************************************************************//*
+   **   struct LogRegisterySnapshot
+   **   
+   **   Everything  the  registry knows at one point in time. Once a
+   **   snapshot  is  published  it is never modified, so any number
+   **   of threads can read it without locking.
+   ***********************************************************************/
+   struct LogRegisterySnapshot
+   {
+      LogRegisteryMap_t    logMap;
+      LogDescriptorMap_t   descriptors;
+      LogCategoryInfoMap_t categoryInfo;
+      LogLevelsMap_t       logLevels;      
+      LogLevelsMap_t       logMaxLevels;
+      LogDescriptionMap_t  logDescriptions;
+      LogLimitsMap_t       logLimits;
+   };
 
    class LogRegistery : public QObject 
    {
@@ -83,40 +144,53 @@ namespace QcjLib
       **   static LogRegistery* instance()
       **   
       **   Creates  an instance of this class if it does not already
-      **   exists.
+      **   exists. Safe to call from any thread.
       **   
       **   Return: Pointer to the instance.
       ***********************************************************************/
       static LogRegistery* instance()
       {
-         if ( m_instance == NULL ) 
-         {
-            m_instance = new LogRegistery();
-         }
-         return(m_instance);
+         static LogRegistery *instance = new LogRegistery();
+         return(instance);
       }
 
+      void RestoreLogSettings();
+      void RegisterLog(QString log_name, unsigned int levels = 1, QString description = QString());
+      LogDescriptor *Descriptor(QString log_name);
+
       /********************************************************************//*
-      **   Reads  the  settings  from  QSettings for the logging and
-      **   configures each of the loggers defined.
+      **   const LogCategoryInfo *CategoryInfo(const char *category_name)
+      **   
+      **   Looks  up  one  of  the registry's categories by the name
+      **   pointer  passed  in  a QMessageLogContext. This avoids any
+      **   string handling in the message handler.
+      **   
+      **   Returns  pointer  to  the  category's  info  or  NULL if the
+      **   category was not created by the registry.
       ***********************************************************************/
-      void RestoreLogSettings()
+      const LogCategoryInfo *CategoryInfo(const char *category_name)
       {
-         QSettings settings;
-         QStringList log_info = settings.value(LOG_STATUS, "").toString().split(",");
-         foreach (QString log_setting, log_info)
-         {
-            QStringList setting = log_setting.split(":");
-            QString log_name = setting[0];
-            QString cat_desc = (setting.count() > 1) ? setting[1] : "";
-            QString cat_levl = (setting.count() > 2) ? setting[2] : "0";
-
-            m_logLevels.insert(log_name, cat_levl.toInt()); 
-            m_logDescriptions.insert(log_name, cat_desc); 
-         }
+         return(Snapshot()->categoryInfo.value(category_name, NULL));
       }
 
-      void RegisterLog(QString log_name, unsigned int levels = 1, QString description = QString());
+      /********************************************************************//*
+      **   void SetLogSinks(QString log_name, unsigned int sinks)
+      **   
+      **   Selects  which  of  the  Logger's  outputs  the named log's
+      **   messages go to.
+      **   
+      **   Parameters
+      **   
+      **   log_name Name of the log
+      **   
+      **   sinks    Mask of LogSink bits
+      **   
+      **   Returns N/A
+      ***********************************************************************/
+      void SetLogSinks(QString log_name, unsigned int sinks)
+      {
+         Descriptor(log_name)->sinks.store(sinks, std::memory_order_relaxed);
+      }
 
       /********************************************************************//*
       **
@@ -136,24 +210,9 @@ namespace QcjLib
       ***********************************************************************/
       QLoggingCategory *category(QString log_name, unsigned int level = 1)
       {
-
-//         foreach (QString name, m_logMap.keys())
-//         {
-//            QLoggingCategory *cat = m_logMap.value(name);
-//            std::cout << __FUNCTION__ << " cat: " << qPrintable(name) << ", cat->name: " << cat->categoryName() << std::endl;
-//         }
-
          QString full_name = BuildName(log_name, level);
 //         std::cout << __FUNCTION__ << " full_name: " << qPrintable(full_name) << std::endl;
-         if ( m_logMap.contains(full_name) ) 
-         {
-//            std::cout << __FUNCTION__ << " found it!!" << std::endl;
-            return(m_logMap.value(full_name));
-         }
-         else 
-         {
-            return(m_defaultCategory);
-         }
+         return(Snapshot()->logMap.value(full_name, m_defaultCategory));
       }
 
       
@@ -171,12 +230,7 @@ namespace QcjLib
       ***********************************************************************/
       QString LogDescription(QString log_name)
       {
-         QString rv;
-         if ( m_logDescriptions.contains(log_name) ) 
-         {
-            rv = m_logDescriptions.value(log_name);
-         }
-         return(rv);
+         return(Snapshot()->logDescriptions.value(log_name));
       }
 
       /********************************************************************//*
@@ -193,12 +247,7 @@ namespace QcjLib
       ***********************************************************************/
       unsigned int LogLevel(QString log_name)
       {
-         unsigned int rv = 1;
-         if ( m_logLevels.contains(log_name) ) 
-         {
-            rv = m_logLevels.value(log_name);
-         }
-         return(rv);
+         return(Snapshot()->logLevels.value(log_name, 1));
       }
 
       
@@ -216,12 +265,7 @@ namespace QcjLib
       ***********************************************************************/
       unsigned int LogMaximumLevel(QString log_name)
       {
-         unsigned int rv = 0;
-         if ( m_logMaxLevels.contains(log_name) ) 
-         {
-            rv = m_logMaxLevels.value(log_name);
-         }
-         return(rv);
+         return(Snapshot()->logMaxLevels.value(log_name, 0));
       }
 
       /********************************************************************//*
@@ -239,7 +283,7 @@ namespace QcjLib
       {
          QStringList rv;
 
-         foreach (QString log, m_logLevels.keys())
+         foreach (QString log, Snapshot()->logLevels.keys())
          {
             QStringList sl(log.split(":"));
             rv << sl[0];
@@ -247,72 +291,31 @@ namespace QcjLib
          return(rv);
       }
 
-
       /********************************************************************//*
-      **   void  SetLogLevel(QString  log_name, unsigned int level = 1)
+      **   LogLimits LogLimit(QString log_name)
+      **   
+      **   Function  returning  the  rate  limit and sampling of the
+      **   requested log.
       **   
-      **   Dunction  to  set  the  logging  level  of the named log.
       **   Parameters
       **   
       **   log_name Name of the log
       **   
-      **   level Logging level
-      **   
-      **   Returns N/A
+      **   Returns LogLimits of the log, unlimited if none were set
       ***********************************************************************/
-      void SetLogLevel(QString log_name, unsigned int level = 1)
+      LogLimits LogLimit(QString log_name)
       {
-         QString msg_type;
-         if ( true ||  m_logLevels.contains(log_name) ) 
-         {
-            m_logLevels.insert(log_name, level);
-         }
-# if 0
-         switch (type) 
-         {
-            case QtDebugMsg:
-               msg_type = MSG_DEBUG_TYPE;
-               break;
-
-//            case QtInfoMsg:
-//               msg_type = MSG_INFO_TYPE;
-//               break;
-//
-            case QtWarningMsg:
-               msg_type = MSG_WARNING_TYPE;
-               break;
-
-            case QtCriticalMsg:
-               msg_type = MSG_CRITICAL_TYPE;
-               break;
-
-            case QtFatalMsg:
-               msg_type = MSG_CRITICAL_TYPE;
-               break;
-
-            default:
-               msg_type = MSG_DEBUG_TYPE;
-               break;
-         }
-         QString log_base_name = log_name + ":%." + msg_type;
-
-         for (unsigned int lvl = 1; lvl <= LogLevel(log_name); lvl++) 
-         {
-            QString log_descr = log_base_name;
-            log_descr.replace("%", QString::number(lvl));
-            if ( lvl <= level ) 
-            {
-               log_descr += "=true";
-            }
-            else 
-            {
-               log_descr += "=false";
-            }
-         }
-# endif
+         return(Snapshot()->logLimits.value(log_name));
       }
 
+      void SetLogLevel(QString log_name, unsigned int level = 1);
+      void SetLogLevels(const LogLevelsMap_t &levels);
+      void SetLogLimits(const LogLimitsMap_t &limits);
+
    protected:
+   private slots:
+      void ReportSuppressed();
+
    private:
 
       /********************************************************************//*
@@ -334,12 +337,30 @@ namespace QcjLib
          return(rv);
       }
 
-      QLoggingCategory*    m_defaultCategory;
-      LogRegisteryMap_t    m_logMap;
-      LogLevelsMap_t       m_logLevels;      
-      LogLevelsMap_t       m_logMaxLevels;
-      LogDescriptionMap_t  m_logDescriptions;
-      static LogRegistery* m_instance;
+      /********************************************************************//*
+      **   const LogRegisterySnapshot *Snapshot() private
+      **   
+      **   Returns  the  snapshot  currently  published. It stays valid
+      **   for the life of the application.
+      ***********************************************************************/
+      const LogRegisterySnapshot *Snapshot() const
+      {
+         return(m_snapshot.load(std::memory_order_acquire));
+      }
+
+      void ApplyLogLevel(const LogRegisterySnapshot *snap, QString log_name);
+      static void CategoryFilter(QLoggingCategory *category);
+      void Publish(LogRegisterySnapshot *snap);
+      void UpdateSummaryTimer(const LogRegisterySnapshot *snap);
+
+      QLoggingCategory*                         m_defaultCategory;
+      std::atomic<const LogRegisterySnapshot*>  m_snapshot;
+      QList<const LogRegisterySnapshot*>        m_retired;
+      QMutex                                    m_updateLock;
+      QTimer                                    *m_summaryTimer;
+
+      static std::atomic<LogRegistery*>         s_registery;
+      static QLoggingCategory::CategoryFilter   s_previousFilter;
    };
 };
 
@@ -0,0 +1,180 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef LOGRINGBUFFER_H
+#define LOGRINGBUFFER_H
+
+# include <QtGlobal>
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+namespace QcjLib
+{
+   /********************************************************************//*
+   **   template <typename T> class LogRingBuffer
+   **   
+   **   Bounded  lock-free  queue  used  to  hand  log records from
+   **   the  threads producing them to the Logger's writer thread.
+   **   Any  number  of  threads may push and pop concurrently. The
+   **   capacity is rounded up to the next power of two.
+   **
+   **   Each  cell carries a sequence number telling producers and
+   **   consumers  whether  it  is  free  or  filled  for  the lap
+   **   they are on, so neither side ever takes a lock.
+   ***********************************************************************/
+   template <typename T> class LogRingBuffer
+   {
+   public:
+      LogRingBuffer(size_t capacity)
+      {
+         size_t size = 2;
+         while ( size < capacity ) 
+         {
+            size <<= 1;
+         }
+         m_mask = size - 1;
+         m_cells = new Cell[size];
+         for (size_t x = 0; x < size; x++) 
+         {
+            m_cells[x].sequence.store(x, std::memory_order_relaxed);
+         }
+         m_pushPos.store(0, std::memory_order_relaxed);
+         m_popPos.store(0, std::memory_order_relaxed);
+      }
+
+      ~LogRingBuffer()
+      {
+         delete [] m_cells;
+      }
+
+      size_t Capacity() const
+      {
+         return(m_mask + 1);
+      }
+
+      /********************************************************************//*
+      **   bool TryPush(T &item)
+      **   
+      **   Moves  item  into  the queue if there is room for it. On
+      **   failure item is left untouched.
+      **   
+      **   Returns true if the item was queued, false if full.
+      ***********************************************************************/
+      bool TryPush(T &item)
+      {
+         Cell *cell;
+         size_t pos = m_pushPos.load(std::memory_order_relaxed);
+         for (;;) 
+         {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if ( diff == 0 ) 
+            {
+               if ( m_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed) ) 
+               {
+                  break;
+               }
+            }
+            else if ( diff < 0 ) 
+            {
+               return(false);
+            }
+            else 
+            {
+               pos = m_pushPos.load(std::memory_order_relaxed);
+            }
+         }
+         cell->data = std::move(item);
+         cell->sequence.store(pos + 1, std::memory_order_release);
+         return(true);
+      }
+
+      /********************************************************************//*
+      **   bool TryPop(T &item)
+      **   
+      **   Moves the oldest queued item into item.
+      **   
+      **   Returns true if an item was taken, false if empty.
+      ***********************************************************************/
+      bool TryPop(T &item)
+      {
+         Cell *cell;
+         size_t pos = m_popPos.load(std::memory_order_relaxed);
+         for (;;) 
+         {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if ( diff == 0 ) 
+            {
+               if ( m_popPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed) ) 
+               {
+                  break;
+               }
+            }
+            else if ( diff < 0 ) 
+            {
+               return(false);
+            }
+            else 
+            {
+               pos = m_popPos.load(std::memory_order_relaxed);
+            }
+         }
+         item = std::move(cell->data);
+         cell->data = T();
+         cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+         return(true);
+      }
+
+      bool IsEmpty() const
+      {
+         return(m_popPos.load(std::memory_order_acquire) >= 
+                m_pushPos.load(std::memory_order_acquire));
+      }
+
+   private:
+      Q_DISABLE_COPY(LogRingBuffer)
+
+      struct Cell
+      {
+         std::atomic<size_t>  sequence;
+         T                    data;
+      };
+
+      Cell                 *m_cells;
+      size_t               m_mask;
+      alignas(64) std::atomic<size_t>  m_pushPos;
+      alignas(64) std::atomic<size_t>  m_popPos;
+   };
+};
+
+#endif
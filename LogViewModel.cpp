@@ -0,0 +1,454 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+# include "LogViewModel.h"
+# include "Logger.h"
+
+# include <QRegularExpression>
+
+using namespace QcjLib;
+
+const int LogViewModel::DEFAULT_CAPACITY = 1000000;
+
+LogViewModel::LogViewModel(int capacity, QObject *parent) :
+   QAbstractListModel(parent),
+   m_capacity(qMax(capacity, 1)),
+   m_firstSeq(0),
+   m_nextSeq(0),
+   m_matchStart(0),
+   m_filterLevel(0)
+{
+}
+
+/********************************************************************//*
+**   void LogViewModel::Attach(bool attach)
+**   
+**   Connects  or disconnects the shared model instance to the
+**   Logger's LogRecords() batches.
+***********************************************************************/
+void LogViewModel::Attach(bool attach)
+{
+   if ( attach ) 
+   {
+      QObject::connect(Logger::instance(), SIGNAL(LogRecords(QVector<QcjLib::LogRecord>)),
+                       instance(), SLOT(AppendRecords(QVector<QcjLib::LogRecord>)),
+                       Qt::UniqueConnection);
+   }
+   else 
+   {
+      QObject::disconnect(Logger::instance(), SIGNAL(LogRecords(QVector<QcjLib::LogRecord>)),
+                          instance(), SLOT(AppendRecords(QVector<QcjLib::LogRecord>)));
+   }
+}
+
+int LogViewModel::rowCount(const QModelIndex &parent) const
+{
+   int rv = 0;
+
+   if ( ! parent.isValid() ) 
+   {
+      if ( IsFiltered() ) 
+         rv = m_matches.size() - m_matchStart;
+      else
+         rv = (int)(m_nextSeq - m_firstSeq);
+   }
+   return(rv);
+}
+
+QVariant LogViewModel::data(const QModelIndex &index, int role) const
+{
+   QVariant rv;
+
+   if ( index.isValid() && index.row() < rowCount() ) 
+   {
+      const LogRecord &rec = At(SeqForRow(index.row()));
+      switch ( role ) 
+      {
+         case Qt::DisplayRole:
+            rv = DisplayText(rec);
+            break;
+
+         case CategoryRole:
+            rv = rec.category;
+            break;
+
+         case LevelRole:
+            rv = rec.level;
+            break;
+
+         case TypeRole:
+            rv = (int)rec.type;
+            break;
+
+         case FieldsRole:
+         {
+            QVariantMap fields;
+            foreach (const LogArg &arg, rec.args)
+            {
+               if ( arg.key != NULL ) 
+               {
+                  QString value;
+                  Logger::FormatArg(arg, value);
+                  fields.insert(arg.key, value);
+               }
+            }
+            rv = fields;
+            break;
+         }
+
+         default:
+            break;
+      }
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   void LogViewModel::SetCapacity(int capacity)
+**   
+**   Changes the number of records held. Any records held are lost.
+***********************************************************************/
+void LogViewModel::SetCapacity(int capacity)
+{
+   capacity = qMax(capacity, 1);
+   if ( capacity != m_capacity ) 
+   {
+      beginResetModel();
+      m_capacity = capacity;
+      m_ring.clear();
+      m_ring.squeeze();
+      m_firstSeq = m_nextSeq = 0;
+      m_matches.clear();
+      m_matchStart = 0;
+      endResetModel();
+   }
+}
+
+/********************************************************************//*
+**   void LogViewModel::SetFilter(QString category, 
+**                                unsigned int max_level, QString text)
+**   
+**   Limits  the  rows to records from the log category with a level
+**   of  max_level  or less whose text contains text. An empty 
+**   category, a max_level of 0 or an empty text disable that part
+**   of the filter.
+**   
+**   If  the  new  filter  can  only  match a subset of what the
+**   current filter matches, only the current matches are
+**   rechecked, otherwise every record held is scanned.
+***********************************************************************/
+void LogViewModel::SetFilter(QString category, unsigned int max_level, QString text)
+{
+   bool was_filtered = IsFiltered();
+   bool narrower = (m_filterCategory.isEmpty() || category == m_filterCategory) &&
+                   (m_filterLevel == 0 || (max_level > 0 && max_level <= m_filterLevel)) &&
+                   text.contains(m_filterText, Qt::CaseInsensitive);
+
+   beginResetModel();
+   m_filterCategory = category;
+   m_filterLevel = max_level;
+   m_filterText = text;
+   Refilter(was_filtered && narrower);
+   endResetModel();
+}
+
+/********************************************************************//*
+**   bool LogViewModel::SetFieldFilter(QString expression)
+**   
+**   Limits  the rows to structured records with a field matching
+**   expression,  which  is  "key  op  value"  where op is one of =,
+**   !=,  <,  <=,  >  or  >=.  Numeric fields are compared as numbers,
+**   others  as  strings.  An  empty  expression removes the field
+**   filter.
+**   
+**   Returns false if expression could not be parsed, in which case
+**   the filter is left alone.
+***********************************************************************/
+bool LogViewModel::SetFieldFilter(QString expression)
+{
+   static const QRegularExpression field_re("^\\s*(\\w+)\\s*(!=|<=|>=|=|<|>)\\s*(.*?)\\s*$");
+   QString field, op, value;
+
+   if ( ! expression.trimmed().isEmpty() ) 
+   {
+      QRegularExpressionMatch match = field_re.match(expression);
+      if ( ! match.hasMatch() ) 
+         return(false);
+      field = match.captured(1);
+      op = match.captured(2);
+      value = match.captured(3);
+   }
+
+   bool was_filtered = IsFiltered();
+   bool narrower = m_filterField.isEmpty();
+
+   beginResetModel();
+   m_filterField = field;
+   m_filterOp = op;
+   m_filterValue = value;
+   Refilter(was_filtered && narrower);
+   endResetModel();
+   return(true);
+}
+
+/********************************************************************//*
+**   void LogViewModel::AppendRecords(QVector<QcjLib::LogRecord> records)
+**   
+**   Adds a batch of records to the end of the model, evicting the
+**   oldest records if the ring is full. Views see at most one row
+**   removal and one row insertion per batch.
+***********************************************************************/
+void LogViewModel::AppendRecords(QVector<QcjLib::LogRecord> records)
+{
+   int skip = qMax(records.size() - m_capacity, 0);
+   int count = records.size() - skip;
+   qint64 new_next = m_nextSeq + count;
+   qint64 new_first = qMax(m_firstSeq, new_next - m_capacity);
+
+   if ( count == 0 ) 
+      return;
+
+   /***********************************************/
+   /*   Drop the rows the new records will        */
+   /*   overwrite.                                */
+   /***********************************************/
+   if ( new_first > m_firstSeq ) 
+   {
+      if ( IsFiltered() ) 
+      {
+         int evict = 0;
+         while ( m_matchStart + evict < m_matches.size() && 
+                 m_matches.at(m_matchStart + evict) < new_first ) 
+            evict++;
+
+         if ( evict > 0 ) 
+         {
+            beginRemoveRows(QModelIndex(), 0, evict - 1);
+            m_matchStart += evict;
+            m_firstSeq = new_first;
+            endRemoveRows();
+         }
+         else 
+            m_firstSeq = new_first;
+
+         if ( m_matchStart > m_matches.size() / 2 ) 
+         {
+            m_matches.remove(0, m_matchStart);
+            m_matchStart = 0;
+         }
+      }
+      else 
+      {
+         beginRemoveRows(QModelIndex(), 0, (int)(new_first - m_firstSeq) - 1);
+         m_firstSeq = new_first;
+         endRemoveRows();
+      }
+   }
+
+   /***********************************************/
+   /*   Store the records. The slots written are  */
+   /*   not part of any row yet.                  */
+   /***********************************************/
+   QVector<qint64> matched;
+   qint64 seq = m_nextSeq;
+   for (int x = skip; x < records.size(); x++, seq++) 
+   {
+      LogRecord &rec = records[x];
+      if ( rec.isFormatted() ) 
+      {
+         if ( rec.text.endsWith('\n') ) 
+            rec.text.chop(1);
+         rec.message.clear();
+      }
+
+      if ( m_ring.size() < m_capacity ) 
+         m_ring.append(rec);
+      else 
+         m_ring[seq % m_capacity] = rec;
+
+      if ( IsFiltered() && Matches(rec) ) 
+         matched.append(seq);
+   }
+
+   int first_row = rowCount();
+   if ( IsFiltered() ) 
+   {
+      m_nextSeq = new_next;
+      if ( matched.size() > 0 ) 
+      {
+         beginInsertRows(QModelIndex(), first_row, first_row + matched.size() - 1);
+         m_matches += matched;
+         endInsertRows();
+      }
+   }
+   else 
+   {
+      beginInsertRows(QModelIndex(), first_row, first_row + count - 1);
+      m_nextSeq = new_next;
+      endInsertRows();
+   }
+}
+
+void LogViewModel::Clear()
+{
+   beginResetModel();
+   m_ring.clear();
+   m_firstSeq = m_nextSeq = 0;
+   m_matches.clear();
+   m_matchStart = 0;
+   endResetModel();
+}
+
+bool LogViewModel::Matches(const LogRecord &rec) const
+{
+   bool rv = true;
+
+   if ( ! m_filterCategory.isEmpty() && rec.category != m_filterCategory ) 
+      rv = false;
+   else if ( m_filterLevel > 0 && rec.level > m_filterLevel ) 
+      rv = false;
+   else if ( ! m_filterField.isEmpty() && ! MatchesField(rec) ) 
+      rv = false;
+   else if ( ! m_filterText.isEmpty() && ! DisplayText(rec).contains(m_filterText, Qt::CaseInsensitive) ) 
+      rv = false;
+   return(rv);
+}
+
+bool LogViewModel::MatchesField(const LogRecord &rec) const
+{
+   foreach (const LogArg &arg, rec.args)
+   {
+      if ( arg.key == NULL || m_filterField != QLatin1String(arg.key) ) 
+         continue;
+
+      int cmp;
+      bool numeric;
+      double wanted = m_filterValue.toDouble(&numeric);
+      if ( numeric && arg.type != LogArg::String && arg.type != LogArg::Pointer ) 
+      {
+         double value = arg.type == LogArg::Int ? (double)arg.i : 
+                        arg.type == LogArg::UInt ? (double)arg.u : arg.d;
+         cmp = value < wanted ? -1 : (value > wanted ? 1 : 0);
+      }
+      else 
+      {
+         QString value;
+         Logger::FormatArg(arg, value);
+         cmp = QString::compare(value, m_filterValue);
+      }
+
+      if ( m_filterOp == "=" ) 
+         return(cmp == 0);
+      else if ( m_filterOp == "!=" ) 
+         return(cmp != 0);
+      else if ( m_filterOp == "<" ) 
+         return(cmp < 0);
+      else if ( m_filterOp == "<=" ) 
+         return(cmp <= 0);
+      else if ( m_filterOp == ">" ) 
+         return(cmp > 0);
+      else
+         return(cmp >= 0);
+   }
+   return(false);
+}
+
+/********************************************************************//*
+**   QString LogViewModel::DisplayText(const LogRecord &rec)
+**   
+**   Returns  the  line shown for a record, formatting it if it was
+**   not formatted when it was logged.
+***********************************************************************/
+QString LogViewModel::DisplayText(const LogRecord &rec)
+{
+   QString rv;
+
+   if ( rec.isFormatted() ) 
+   {
+      rv = rec.text;
+   }
+   else 
+   {
+      Logger::FormatRecord(rec, rv);
+      if ( rv.endsWith('\n') ) 
+         rv.chop(1);
+   }
+   return(rv);
+}
+
+qint64 LogViewModel::SeqForRow(int row) const
+{
+   qint64 rv;
+
+   if ( IsFiltered() ) 
+      rv = m_matches.at(m_matchStart + row);
+   else
+      rv = m_firstSeq + row;
+   return(rv);
+}
+
+/********************************************************************//*
+**   void LogViewModel::Refilter(bool narrower)
+**   
+**   Rebuilds  the  match  index  after the filter changed. When the
+**   new  filter  can  only  match  a  subset  of what the old one
+**   matched, only the old matches are rechecked.
+***********************************************************************/
+void LogViewModel::Refilter(bool narrower)
+{
+   if ( ! IsFiltered() ) 
+   {
+      m_matches.clear();
+      m_matchStart = 0;
+   }
+   else if ( narrower ) 
+   {
+      int out = 0;
+      for (int x = m_matchStart; x < m_matches.size(); x++) 
+      {
+         if ( Matches(At(m_matches.at(x))) ) 
+            m_matches[out++] = m_matches.at(x);
+      }
+      m_matches.resize(out);
+      m_matchStart = 0;
+   }
+   else 
+   {
+      Rescan();
+   }
+}
+
+void LogViewModel::Rescan()
+{
+   m_matches.clear();
+   m_matchStart = 0;
+   for (qint64 seq = m_firstSeq; seq < m_nextSeq; seq++) 
+   {
+      if ( Matches(At(seq)) ) 
+         m_matches.append(seq);
+   }
+}
@@ -0,0 +1,139 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef LOGVIEWMODEL_H
+#define LOGVIEWMODEL_H
+
+# include <QAbstractListModel>
+# include <QString>
+# include <QVector>
+
+# include "LogRecord.h"
+
+namespace QcjLib
+{
+   /********************************************************************//*
+   **   class LogViewModel
+   **   
+   **   List  model  holding  the  most recent log records fed to it
+   **   by  the  Logger's  LogRecords()  batches.  Records are kept in
+   **   a  fixed size ring, once it is full each new record replaces
+   **   the oldest one.
+   **
+   **   Records  that  arrive  unformatted  are  kept that way and only
+   **   formatted when a row is shown or matched against the text
+   **   filter.
+   **
+   **   The  model  can  be  filtered  by log name, maximum level, a
+   **   case  insensitive  substring  and  a  field  expression  on the
+   **   fields  of  structured  records,  see  SetFieldFilter().  While a filter is set the
+   **   model  keeps  a vector of the sequence numbers of the matching
+   **   records.  Appending  and  evicting  records only touches the
+   **   ends  of  that  vector,  and  narrowing  the  filter, such as
+   **   typing more of the substring, only rechecks the records that
+   **   already matched.
+   ***********************************************************************/
+   class LogViewModel : public QAbstractListModel
+   {
+      Q_OBJECT
+
+   public:
+      enum
+      {
+         CategoryRole = Qt::UserRole + 1,
+         LevelRole,
+         TypeRole,
+         FieldsRole
+      };
+
+      LogViewModel(int capacity = DEFAULT_CAPACITY, QObject *parent = NULL);
+
+      static LogViewModel *instance()
+      {
+         static LogViewModel *instance = new LogViewModel();
+         return(instance);
+      }
+
+      static void Attach(bool attach);
+
+      int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+      QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+      void SetCapacity(int capacity);
+      void SetFilter(QString category, unsigned int max_level, QString text);
+      bool SetFieldFilter(QString expression);
+
+      int Capacity() const
+      {
+         return(m_capacity);
+      }
+
+      static const int  DEFAULT_CAPACITY;
+
+   public slots:
+      void AppendRecords(QVector<QcjLib::LogRecord> records);
+      void Clear();
+
+   protected:
+   private:
+      bool IsFiltered() const
+      {
+         return(! m_filterCategory.isEmpty() || m_filterLevel > 0 || ! m_filterText.isEmpty() ||
+                ! m_filterField.isEmpty());
+      }
+
+      const LogRecord &At(qint64 seq) const
+      {
+         return(m_ring.at(seq % m_capacity));
+      }
+
+      static QString DisplayText(const LogRecord &rec);
+
+      bool     MatchesField(const LogRecord &rec) const;
+      bool     Matches(const LogRecord &rec) const;
+      void     Refilter(bool narrower);
+      qint64   SeqForRow(int row) const;
+      void     Rescan();
+
+      QVector<LogRecord>   m_ring;
+      int                  m_capacity;
+      qint64               m_firstSeq;
+      qint64               m_nextSeq;
+
+      QVector<qint64>      m_matches;
+      int                  m_matchStart;
+
+      QString              m_filterCategory;
+      unsigned int         m_filterLevel;
+      QString              m_filterText;
+      QString              m_filterField;
+      QString              m_filterOp;
+      QString              m_filterValue;
+   };
+}
+
+#endif
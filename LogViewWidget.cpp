@@ -0,0 +1,137 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+# include "LogViewWidget.h"
+# include "LogRegistery.h"
+
+# include <QFontDatabase>
+# include <QHBoxLayout>
+# include <QLabel>
+# include <QScrollBar>
+# include <QVBoxLayout>
+
+using namespace QcjLib;
+
+LogViewWidget::LogViewWidget(QWidget *parent, LogViewModel *model) :
+   QWidget(parent),
+   m_model(model),
+   m_follow(true)
+{
+   QVBoxLayout *layout = new QVBoxLayout(this);
+   QHBoxLayout *filter_layout = new QHBoxLayout();
+
+   m_categoryCombo = new QComboBox(this);
+   m_levelSpin = new QSpinBox(this);
+   m_levelSpin->setRange(0, 9);
+   m_levelSpin->setSpecialValueText("All");
+   m_textEdit = new QLineEdit(this);
+   m_textEdit->setPlaceholderText("Filter");
+   m_textEdit->setClearButtonEnabled(true);
+   m_fieldEdit = new QLineEdit(this);
+   m_fieldEdit->setPlaceholderText("field = value");
+   m_fieldEdit->setClearButtonEnabled(true);
+
+   filter_layout->addWidget(new QLabel("Log", this));
+   filter_layout->addWidget(m_categoryCombo);
+   filter_layout->addWidget(new QLabel("Level", this));
+   filter_layout->addWidget(m_levelSpin);
+   filter_layout->addWidget(m_textEdit, 1);
+   filter_layout->addWidget(m_fieldEdit);
+   layout->addLayout(filter_layout);
+
+   /***********************************************/
+   /*   Uniform item sizes keep the view from     */
+   /*   measuring every row of the model.         */
+   /***********************************************/
+   m_listView = new QListView(this);
+   m_listView->setUniformItemSizes(true);
+   m_listView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+   m_listView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+   m_listView->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+   m_listView->setModel(m_model);
+   layout->addWidget(m_listView);
+
+   connect(m_categoryCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(SlotApplyFilter()));
+   connect(m_levelSpin, SIGNAL(valueChanged(int)), this, SLOT(SlotApplyFilter()));
+   connect(m_textEdit, SIGNAL(textChanged(QString)), this, SLOT(SlotApplyFilter()));
+   connect(m_fieldEdit, SIGNAL(editingFinished()), this, SLOT(SlotApplyFieldFilter()));
+   connect(m_model, SIGNAL(rowsAboutToBeInserted(QModelIndex,int,int)), this, SLOT(SlotRowsAboutToBeInserted()));
+   connect(m_model, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(SlotRowsInserted()));
+
+   Initialize();
+}
+
+/********************************************************************//*
+**   void LogViewWidget::Initialize()
+**   
+**   Fills the log name selector from the LogRegistery.
+***********************************************************************/
+void LogViewWidget::Initialize()
+{
+   QString current = m_categoryCombo->currentData().toString();
+   QStringList cat_names = LogRegistery::instance()->LogList();
+
+   cat_names.sort();
+   m_categoryCombo->blockSignals(true);
+   m_categoryCombo->clear();
+   m_categoryCombo->addItem("All", QString());
+   foreach (QString cat_name, cat_names)
+   {
+      if ( ! cat_name.isEmpty() ) 
+         m_categoryCombo->addItem(cat_name, cat_name);
+   }
+   m_categoryCombo->setCurrentIndex(qMax(m_categoryCombo->findData(current), 0));
+   m_categoryCombo->blockSignals(false);
+}
+
+void LogViewWidget::SlotApplyFilter()
+{
+   m_model->SetFilter(m_categoryCombo->currentData().toString(), 
+                      m_levelSpin->value(), m_textEdit->text());
+   if ( m_follow ) 
+      m_listView->scrollToBottom();
+}
+
+void LogViewWidget::SlotApplyFieldFilter()
+{
+   bool valid = m_model->SetFieldFilter(m_fieldEdit->text());
+   m_fieldEdit->setStyleSheet(valid ? QString() : QString("color: red"));
+   if ( valid && m_follow ) 
+      m_listView->scrollToBottom();
+}
+
+void LogViewWidget::SlotRowsAboutToBeInserted()
+{
+   QScrollBar *bar = m_listView->verticalScrollBar();
+   m_follow = bar->value() >= bar->maximum();
+}
+
+void LogViewWidget::SlotRowsInserted()
+{
+   if ( m_follow ) 
+      m_listView->scrollToBottom();
+}
@@ -0,0 +1,75 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef LOGVIEWWIDGET_H
+#define LOGVIEWWIDGET_H
+
+# include <QComboBox>
+# include <QLineEdit>
+# include <QListView>
+# include <QSpinBox>
+# include <QWidget>
+
+# include "LogViewModel.h"
+
+namespace QcjLib
+{
+   /********************************************************************//*
+   **   class LogViewWidget
+   **   
+   **   Displays  a  LogViewModel  in  a  list view with controls to
+   **   filter  it  by  log name, level, text and field. The view follows new
+   **   records as long as it is scrolled to the bottom.
+   ***********************************************************************/
+   class LogViewWidget : public QWidget
+   {
+      Q_OBJECT
+
+   public:
+      LogViewWidget(QWidget *parent = NULL, LogViewModel *model = LogViewModel::instance());
+
+   public slots:
+      void Initialize();
+
+   protected slots:
+      void SlotApplyFieldFilter();
+      void SlotApplyFilter();
+      void SlotRowsAboutToBeInserted();
+      void SlotRowsInserted();
+
+   private:
+      LogViewModel  *m_model;
+      QComboBox     *m_categoryCombo;
+      QSpinBox      *m_levelSpin;
+      QLineEdit     *m_textEdit;
+      QLineEdit     *m_fieldEdit;
+      QListView     *m_listView;
+      bool           m_follow;
+   };
+}
+
+#endif
@@ -27,72 +27,1203 @@
 /******************************************************************************/
 # include "Logger.h"
 # include "LogRegistery.h"
+# include "MetricBuilder.h"
 
+# include  <QCoreApplication>
+# include  <QDateTime>
+# include  <QDir>
 # include  <QFile>
+# include  <QRegularExpression>
+# include  <QRunnable>
+# include  <QThreadPool>
 # include  <QTime>
 
-# include  <stdlib.h>
+# include  <QMetaMethod>
+
+# include  <chrono>
+# include  <limits.h>
 # include  <stdlib.h>
 
 using namespace QcjLib;
 
-QcjLib::Logger* QcjLib::Logger::m_instance = NULL;
+const int QcjLib::Logger::DEFAULT_QUEUE_SIZE = 8192;
+const int QcjLib::Logger::DEFAULT_BATCH_SIZE = 500;
+const int QcjLib::Logger::DEFAULT_BATCH_INTERVAL_MS = 100;
 
-void myMessageOutput(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+static const int  WRITER_BATCH_SIZE    = 256;
+static const int  WRITER_IDLE_WAIT_MS  = 100;
+
+static const QString ROTATED_SUFFIX_FORMAT ("yyyyMMdd-hhmmsszzz");
+static const QString COMPRESSED_SUFFIX     (".qz");
+
+/********************************************************************//*
+**   class LogRotationJob
+**   
+**   Background  work  for  a  rotated  log  segment. Compresses it
+**   with  qCompress()  if asked to and then removes the oldest
+**   rotated  segments  of  the log beyond the number to keep. The
+**   compressed   segments   can   be   read  back  with  qUncompress().
+***********************************************************************/
+class LogRotationJob : public QRunnable
 {
-   QString str(context.category);
-//   std::cout << __FUNCTION__ <<  " str: |" << qPrintable(str) << "|" << std::endl;
-   QStringList sl = str.split(":");
-   QString category = sl[0];
-   unsigned int level = 1;
+public:
+   LogRotationJob(QString log_name, QString segment, int keep_count, bool compress) :
+      m_logName(log_name),
+      m_segment(segment),
+      m_keepCount(keep_count),
+      m_compress(compress)
+   {}
 
-   QString msg_buf;
-   QTextStream buf(&msg_buf);
+   void run() override
+   {
+      if ( m_compress ) 
+      {
+         QFile in(m_segment);
+         QFile out(m_segment + COMPRESSED_SUFFIX + ".tmp");
+         if ( in.open(QIODevice::ReadOnly) && out.open(QIODevice::WriteOnly) ) 
+         {
+            QByteArray data = qCompress(in.readAll());
+            if ( out.write(data) == data.size() ) 
+            {
+               out.close();
+               in.close();
+               QFile::rename(out.fileName(), m_segment + COMPRESSED_SUFFIX);
+               QFile::remove(m_segment);
+            }
+            else 
+            {
+               out.remove();
+            }
+         }
+      }
 
-   if ( sl.count() > 1 ) 
+      if ( m_keepCount > 0 ) 
+      {
+         QFileInfo fi(m_logName);
+         QDir dir = fi.absoluteDir();
+         QRegularExpression re("^" + QRegularExpression::escape(fi.fileName()) + 
+                               "\\.\\d{8}-\\d{9}(" + QRegularExpression::escape(COMPRESSED_SUFFIX) + ")?$");
+         QStringList segments;
+         foreach (QString name, dir.entryList(QStringList() << fi.fileName() + ".*", QDir::Files, QDir::Name))
+         {
+            if ( re.match(name).hasMatch() ) 
+            {
+               segments << name;
+            }
+         }
+         /*********************************************************/
+         /*   The  time  stamp  suffix  sorts by name in the order  */
+         /*   the segments were rotated, oldest first.              */
+         /*********************************************************/
+         while ( segments.count() > m_keepCount ) 
+         {
+            dir.remove(segments.takeFirst());
+         }
+      }
+   }
+
+private:
+   QString  m_logName;
+   QString  m_segment;
+   int      m_keepCount;
+   bool     m_compress;
+};
+
+/***********************************************/
+/*   Function local so it can be used from     */
+/*   other static constructors.                */
+/***********************************************/
+static const MetricCounter &DroppedMetric()
+{
+   static MetricCounter counter("qcjlib_log_dropped_total", "Log records dropped because the async queue was full");
+   return(counter);
+}
+
+static QThreadPool *RotationPool()
+{
+   static QThreadPool *pool = NULL;
+   if ( pool == NULL ) 
    {
-      level = sl[1].toInt();
+      pool = new QThreadPool();
+      pool->setMaxThreadCount(1);
    }
-//   std::cout << __FUNCTION__ <<  " context->category: " << qPrintable(category) << ", level: " << level << ", logging level: " << QcjLib::LogRegistery::instance()->LogLevel(category) << std::endl;
+   return(pool);
+}
+
+void myMessageOutput(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+   LogRecord rec;
+   const LogCategoryInfo *info = QcjLib::LogRegistery::instance()->CategoryInfo(context.category);
 
-   if ( QcjLib::LogRegistery::instance()->LogLevel(category) >= level ) 
+   if ( info != NULL ) 
    {
-//      buf << category << ":" << level << "::" ;
-      buf << QTime::currentTime().toString("hh:mm:ss") << ": ";
-      switch (type)
+      /************************************************************/
+      /*   The level only gates debug and info output, warnings   */
+      /*   and worse always get through.                          */
+      /************************************************************/
+      if ( (type == QtDebugMsg || type == QtInfoMsg) && ! info->IsEnabled() ) 
       {
-         case QtDebugMsg:
-            buf << "Debug: ";
-            break;
-
-         case QtWarningMsg:
-            buf << "Warning: ";
-            break;
+         return;
+      }
 
-         case QtCriticalMsg:
-            buf << "Critical: ";
-            break;
+      qint64 now = QcjLib::Logger::MonotonicNs();
+      if ( type != QtFatalMsg && ! info->descriptor->Admit(now) ) 
+      {
+         return;
+      }
+      QcjLib::Logger::instance()->ReportSuppressed(info->descriptor, now);
+      rec.level = info->level;
+      rec.sinks = info->descriptor->sinks.load(std::memory_order_relaxed);
+      rec.category = info->descriptor->name;
+   }
+   else 
+   {
+      /************************************************************/
+      /*   Not  one  of  the registry's categories, fall back to    */
+      /*   parsing the name and level out of the category name.     */
+      /************************************************************/
+      QString str(context.category);
+//      std::cout << __FUNCTION__ <<  " str: |" << qPrintable(str) << "|" << std::endl;
+      QStringList sl = str.split(":");
+      rec.category = sl[0];
 
-         case QtFatalMsg:
-            buf << "FATAL: " << msg << Qt::endl;
-            QcjLib::Logger::instance()->LogMessage(msg_buf);
-            abort();
+      if ( sl.count() > 1 ) 
+      {
+         rec.level = sl[1].toInt();
       }
-      buf << context.function << ": " << msg << Qt::endl;
-      QcjLib::Logger::instance()->LogMessage(msg_buf);
+//      std::cout << __FUNCTION__ <<  " context->category: " << qPrintable(rec.category) << ", level: " << rec.level << ", logging level: " << QcjLib::LogRegistery::instance()->LogLevel(rec.category) << std::endl;
+      if ( QcjLib::LogRegistery::instance()->LogLevel(rec.category) < rec.level ) 
+      {
+         return;
+      }
+   }
+
+   rec.type = type;
+   rec.threadId = QcjLib::Logger::CurrentThreadId();
+   rec.function = context.function;
+   rec.timestamp = QDateTime::currentMSecsSinceEpoch();
+   rec.monotonic = QcjLib::Logger::MonotonicNs();
+   rec.message = msg;
+
+   if ( type == QtFatalMsg ) 
+   {
+      /************************************************************/
+      /*   Make  sure  everything  queued  ahead  of  the  fatal    */
+      /*   message as well as the message itself hits the sinks     */
+      /*   before we go down.                                       */
+      /************************************************************/
+      rec.text = QcjLib::Logger::FormatRecord(rec);
+      QcjLib::Logger::instance()->Submit(rec);
+      QcjLib::Logger::instance()->Flush();
+      abort();
    }
+   QcjLib::Logger::instance()->Submit(rec);
+}
+
+static void StopAsyncLogging()
+{
+   QcjLib::Logger::instance()->SetAsync(false);
+}
+
+static void StopDatabaseLogging()
+{
+   QcjLib::Logger::instance()->SetDatabaseLogFile("");
 }
 
-QcjLib::Logger::Logger(QObject *parent) : QObject(parent)
+QcjLib::Logger::Logger(QObject *parent) : 
+   QObject(parent),
+   m_consoleEnable(true),
+   m_logFileBytes(0),
+   m_logFileOpened(0),
+   m_sqlLog(NULL),
+   m_batchMaxMessages(0),
+   m_batchMaxInterval(DEFAULT_BATCH_INTERVAL_MS),
+   m_batchFlushTimer(NULL),
+   m_rotateMaxBytes(0),
+   m_rotateMaxAge(0),
+   m_rotateKeep(0),
+   m_rotateCompress(false),
+   m_queue(NULL),
+   m_overflowPolicy(OverflowBlock),
+   m_dropped(0),
+   m_writer(NULL),
+   m_writerStop(false),
+   m_writerIdle(false)
 {
    QFile *out = new QFile(); 
    out->open(stdout, QIODevice::WriteOnly);
    m_consoleStream.setDevice(out);
+   qRegisterMetaType<QVector<QcjLib::LogRecord> >("QVector<QcjLib::LogRecord>");
    qInstallMessageHandler(myMessageOutput);
 }
 
 QcjLib::Logger::~Logger()
 {
+   SetAsync(false);
 }
 
+/********************************************************************//*
+**   bool Logger::SetLogFile(QString filename)
+**   
+**   Opens  filename  as  the  log  file,  closing any previous one.
+**   An  existing  file  is  moved  aside, either rotated according
+**   to  the  rotation  policy  or,  if  there is none, renamed to
+**   <filename>.1.  An  empty filename closes the log file.
+**   
+**   Returns true if the file could be opened.
+***********************************************************************/
+bool QcjLib::Logger::SetLogFile(QString filename)
+{
+   bool rv = true;
+   QMutexLocker lock(&m_writeLock);
+
+   if ( ! filename.isEmpty() ) 
+   {
+      if ( m_logFile.isOpen() ) 
+      {
+         m_deviceStream.flush();
+         m_logFile.close();
+      }
+
+      m_logFileName = filename;
+      if ( QFileInfo::exists(filename) ) 
+      {
+         if ( m_rotateMaxBytes > 0 || m_rotateMaxAge > 0 || m_rotateKeep > 0 ) 
+         {
+            std::cout << __FUNCTION__ << " Rotating existing log file" << std::endl;
+            RotateLogFile();
+            return(m_logFile.isOpen());
+         }
+         std::cout << __FUNCTION__ << " Renaming existing log file" << std::endl;
+         QFile::remove(filename + ".1");
+         if ( ! QFile::rename(filename, filename + ".1") ) 
+         {
+            std::cerr << __FUNCTION__ << " Could not rename " << qPrintable(filename) << ", appending to it" << std::endl;
+            return(OpenLogFile(true));
+         }
+      }
+
+      std::cout << __FUNCTION__ << " Opeing log file" << std::endl;
+      rv = OpenLogFile();
+   }
+   else if ( m_logFile.isOpen() ) 
+   {
+      m_deviceStream.flush();
+      m_logFile.close();
+      m_logFileName.clear();
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   bool Logger::SetBinaryLogFile(QString filename)
+**   
+**   Opens  filename  for  the  binary  sink,  which  writes records
+**   in  the  layout  of  BinaryLogFormat.h  without  formatting  them.
+**   Use  the  LogDecode  tool  to  turn  the file back into text. An
+**   empty filename closes the binary sink.
+**   
+**   Returns true if the file could be opened.
+***********************************************************************/
+bool QcjLib::Logger::SetBinaryLogFile(QString filename)
+{
+   bool rv = true;
+   QMutexLocker lock(&m_writeLock);
+
+   if ( ! filename.isEmpty() ) 
+   {
+      rv = m_binaryLog.Open(filename);
+   }
+   else 
+   {
+      m_binaryLog.Close();
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   bool Logger::SetFlightRecorderFile(QString filename, qint64 capacity)
+**   
+**   Opens  filename  for  the  flight  recorder  sink, which keeps
+**   the  last  capacity bytes of records in a memory mapped ring.
+**   The  records  survive  a  crash  without  any  flushing,  use the
+**   LogDecode  tool  to  read  them.  A previous file of that name is
+**   kept  with  FlightRecorder::PREVIOUS_SUFFIX  appended.  An  empty
+**   filename closes the flight recorder.
+**
+**   Records  still  waiting  in  the async queue when the process
+**   dies are lost, as with every other sink.
+**   
+**   Returns true if the file could be opened.
+***********************************************************************/
+bool QcjLib::Logger::SetFlightRecorderFile(QString filename, qint64 capacity)
+{
+   bool rv = true;
+   QMutexLocker lock(&m_writeLock);
+
+   if ( ! filename.isEmpty() ) 
+   {
+      rv = m_flightLog.Open(filename, capacity);
+   }
+   else 
+   {
+      m_flightLog.Close();
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   bool Logger::SetDatabaseLogFile(QString filename, int retention_days)
+**   
+**   Starts  the  database  sink, which inserts records into the
+**   SQLite  database  filename  from  a  thread of its own, see
+**   SqlLogSink.  Records  older  than  retention_days  are deleted,
+**   zero  keeps  them  all.  A running sink writes out what it has
+**   pending  and  is  stopped  before  the  new  one starts, an empty
+**   filename only stops it.
+**   
+**   Returns true if the database could be opened.
+***********************************************************************/
+bool QcjLib::Logger::SetDatabaseLogFile(QString filename, int retention_days)
+{
+   static bool have_post_routine = false;
+   bool rv = true;
+   SqlLogSink *old_sink;
+
+   if ( ! filename.isEmpty() && ! (rv = SqlLogSink::InitializeDatabase(filename)) ) 
+   {
+      return(rv);
+   }
+
+   {
+      QMutexLocker lock(&m_writeLock);
+      old_sink = m_sqlLog;
+      m_sqlLog = NULL;
+   }
+
+   /***************************************************************/
+   /*   Stopped  outside  the  lock  as  the old sink may log while  */
+   /*   writing  out  its  last  batch, and before the new sink is  */
+   /*   started  so  the  two  never  write  to  the  database at  */
+   /*   the same time.                                             */
+   /***************************************************************/
+   if ( old_sink != NULL ) 
+   {
+      old_sink->Stop();
+      delete old_sink;
+   }
+
+   if ( ! filename.isEmpty() ) 
+   {
+      SqlLogSink *new_sink = new SqlLogSink(filename, retention_days);
+      new_sink->start();
+
+      {
+         QMutexLocker lock(&m_writeLock);
+         m_sqlLog = new_sink;
+      }
+
+      if ( ! have_post_routine ) 
+      {
+         qAddPostRoutine(StopDatabaseLogging);
+         have_post_routine = true;
+      }
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   void  Logger::SetRotationPolicy(qint64  max_bytes,  int max_age_secs, 
+**                                   int keep_count, bool compress)
+**   
+**   Sets  when  the  log file is rotated. When the file grows past
+**   max_bytes  or  has  been  open  longer than max_age_secs it is
+**   renamed  to  <filename>.<yyyyMMdd-hhmmsszzz>  and  a  new  file
+**   is  started.  The  renamed  segment  is  then  compressed  and
+**   old segments removed on a background thread, so writing log
+**   messages never waits on either.
+**   
+**   Parameters
+**   
+**   max_bytes      Size limit of the log file, 0 for no limit
+**   
+**   max_age_secs   Age limit of the log file, 0 for no limit
+**   
+**   keep_count     Number of rotated segments to keep, 0 keeps all
+**   
+**   compress       true to compress rotated segments
+**   
+**   Returns N/A
+***********************************************************************/
+void QcjLib::Logger::SetRotationPolicy(qint64 max_bytes, int max_age_secs, int keep_count, bool compress)
+{
+   QMutexLocker lock(&m_writeLock);
+   m_rotateMaxBytes = max_bytes;
+   m_rotateMaxAge = max_age_secs;
+   m_rotateKeep = keep_count;
+   m_rotateCompress = compress;
+}
+
+/********************************************************************//*
+**   void Logger::SetEntryBatching(int max_messages, int max_interval_ms)
+**   
+**   Turns  on  delivery  of  formatted lines to LogEntries() and
+**   LogRecords() listeners in batches.  A  batch  is  emitted  once it holds max_messages
+**   lines  or  its  oldest  line  is  max_interval_ms old, whichever
+**   comes  first,  so  a  busy  log  costs  a  view  one queued
+**   signal  and  one  update  per batch instead of one per line.
+**   Passing 0 for max_messages turns batching off.
+**   
+**   Call  this  from  the  thread  the  Logger  lives in, normally
+**   the  GUI  thread,  as  it  starts  the  timer that sends out
+**   partial batches.
+**   
+**   Returns N/A
+***********************************************************************/
+void QcjLib::Logger::SetEntryBatching(int max_messages, int max_interval_ms)
+{
+   QMutexLocker lock(&m_writeLock);
+
+   EmitEntries();
+   m_batchMaxMessages = max_messages;
+   m_batchMaxInterval = max_interval_ms;
+
+   if ( m_batchFlushTimer == NULL ) 
+   {
+      m_batchFlushTimer = new QTimer(this);
+      connect(m_batchFlushTimer, SIGNAL(timeout()), this, SLOT(FlushEntries()));
+   }
+   if ( m_batchMaxMessages > 0 ) 
+   {
+      m_batchFlushTimer->start(m_batchMaxInterval);
+   }
+   else 
+   {
+      m_batchFlushTimer->stop();
+   }
+}
+
+/********************************************************************//*
+**   void  Logger::SetAsync(bool enable, int queue_size, OverflowPolicy policy)
+**   
+**   Switches  the  logger  between  writing  each  message on the
+**   calling  thread  and  queueing  it  for  a  dedicated writer
+**   thread  that  writes  to  the  console,  the  log  file  and
+**   the LogEntry listeners in batches.
+**   
+**   Turning  async  mode  off stops the writer thread and writes
+**   out  what  is  still  queued.  Other  threads  may  still be
+**   logging  meanwhile.  A  thread  that  picked up the queue before
+**   it  was  switched  off  may  still push to it, so the queue is
+**   retired rather than freed, see Submit().
+**   
+**   Parameters
+**   
+**   enable       true to queue messages for the writer thread
+**   
+**   queue_size   Maximum number of records held in the queue
+**   
+**   policy       What to do with a message when the queue is full
+**   
+**   Returns N/A
+***********************************************************************/
+void QcjLib::Logger::SetAsync(bool enable, int queue_size, OverflowPolicy policy)
+{
+   static bool have_post_routine = false;
+
+   if ( m_queue.load(std::memory_order_acquire) != NULL ) 
+   {
+      {
+         QMutexLocker lock(&m_wakeLock);
+         m_writerStop.store(true);
+         m_wakeCondition.wakeOne();
+      }
+      m_writer->wait();
+      delete m_writer;
+      m_writer = NULL;
+
+      LogQueue_t *queue = m_queue.exchange(NULL);
+      QMutexLocker lock(&m_writeLock);
+      DrainQueue(queue, INT_MAX);
+      m_retiredQueues.append(queue);
+   }
+
+   if ( enable ) 
+   {
+      m_overflowPolicy = policy;
+      m_writerStop.store(false);
+      m_queue.store(new LogQueue_t(queue_size), std::memory_order_release);
+      m_writer = new WriterThread(this);
+      m_writer->start();
+
+      if ( ! have_post_routine ) 
+      {
+         qAddPostRoutine(StopAsyncLogging);
+         have_post_routine = true;
+      }
+   }
+}
+
+/********************************************************************//*
+**   void Logger::Submit(LogRecord &rec)
+**   
+**   Hands  a  record  to  the sinks. In async mode the record is
+**   moved  into  the  queue  for the writer thread, otherwise it
+**   is written out immediately.
+**   
+**   Parameters
+**   
+**   rec   The record to log. It is left empty if it was queued.
+**   
+**   Returns N/A
+***********************************************************************/
+void QcjLib::Logger::Submit(LogRecord &rec)
+{
+   LogQueue_t *queue = m_queue.load(std::memory_order_acquire);
+
+   /***************************************************************/
+   /*   Messages  logged  by  the  writer  thread itself, such as  */
+   /*   from a slot directly connected to LogEntry, can not wait   */
+   /*   on the queue without dead locking.                         */
+   /***************************************************************/
+   if ( queue == NULL || QThread::currentThread() == m_writer ) 
+   {
+      QMutexLocker lock(&m_writeLock);
+      WriteRecord(rec);
+      FlushStreams();
+      return;
+   }
+
+   if ( ! queue->TryPush(rec) ) 
+   {
+      switch (m_overflowPolicy)
+      {
+         case OverflowDropNewest:
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            DroppedMetric().Increment();
+            break;
+
+         case OverflowDropOldest:
+            do
+            {
+               LogRecord oldest;
+               if ( queue->TryPop(oldest) ) 
+               {
+                  m_dropped.fetch_add(1, std::memory_order_relaxed);
+                  DroppedMetric().Increment();
+               }
+            } while ( ! queue->TryPush(rec) );
+            break;
+
+         case OverflowBlock:
+         default:
+            do
+            {
+               if ( m_queue.load() != queue ) 
+               {
+                  QMutexLocker lock(&m_writeLock);
+                  WriteRecord(rec);
+                  FlushStreams();
+                  return;
+               }
+               WakeWriter();
+               QThread::yieldCurrentThread();
+            } while ( ! queue->TryPush(rec) );
+            break;
+      }
+   }
+
+   /***************************************************************/
+   /*   If  SetAsync()  retired the queue meanwhile, its last      */
+   /*   drain may have missed our record. Drain it ourselves.      */
+   /***************************************************************/
+   if ( m_queue.load() != queue ) 
+   {
+      QMutexLocker lock(&m_writeLock);
+      DrainQueue(queue, INT_MAX);
+      FlushStreams();
+      return;
+   }
+   WakeWriter();
+}
+
+/********************************************************************//*
+**   void Logger::ReportSuppressed(LogDescriptor *descr, qint64 now)
+**   
+**   Logs  how  many of the log's messages were dropped by its rate
+**   limit  or  sampling  since  the  last  summary. This happens at
+**   most once every SUMMARY_INTERVAL_NS per log.
+**   
+**   Parameters
+**   
+**   descr Descriptor of the log
+**   
+**   now   Current MonotonicNs()
+**   
+**   Returns N/A
+***********************************************************************/
+void QcjLib::Logger::ReportSuppressed(LogDescriptor *descr, qint64 now)
+{
+   if ( ! descr->SummaryDue(now) ) 
+   {
+      return;
+   }
+
+   quint64 count = descr->suppressed.exchange(0, std::memory_order_relaxed);
+   if ( count == 0 ) 
+   {
+      return;
+   }
+
+   LogRecord rec;
+   rec.type = QtInfoMsg;
+   rec.sinks = descr->sinks.load(std::memory_order_relaxed);
+   rec.category = descr->name;
+   rec.threadId = CurrentThreadId();
+   rec.timestamp = QDateTime::currentMSecsSinceEpoch();
+   rec.monotonic = now;
+   rec.message = QString("... %1 similar messages suppressed").arg(count);
+   Submit(rec);
+}
+
+/********************************************************************//*
+**   void Logger::Flush()
+**   
+**   Writes  out  everything  still  sitting in the async queue and
+**   flushes  the  console  and  log  file streams. Call this before
+**   shutting down or aborting so nothing is lost.
+**   
+**   Returns N/A
+***********************************************************************/
+void QcjLib::Logger::Flush()
+{
+   QMutexLocker lock(&m_writeLock);
+   LogQueue_t *queue = m_queue.load(std::memory_order_acquire);
+   if ( queue != NULL ) 
+   {
+      DrainQueue(queue, INT_MAX);
+   }
+   EmitEntries();
+   FlushStreams();
+}
+
+/********************************************************************//*
+**   void Logger::FormatRecord(const LogRecord &rec, QString &out)
+**   
+**   Appends  the  text  line  written  to the sinks for a record
+**   to  out.  The  "hh:mm:ss: " prefix is only rebuilt when the
+**   second  changes,  and  the  line  is  built  with plain appends
+**   so  a caller reusing out does not allocate once it has grown
+**   large enough.
+**   
+**   Returns N/A
+***********************************************************************/
+void QcjLib::Logger::FormatRecord(const LogRecord &rec, QString &out)
+{
+   static thread_local qint64    prefix_second = -1;
+   static thread_local QString   prefix;
+
+   if ( rec.isFormatted() ) 
+   {
+      out += rec.text;
+      return;
+   }
+
+   qint64 second = rec.timestamp / 1000;
+   if ( second != prefix_second ) 
+   {
+      prefix = QDateTime::fromMSecsSinceEpoch(rec.timestamp).time().toString("hh:mm:ss") + ": ";
+      prefix_second = second;
+   }
 
+//   out += rec.category + ":" + QString::number(rec.level) + "::";
+   out += prefix;
+   switch (rec.type)
+   {
+      case QtDebugMsg:
+         out += QLatin1String("Debug: ");
+         break;
+
+      case QtInfoMsg:
+         out += QLatin1String("Info: ");
+         break;
+
+      case QtWarningMsg:
+         out += QLatin1String("Warning: ");
+         break;
+
+      case QtCriticalMsg:
+         out += QLatin1String("Critical: ");
+         break;
+
+      case QtFatalMsg:
+         out += QLatin1String("FATAL: ");
+         out += rec.message;
+         out += QLatin1Char('\n');
+         return;
+
+      default:
+         break;
+   }
+   if ( ! rec.function.isEmpty() ) 
+   {
+      out += QLatin1String(rec.function);
+   }
+   out += QLatin1String(": ");
+   FormatMessage(rec, out);
+   out += QLatin1Char('\n');
+}
+
+/********************************************************************//*
+**   void Logger::FormatMessage(const LogRecord &rec, QString &out)
+**   
+**   Appends  the  message  of  a record to out. For a structured
+**   record  the  %1 .. %9 markers in the format are replaced by
+**   the  positional args, %% by a single %, and the fields are
+**   listed after the message as " {key=value, ...}".
+**   
+**   Returns N/A
+***********************************************************************/
+void QcjLib::Logger::FormatMessage(const LogRecord &rec, QString &out)
+{
+   if ( ! rec.isStructured() ) 
+   {
+      out += rec.message;
+      return;
+   }
+
+   const LogArg *positional[9];
+   int positional_count = 0;
+   bool have_fields = false;
+   foreach (const LogArg &arg, rec.args)
+   {
+      if ( arg.key == NULL ) 
+      {
+         if ( positional_count < 9 ) 
+            positional[positional_count++] = &arg;
+      }
+      else
+         have_fields = true;
+   }
+
+   const char *start = rec.format;
+   const char *ch = start;
+   for (; *ch != '\0'; ch++) 
+   {
+      if ( *ch == '%' && (ch[1] == '%' || (ch[1] >= '1' && ch[1] <= '9')) ) 
+      {
+         out += QString::fromUtf8(start, ch - start);
+         if ( ch[1] == '%' ) 
+            out += QLatin1Char('%');
+         else if ( ch[1] - '1' < positional_count ) 
+            FormatArg(*positional[ch[1] - '1'], out);
+         else
+            out += QString::fromUtf8(ch, 2);
+         ch++;
+         start = ch + 1;
+      }
+   }
+   out += QString::fromUtf8(start, ch - start);
+
+   if ( have_fields ) 
+   {
+      bool first = true;
+      out += QLatin1String(" {");
+      foreach (const LogArg &arg, rec.args)
+      {
+         if ( arg.key != NULL ) 
+         {
+            if ( ! first ) 
+               out += QLatin1String(", ");
+            first = false;
+            out += QLatin1String(arg.key);
+            out += QLatin1Char('=');
+            FormatArg(arg, out);
+         }
+      }
+      out += QLatin1Char('}');
+   }
+}
+
+void QcjLib::Logger::FormatArg(const LogArg &arg, QString &out)
+{
+   switch ( arg.type ) 
+   {
+      case LogArg::Int:
+         out += QString::number(arg.i);
+         break;
+
+      case LogArg::UInt:
+         out += QString::number(arg.u);
+         break;
+
+      case LogArg::Double:
+         out += QString::number(arg.d);
+         break;
+
+      case LogArg::String:
+         out += arg.str;
+         break;
+
+      case LogArg::Pointer:
+         out += QLatin1String("0x");
+         out += QString::number((quint64)arg.p, 16);
+         break;
+
+      default:
+         break;
+   }
+}
+
+QString QcjLib::Logger::FormatRecord(const LogRecord &rec)
+{
+   QString rv;
+   FormatRecord(rec, rv);
+   return(rv);
+}
+
+/********************************************************************//*
+**   quint32 Logger::CurrentThreadId()
+**   
+**   Returns  a  small  number  identifying the calling thread, handed
+**   out in the order threads first log something.
+***********************************************************************/
+quint32 QcjLib::Logger::CurrentThreadId()
+{
+   static std::atomic<quint32>   next_id(1);
+   static thread_local quint32   thread_id = next_id.fetch_add(1, std::memory_order_relaxed);
+   return(thread_id);
+}
+
+/********************************************************************//*
+**   qint64 Logger::MonotonicNs()
+**   
+**   Returns  nanoseconds  of  a  steady clock that is not affected
+**   by changes to the wall clock.
+***********************************************************************/
+qint64 QcjLib::Logger::MonotonicNs()
+{
+   return(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+QcjLib::Logger::OverflowPolicy QcjLib::Logger::OverflowPolicyFromString(QString policy)
+{
+   OverflowPolicy rv = OverflowBlock;
+   if ( policy == "drop_oldest" ) 
+   {
+      rv = OverflowDropOldest;
+   }
+   else if ( policy == "drop_newest" ) 
+   {
+      rv = OverflowDropNewest;
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   bool Logger::DrainQueue(LogQueue_t *queue, int max_records)
+**   
+**   Writes  up  to  max_records  records  from  the queue to the
+**   sinks  and  flushes  the  streams  once  for the whole batch.
+**   The caller must hold m_writeLock.
+**   
+**   Returns true if anything was written.
+***********************************************************************/
+bool QcjLib::Logger::DrainQueue(LogQueue_t *queue, int max_records)
+{
+   int count = 0;
+   LogRecord rec;
+   while ( count < max_records && queue->TryPop(rec) ) 
+   {
+      WriteRecord(rec);
+      count++;
+   }
+   if ( count > 0 ) 
+   {
+      FlushStreams();
+   }
+   return(count > 0);
+}
+
+void QcjLib::Logger::FlushStreams()
+{
+   m_binaryLog.Flush();
+   if ( m_consoleEnable ) 
+   {
+      m_consoleStream.flush();
+   }
+   if ( m_deviceStream.device() != NULL &&
+        m_deviceStream.device()->isOpen() ) 
+   {
+      m_deviceStream.flush();
+   }
+}
+
+/********************************************************************//*
+**   bool Logger::OpenLogFile(bool append) private
+**   
+**   Opens  the  log  file,  truncating it unless append is set. The
+**   file is written in UTF-8, which WriteRecord() counts on for
+**   the size that triggers rotation.
+**   
+**   Returns true if the file could be opened.
+***********************************************************************/
+bool QcjLib::Logger::OpenLogFile(bool append)
+{
+   bool rv;
+
+   m_logFile.setFileName(m_logFileName);
+   if ( (rv = m_logFile.open(append ? QIODevice::WriteOnly | QIODevice::Append : QIODevice::WriteOnly)) ) 
+   {
+      m_deviceStream.setDevice(&m_logFile);
+      m_deviceStream.setCodec("UTF-8");
+      m_logFileBytes = 0;
+      m_logFileOpened = QDateTime::currentMSecsSinceEpoch();
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   void Logger::RotateLogFile() private
+**   
+**   Moves  the  current  log file aside, opens a new one and hands
+**   the  old  segment  to  the  background  rotation  thread. The
+**   caller must hold m_writeLock.
+**
+**   If  the  file  can not be renamed, it is reopened for appending
+**   so  nothing  is  lost,  and the next try comes after another
+**   full  segment.  The warning goes straight to stderr and the file,
+**   logging  it  through  Qt  would  re-enter  WriteRecord()  while  it
+**   still uses its buffer.
+***********************************************************************/
+void QcjLib::Logger::RotateLogFile()
+{
+   if ( m_logFile.isOpen() ) 
+   {
+      m_deviceStream.flush();
+      m_logFile.close();
+   }
+
+   QString segment = m_logFileName + "." + QDateTime::currentDateTime().toString(ROTATED_SUFFIX_FORMAT);
+   if ( QFile::rename(m_logFileName, segment) ) 
+   {
+      RotationPool()->start(new LogRotationJob(m_logFileName, segment, m_rotateKeep, m_rotateCompress));
+      OpenLogFile();
+   }
+   else if ( OpenLogFile(true) ) 
+   {
+      QString warning = QDateTime::currentDateTime().time().toString("hh:mm:ss") + 
+                        ": Warning: Could not rename log file " + m_logFileName + " to " + segment + 
+                        ", continuing in the same file\n";
+      std::cerr << qPrintable(warning);
+      m_deviceStream << warning;
+   }
+}
+
+/********************************************************************//*
+**   static qint64 Logger::Utf8Length(const QString &text) private
+**   
+**   Returns  the  number  of bytes text takes in UTF-8 without
+**   converting it.
+***********************************************************************/
+qint64 QcjLib::Logger::Utf8Length(const QString &text)
+{
+   qint64 rv = 0;
+   const QChar *ch = text.constData();
+   const QChar *end = ch + text.size();
+
+   for ( ; ch < end; ch++) 
+   {
+      ushort code = ch->unicode();
+      if ( code < 0x80 ) 
+      {
+         rv += 1;
+      }
+      else if ( code < 0x800 ) 
+      {
+         rv += 2;
+      }
+      else if ( ch->isHighSurrogate() && ch + 1 < end && (ch + 1)->isLowSurrogate() ) 
+      {
+         rv += 4;
+         ch++;
+      }
+      else 
+      {
+         rv += 3;
+      }
+   }
+   return(rv);
+}
+
+void QcjLib::Logger::WakeWriter()
+{
+   if ( m_writerIdle.load() ) 
+   {
+      QMutexLocker lock(&m_wakeLock);
+      m_wakeCondition.wakeOne();
+   }
+}
+
+/********************************************************************//*
+**   void Logger::WriteRecord(const LogRecord &rec) private
+**   
+**   Writes  rec  to  each  of  its  sinks.  The  caller  must  hold
+**   m_writeLock.  A  slot  connected directly to LogEntry() may log,
+**   which  comes back in here on the same thread, so only the outer
+**   call formats into the thread's reused buffer.
+***********************************************************************/
+void QcjLib::Logger::WriteRecord(const LogRecord &rec)
+{
+   static thread_local QString   shared_msg;
+   static thread_local int       depth = 0;
+   static const QMetaMethod      log_entry_signal = QMetaMethod::fromSignal(&Logger::LogEntry);
+
+   QString nested_msg;
+   QString &msg = (depth == 0) ? shared_msg : nested_msg;
+
+   bool to_console = m_consoleEnable && (rec.sinks & LogSinkConsole);
+   bool to_file = (rec.sinks & LogSinkFile) && 
+                  m_deviceStream.device() != NULL &&
+                  m_deviceStream.device()->isOpen();
+   static const QMetaMethod      log_entries_signal = QMetaMethod::fromSignal(&Logger::LogEntries);
+   static const QMetaMethod      log_records_signal = QMetaMethod::fromSignal(&Logger::LogRecords);
+
+   bool to_batch = (rec.sinks & LogSinkView) && m_batchMaxMessages > 0 && 
+                   (isSignalConnected(log_entries_signal) || isSignalConnected(log_records_signal));
+   bool to_view = (rec.sinks & LogSinkView) && isSignalConnected(log_entry_signal);
+
+   if ( (rec.sinks & LogSinkBinary) && m_binaryLog.IsOpen() ) 
+   {
+      m_binaryLog.Write(rec);
+   }
+   if ( (rec.sinks & LogSinkFlight) && m_flightLog.IsOpen() ) 
+   {
+      m_flightLog.Write(rec);
+   }
+   if ( (rec.sinks & LogSinkDatabase) && m_sqlLog != NULL ) 
+   {
+      m_sqlLog->Append(rec);
+   }
+
+   /***************************************************************/
+   /*   Only  pay  for  formatting  when  a text sink will use it.  */
+   /*   The  batch  only  needs  text  for  LogEntries(),  the      */
+   /*   LogRecords() listeners can format the records they show.   */
+   /***************************************************************/
+   bool need_text = to_console || to_file || to_view || 
+                    (to_batch && isSignalConnected(log_entries_signal));
+
+   msg.resize(0);
+   if ( need_text ) 
+   {
+      FormatRecord(rec, msg);
+   }
+//   std::cout << __FUNCTION__ <<  "m_consoleEnable: " << m_consoleEnable << std::endl;
+   if ( to_console ) 
+   {
+      m_consoleStream << msg;
+   }
+   if ( to_file ) 
+   {
+      m_deviceStream << msg;
+      m_logFileBytes += Utf8Length(msg);
+
+      if ( (m_rotateMaxBytes > 0 && m_logFileBytes >= m_rotateMaxBytes) ||
+           (m_rotateMaxAge > 0 && 
+            QDateTime::currentMSecsSinceEpoch() - m_logFileOpened >= (qint64)m_rotateMaxAge * 1000) ) 
+      {
+         RotateLogFile();
+      }
+   }
+   if ( to_view ) 
+   {
+      depth++;
+      emit LogEntry(msg);
+      depth--;
+   }
+   if ( to_batch ) 
+   {
+      if ( m_pendingEntries.isEmpty() ) 
+      {
+         m_batchTimer.start();
+      }
+      m_pendingEntries.append(rec);
+      if ( need_text ) 
+      {
+         m_pendingEntries.last().text = msg;
+      }
+      if ( m_pendingEntries.count() >= m_batchMaxMessages || 
+           m_batchTimer.elapsed() >= m_batchMaxInterval ) 
+      {
+         EmitEntries();
+      }
+   }
+}
+
+/********************************************************************//*
+**   void Logger::EmitEntries() private
+**   
+**   Sends  the  pending  batch  to  the LogEntries() and LogRecords()
+**   listeners. The caller must hold m_writeLock.
+***********************************************************************/
+void QcjLib::Logger::EmitEntries()
+{
+   if ( ! m_pendingEntries.isEmpty() ) 
+   {
+      QVector<LogRecord> records;
+      records.swap(m_pendingEntries);
+
+      if ( isSignalConnected(QMetaMethod::fromSignal(&Logger::LogEntries)) ) 
+      {
+         QStringList entries;
+         entries.reserve(records.count());
+         foreach (const LogRecord &rec, records)
+         {
+            entries.append(rec.isFormatted() ? rec.text : FormatRecord(rec));
+         }
+         emit LogEntries(entries);
+      }
+      emit LogRecords(records);
+   }
+}
+
+/********************************************************************//*
+**   void Logger::FlushEntries() private slot
+**   
+**   Sends  out  a  partial  batch  once its oldest line is older
+**   than the batching interval.
+***********************************************************************/
+void QcjLib::Logger::FlushEntries()
+{
+   QMutexLocker lock(&m_writeLock);
+   if ( ! m_pendingEntries.isEmpty() && m_batchTimer.elapsed() >= m_batchMaxInterval ) 
+   {
+      EmitEntries();
+   }
+}
+
+void QcjLib::Logger::WriterLoop()
+{
+   LogQueue_t *queue = m_queue.load(std::memory_order_acquire);
+   while ( ! m_writerStop.load() ) 
+   {
+      bool wrote;
+      {
+         QMutexLocker lock(&m_writeLock);
+         wrote = DrainQueue(queue, WRITER_BATCH_SIZE);
+      }
+
+      if ( ! wrote ) 
+      {
+         QMutexLocker lock(&m_wakeLock);
+         m_writerIdle.store(true);
+         if ( queue->IsEmpty() && ! m_writerStop.load() ) 
+         {
+            m_wakeCondition.wait(&m_wakeLock, WRITER_IDLE_WAIT_MS);
+         }
+         m_writerIdle.store(false);
+      }
+   }
+}
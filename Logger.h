@@ -29,84 +29,77 @@
 #define LOGGER_H
 
 # include <QDebug>
+# include <QElapsedTimer>
 # include <QFile>
 # include <QFileInfo>
 # include <QIODevice>
+# include <QList>
 # include <QMessageLogContext>
+# include <QMutex>
 # include <QObject>
+# include <QRecursiveMutex>
 # include <QString>
+# include <QStringList>
 # include <QTextStream>
+# include <QThread>
+# include <QTimer>
+# include <QVector>
+# include <QWaitCondition>
+
+# include "BinaryLogWriter.h"
+# include "FlightRecorder.h"
+# include "LogHandle.h"
+# include "LogRecord.h"
+# include "LogRingBuffer.h"
+# include "SqlLogSink.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <atomic>
 #include <iostream>
 
 namespace QcjLib
 {
-   class Logger : QObject 
+   typedef LogRingBuffer<LogRecord> LogQueue_t;
+
+   class Logger : public QObject 
    {
       Q_OBJECT
 
    public:
+      /********************************************************************//*
+      **   What  a producer does when the async queue is full. Block
+      **   waits  for  the writer to make room, DropOldest discards
+      **   the oldest queued record and DropNewest discards the one
+      **   being logged.
+      ***********************************************************************/
+      enum OverflowPolicy
+      {
+         OverflowBlock,
+         OverflowDropOldest,
+         OverflowDropNewest
+      };
+
       Logger(QObject *parent = NULL);
       ~Logger();
 
       static Logger *instance()
       {
-         if ( m_instance == NULL ) 
-         {
-            m_instance = new Logger();
-         }
-         return(m_instance);
+         static Logger *instance = new Logger();
+         return(instance);
       }
 
-      bool SetLogFile(QString filename)
-      {
-         bool rv = true;
-
-         if ( ! filename.isEmpty() ) 
-         {
-            QString rename = filename + ".1";
-            if ( QFileInfo::exists(filename) ) 
-            {
-               std::cout << __FUNCTION__ << " Renaming existing log file" << std::endl;
-               QFile::rename(filename, rename);
-            }
-
-            m_logFile.setFileName(filename);
-            std::cout << __FUNCTION__ << " Opeing log file" << std::endl;
-            if ( (rv = m_logFile.open(QIODevice::WriteOnly)) ) 
-            {
-               if ( m_deviceStream.device() != NULL &&
-                    m_deviceStream.device()->isOpen() ) 
-               {
-                  m_deviceStream.device()->close();
-               }
-               m_deviceStream.setDevice(&m_logFile);
-            }
-         }
-         else if ( m_logFile.isOpen() ) 
-         {
-            m_logFile.close();
-         }
-         return(rv);
-      }
+      bool     SetLogFile(QString filename);
+      bool     SetBinaryLogFile(QString filename);
+      bool     SetFlightRecorderFile(QString filename, qint64 capacity = FlightRecorder::DEFAULT_CAPACITY);
+      bool     SetDatabaseLogFile(QString filename, int retention_days = 0);
+      void     SetRotationPolicy(qint64 max_bytes, int max_age_secs, int keep_count, bool compress);
 
       void LogMessage(QString msg)
       {
-//         std::cout << __FUNCTION__ <<  "m_consoleEnable: " << m_consoleEnable << std::endl;
-         if ( m_consoleEnable ) 
-         {
-            m_consoleStream << msg;
-            m_consoleStream.flush();
-         }
-         if ( m_deviceStream.device() != NULL &&
-              m_deviceStream.device()->isOpen() ) 
-         {
-            m_deviceStream << msg;
-            m_deviceStream.flush();
-         }
-         emit LogEntry(msg);
+         LogRecord rec;
+         rec.text = msg;
+         Submit(rec);
       }
 
       void EnableConsole(bool enable)
@@ -114,18 +107,102 @@ namespace QcjLib
          m_consoleEnable = enable;
       }
 
+      void     SetEntryBatching(int max_messages, int max_interval_ms = DEFAULT_BATCH_INTERVAL_MS);
+      void     SetAsync(bool enable, int queue_size = DEFAULT_QUEUE_SIZE, OverflowPolicy policy = OverflowBlock);
+      void     Submit(LogRecord &rec);
+      void     ReportSuppressed(LogDescriptor *descr, qint64 now);
+      void     Flush();
+
+      bool IsAsync() const
+      {
+         return(m_queue.load(std::memory_order_acquire) != NULL);
+      }
+
+      quint64 DroppedCount() const
+      {
+         return(m_dropped.load(std::memory_order_relaxed));
+      }
+
+      static QString FormatRecord(const LogRecord &rec);
+      static void FormatRecord(const LogRecord &rec, QString &out);
+      static void FormatMessage(const LogRecord &rec, QString &out);
+      static void FormatArg(const LogArg &arg, QString &out);
+      static OverflowPolicy OverflowPolicyFromString(QString policy);
+      static quint32 CurrentThreadId();
+      static qint64 MonotonicNs();
+
+      static const int  DEFAULT_QUEUE_SIZE;
+      static const int  DEFAULT_BATCH_SIZE;
+      static const int  DEFAULT_BATCH_INTERVAL_MS;
+
    signals:
       void  LogEntry(QString msg);
+      void  LogEntries(QStringList msgs);
+      void  LogRecords(QVector<QcjLib::LogRecord> records);
 
    protected:
+   private slots:
+      void  FlushEntries();
+
    private:
+      class WriterThread : public QThread
+      {
+      public:
+         WriterThread(Logger *logger) : m_logger(logger) {}
+
+      protected:
+         void run() override
+         {
+            m_logger->WriterLoop();
+         }
+
+      private:
+         Logger   *m_logger;
+      };
+
       void LogOutput(QtMsgType type, const QMessageLogContext &context, const QString &msg);
+      bool DrainQueue(LogQueue_t *queue, int max_records);
+      void FlushStreams();
+      bool OpenLogFile(bool append = false);
+      void RotateLogFile();
+      static qint64 Utf8Length(const QString &text);
+      void WakeWriter();
+      void WriteRecord(const LogRecord &rec);
+      void WriterLoop();
+      void EmitEntries();
       
-      bool           m_consoleEnable;
-      QTextStream    m_consoleStream;
-      QTextStream    m_deviceStream;
-      QFile          m_logFile;
-      static Logger  *m_instance;
+      std::atomic<bool>          m_consoleEnable;
+      QTextStream                m_consoleStream;
+      QTextStream                m_deviceStream;
+      QFile                      m_logFile;
+      QString                    m_logFileName;
+      qint64                     m_logFileBytes;
+      qint64                     m_logFileOpened;
+      BinaryLogWriter            m_binaryLog;
+      FlightRecorder             m_flightLog;
+      SqlLogSink                 *m_sqlLog;
+
+      int                        m_batchMaxMessages;
+      int                        m_batchMaxInterval;
+      QVector<LogRecord>         m_pendingEntries;
+      QElapsedTimer              m_batchTimer;
+      QTimer                     *m_batchFlushTimer;
+
+      qint64                     m_rotateMaxBytes;
+      int                        m_rotateMaxAge;
+      int                        m_rotateKeep;
+      bool                       m_rotateCompress;
+
+      QRecursiveMutex            m_writeLock;
+      std::atomic<LogQueue_t*>   m_queue;
+      QList<LogQueue_t*>         m_retiredQueues;
+      OverflowPolicy             m_overflowPolicy;
+      std::atomic<quint64>       m_dropped;
+      WriterThread               *m_writer;
+      std::atomic<bool>          m_writerStop;
+      std::atomic<bool>          m_writerIdle;
+      QMutex                     m_wakeLock;
+      QWaitCondition             m_wakeCondition;
    };
 };
 
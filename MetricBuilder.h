@@ -0,0 +1,197 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef METRICBUILDER_H
+#define METRICBUILDER_H
+
+# include <QElapsedTimer>
+
+# include "MetricsRegistery.h"
+
+namespace QcjLib
+{
+   /********************************************************************//*
+   **   class MetricCounter
+   **   
+   **   A  counter  that  only  goes  up. Like LogBuilder it is meant
+   **   to be declared as a static:
+   **   
+   **      static MetricCounter queries("qcjlib_queries_total", "Queries run");
+   **      queries.Increment();
+   **   
+   **   Copies  refer  to  the  same  counter. A default constructed
+   **   counter is not valid and must be assigned before use.
+   ***********************************************************************/
+   class MetricCounter
+   {
+   public:
+      MetricCounter() :
+         m_descr(NULL)
+      {
+      }
+
+      MetricCounter(QString name, QString help, QString labels = QString()) :
+         m_descr(MetricsRegistery::instance()->Register(name, help, MetricCounterType, labels))
+      {
+      }
+
+      bool IsValid() const
+      {
+         return(m_descr != NULL);
+      }
+
+      void Increment(quint64 count = 1) const
+      {
+         std::atomic<quint64> *slot = MetricsRegistery::Slot(m_descr->slot);
+         slot->store(slot->load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+      }
+
+      quint64 Value() const
+      {
+         return(MetricsRegistery::instance()->SlotValue(m_descr->slot));
+      }
+
+   private:
+      MetricDescriptor  *m_descr;
+   };
+
+   /********************************************************************//*
+   **   class MetricGauge
+   **   
+   **   A value that can go up and down. Gauges are not sharded, 
+   **   every update is an atomic operation on the shared value.
+   ***********************************************************************/
+   class MetricGauge
+   {
+   public:
+      MetricGauge() :
+         m_descr(NULL)
+      {
+      }
+
+      MetricGauge(QString name, QString help, QString labels = QString()) :
+         m_descr(MetricsRegistery::instance()->Register(name, help, MetricGaugeType, labels))
+      {
+      }
+
+      bool IsValid() const
+      {
+         return(m_descr != NULL);
+      }
+
+      void Set(qint64 value) const
+      {
+         m_descr->gauge.store(value, std::memory_order_relaxed);
+      }
+
+      void Add(qint64 value) const
+      {
+         m_descr->gauge.fetch_add(value, std::memory_order_relaxed);
+      }
+
+      qint64 Value() const
+      {
+         return(m_descr->gauge.load(std::memory_order_relaxed));
+      }
+
+   private:
+      MetricDescriptor  *m_descr;
+   };
+
+   /********************************************************************//*
+   **   class MetricHistogram
+   **   
+   **   A  latency  histogram  with  fixed  buckets  from  100us to
+   **   10s,  exported  in  seconds.  Observations  are  taken  in
+   **   nanoseconds, see also MetricTimer.
+   ***********************************************************************/
+   class MetricHistogram
+   {
+   public:
+      MetricHistogram() :
+         m_descr(NULL)
+      {
+      }
+
+      MetricHistogram(QString name, QString help, QString labels = QString()) :
+         m_descr(MetricsRegistery::instance()->Register(name, help, MetricHistogramType, labels))
+      {
+      }
+
+      bool IsValid() const
+      {
+         return(m_descr != NULL);
+      }
+
+      void Observe(quint64 ns) const
+      {
+         int bucket = 0;
+         while ( bucket < MetricsRegistery::HISTOGRAM_BUCKETS - 1 && 
+                 (qint64)ns > MetricsRegistery::HISTOGRAM_BOUNDS[bucket] ) 
+            bucket++;
+
+         Bump(m_descr->slot + bucket, 1);
+         Bump(m_descr->slot + MetricsRegistery::HISTOGRAM_BUCKETS, 1);
+         Bump(m_descr->slot + MetricsRegistery::HISTOGRAM_BUCKETS + 1, ns);
+      }
+
+   private:
+      static void Bump(int slot_no, quint64 count)
+      {
+         std::atomic<quint64> *slot = MetricsRegistery::Slot(slot_no);
+         slot->store(slot->load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+      }
+
+      MetricDescriptor  *m_descr;
+   };
+
+   /********************************************************************//*
+   **   class MetricTimer
+   **   
+   **   Adds the time until it is destroyed to a MetricHistogram.
+   ***********************************************************************/
+   class MetricTimer
+   {
+   public:
+      MetricTimer(const MetricHistogram &histogram) :
+         m_histogram(histogram)
+      {
+         m_timer.start();
+      }
+
+      ~MetricTimer()
+      {
+         m_histogram.Observe(m_timer.nsecsElapsed());
+      }
+
+   private:
+      const MetricHistogram   &m_histogram;
+      QElapsedTimer            m_timer;
+   };
+}
+
+#endif
@@ -0,0 +1,164 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+# include "MetricsDialog.h"
+# include "MetricsRegistery.h"
+
+# include <QDialogButtonBox>
+# include <QFileDialog>
+# include <QFontDatabase>
+# include <QGridLayout>
+# include <QLabel>
+# include <QMessageBox>
+# include <QPushButton>
+# include <QSettings>
+# include <QVBoxLayout>
+
+using namespace QcjLib;
+
+MetricsDialog::MetricsDialog(QWidget *parent) :
+   QDialog(parent, Qt::Dialog | Qt::WindowMinMaxButtonsHint)
+{
+   setWindowTitle("Metrics");
+
+   QVBoxLayout *layout = new QVBoxLayout(this);
+   QGridLayout *export_layout = new QGridLayout();
+
+   m_fileCheckBox = new QCheckBox("Export to File", this);
+   m_fileNameEdit = new QLineEdit(this);
+   QPushButton *browse_btn = new QPushButton("...", this);
+   m_intervalSpin = new QSpinBox(this);
+   m_intervalSpin->setRange(1, 3600);
+   m_intervalSpin->setSuffix(" s");
+   export_layout->addWidget(m_fileCheckBox, 0, 0);
+   export_layout->addWidget(m_fileNameEdit, 0, 1);
+   export_layout->addWidget(browse_btn, 0, 2);
+   export_layout->addWidget(m_intervalSpin, 0, 3);
+
+   m_socketCheckBox = new QCheckBox("Serve on Socket", this);
+   m_socketNameEdit = new QLineEdit(this);
+   export_layout->addWidget(m_socketCheckBox, 1, 0);
+   export_layout->addWidget(m_socketNameEdit, 1, 1, 1, 3);
+   layout->addLayout(export_layout);
+
+   m_metricsEdit = new QPlainTextEdit(this);
+   m_metricsEdit->setReadOnly(true);
+   m_metricsEdit->setLineWrapMode(QPlainTextEdit::NoWrap);
+   m_metricsEdit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+   layout->addWidget(m_metricsEdit);
+
+   QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
+   QPushButton *refresh_btn = buttons->addButton("Refresh", QDialogButtonBox::ActionRole);
+   layout->addWidget(buttons);
+
+   connect(buttons,          SIGNAL(accepted()),         this, SLOT(accept()));
+   connect(buttons,          SIGNAL(rejected()),         this, SLOT(reject()));
+   connect(refresh_btn,      SIGNAL(clicked()),          this, SLOT(SlotRefresh()));
+   connect(browse_btn,       SIGNAL(clicked()),          this, SLOT(SlotBrowseFiles()));
+   connect(m_fileCheckBox,   SIGNAL(stateChanged(int)),  this, SLOT(SlotSetFileEnable(int)));
+   connect(m_socketCheckBox, SIGNAL(stateChanged(int)),  this, SLOT(SlotSetSocketEnable(int)));
+
+   QSettings settings;
+   QString file_name = settings.value(METRICS_FILE_NAME, "").toString();
+   QString socket_name = settings.value(METRICS_SOCKET_NAME, "").toString();
+   m_fileCheckBox->setChecked(! file_name.isEmpty());
+   m_fileNameEdit->setText(file_name.isEmpty() ? QString("./metrics.prom") : file_name);
+   m_intervalSpin->setValue(settings.value(METRICS_FILE_INTERVAL, 15).toInt());
+   m_socketCheckBox->setChecked(! socket_name.isEmpty());
+   m_socketNameEdit->setText(socket_name.isEmpty() ? QString("qcjlib-metrics") : socket_name);
+   SlotSetFileEnable(0);
+   SlotSetSocketEnable(0);
+
+   resize(800, 500);
+   SlotRefresh();
+}
+
+void MetricsDialog::accept()
+{
+   QSettings settings;
+   settings.setValue(METRICS_FILE_NAME,     m_fileCheckBox->isChecked() ? m_fileNameEdit->text() : QString());
+   settings.setValue(METRICS_FILE_INTERVAL, m_intervalSpin->value());
+   settings.setValue(METRICS_SOCKET_NAME,   m_socketCheckBox->isChecked() ? m_socketNameEdit->text() : QString());
+
+   MetricsRegistery::instance()->StopFileExport();
+   MetricsRegistery::instance()->StopServer();
+   if ( m_fileCheckBox->isChecked() ) 
+   {
+      MetricsRegistery::instance()->StartFileExport(m_fileNameEdit->text(), m_intervalSpin->value() * 1000);
+   }
+
+   if ( m_socketCheckBox->isChecked() && ! MetricsRegistery::instance()->StartServer(m_socketNameEdit->text()) ) 
+   {
+      QMessageBox::critical(NULL, "Error Opening Socket", "Socket '" 
+                                + m_socketNameEdit->text()
+                                + "' could not be opened");
+      return;
+   }
+   QDialog::accept();
+}
+
+void MetricsDialog::SlotBrowseFiles()
+{
+   m_fileNameEdit->setText(QFileDialog::getSaveFileName(this, "Metrics File", m_fileNameEdit->text()));
+}
+
+void MetricsDialog::SlotRefresh()
+{
+   m_metricsEdit->setPlainText(MetricsRegistery::instance()->ExportText());
+}
+
+void MetricsDialog::SlotSetFileEnable(int)
+{
+   m_fileNameEdit->setEnabled(m_fileCheckBox->isChecked());
+   m_intervalSpin->setEnabled(m_fileCheckBox->isChecked());
+}
+
+void MetricsDialog::SlotSetSocketEnable(int)
+{
+   m_socketNameEdit->setEnabled(m_socketCheckBox->isChecked());
+}
+
+/********************************************************************//*
+**   void MetricsDialog::InitializeMetrics()
+**   
+**   Starts the exports saved in the settings.
+***********************************************************************/
+void MetricsDialog::InitializeMetrics()
+{
+   QSettings settings;
+   QString file_name = settings.value(METRICS_FILE_NAME, "").toString();
+   if ( ! file_name.isEmpty() ) 
+   {
+      MetricsRegistery::instance()->StartFileExport(file_name, settings.value(METRICS_FILE_INTERVAL, 15).toInt() * 1000);
+   }
+
+   QString socket_name = settings.value(METRICS_SOCKET_NAME, "").toString();
+   if ( ! socket_name.isEmpty() ) 
+   {
+      MetricsRegistery::instance()->StartServer(socket_name);
+   }
+}
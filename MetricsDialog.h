@@ -0,0 +1,73 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef METRICSDIALOG_H
+#define METRICSDIALOG_H
+
+# include <QCheckBox>
+# include <QDialog>
+# include <QLineEdit>
+# include <QPlainTextEdit>
+# include <QSpinBox>
+
+namespace QcjLib
+{
+   /********************************************************************//*
+   **   class MetricsDialog
+   **   
+   **   Shows  the  current  metrics and sets up where they are
+   **   exported  to.  The  export settings are saved with QSettings
+   **   and applied at startup by InitializeMetrics().
+   ***********************************************************************/
+   class MetricsDialog : public QDialog
+   {
+      Q_OBJECT
+
+   public:
+      MetricsDialog(QWidget *parent = NULL);
+
+      static void InitializeMetrics();
+
+   public slots:
+      void accept();
+      void SlotBrowseFiles();
+      void SlotRefresh();
+      void SlotSetFileEnable(int check_state);
+      void SlotSetSocketEnable(int check_state);
+
+   protected:
+   private:
+      QCheckBox      *m_fileCheckBox;
+      QLineEdit      *m_fileNameEdit;
+      QSpinBox       *m_intervalSpin;
+      QCheckBox      *m_socketCheckBox;
+      QLineEdit      *m_socketNameEdit;
+      QPlainTextEdit *m_metricsEdit;
+   };
+}
+
+#endif
@@ -0,0 +1,365 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+# include "MetricsRegistery.h"
+
+# include <QLocalServer>
+# include <QLocalSocket>
+# include <QMap>
+# include <QMutexLocker>
+# include <QSaveFile>
+# include <QTimer>
+# include <QVector>
+
+using namespace QcjLib;
+
+const qint64 MetricsRegistery::HISTOGRAM_BOUNDS[MetricsRegistery::HISTOGRAM_BUCKETS - 1] =
+{
+   100000LL, 250000LL, 500000LL,
+   1000000LL, 2500000LL, 5000000LL,
+   10000000LL, 25000000LL, 50000000LL,
+   100000000LL, 250000000LL, 500000000LL,
+   1000000000LL, 2500000000LL, 5000000000LL,
+   10000000000LL
+};
+
+namespace
+{
+   typedef std::atomic<quint64> MetricSlot_t;
+
+   struct MetricShard
+   {
+      std::atomic<MetricSlot_t*> blocks[MetricsRegistery::MAX_BLOCKS];
+   };
+
+   struct ShardState
+   {
+      QMutex                  lock;
+      QVector<MetricShard*>   shards;
+      QVector<MetricShard*>   freeShards;
+   };
+
+   ShardState &Shards()
+   {
+      static ShardState state;
+      return(state);
+   }
+
+   /***********************************************/
+   /*   Hands a thread's shard back when the      */
+   /*   thread exits so the next new thread can   */
+   /*   reuse it. Its counts stay in the totals.  */
+   /***********************************************/
+   struct ShardOwner
+   {
+      MetricShard *shard = NULL;
+
+      ~ShardOwner()
+      {
+         if ( shard != NULL ) 
+         {
+            QMutexLocker locker(&Shards().lock);
+            Shards().freeShards.append(shard);
+         }
+      }
+   };
+
+   thread_local MetricShard  *t_shard = NULL;
+   thread_local ShardOwner    t_owner;
+   thread_local MetricSlot_t  t_overflow;
+
+   QString Labels(QString labels, QString extra = QString())
+   {
+      QString rv;
+
+      if ( ! labels.isEmpty() && ! extra.isEmpty() ) 
+         rv = "{" + labels + "," + extra + "}";
+      else if ( ! labels.isEmpty() || ! extra.isEmpty() ) 
+         rv = "{" + labels + extra + "}";
+      return(rv);
+   }
+}
+
+MetricsRegistery::MetricsRegistery() :
+   m_nextSlot(0),
+   m_exportTimer(NULL),
+   m_server(NULL)
+{
+}
+
+/********************************************************************//*
+**   MetricDescriptor *MetricsRegistery::Register(QString name, 
+**                          QString help, MetricType type, QString labels)
+**   
+**   Returns  the  descriptor  for  the metric with the name and
+**   labels  given, creating it if needed. Registering the same
+**   metric  twice  returns  the  same  descriptor, so an object can
+**   register a labeled metric each time one is created.
+***********************************************************************/
+MetricDescriptor *MetricsRegistery::Register(QString name, QString help, MetricType type, QString labels)
+{
+   QString key = name + Labels(labels);
+   QMutexLocker locker(&m_lock);
+
+   MetricDescriptor *rv = m_descriptors.value(key, NULL);
+   if ( rv == NULL ) 
+   {
+      rv = new MetricDescriptor();
+      rv->name = name;
+      rv->help = help;
+      rv->labels = labels;
+      rv->type = type;
+      rv->slot = type == MetricGaugeType ? -1 : m_nextSlot;
+      rv->gauge.store(0);
+      if ( type == MetricCounterType ) 
+         m_nextSlot += 1;
+      else if ( type == MetricHistogramType ) 
+         m_nextSlot += HISTOGRAM_BUCKETS + 2;
+      m_descriptors.insert(key, rv);
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   std::atomic<quint64> *MetricsRegistery::Slot(int slot)
+**   
+**   Returns  the  calling  thread's copy of slot, setting up the
+**   thread's  shard  or  the  block of slots the first time they are
+**   used.  Once  every slot has been handed out, further metrics
+**   share a scratch slot that is never exported.
+***********************************************************************/
+std::atomic<quint64> *MetricsRegistery::Slot(int slot)
+{
+   if ( slot < 0 || slot >= SLOTS_PER_BLOCK * MAX_BLOCKS ) 
+      return(&t_overflow);
+
+   if ( t_shard == NULL ) 
+   {
+      QMutexLocker locker(&Shards().lock);
+      if ( Shards().freeShards.isEmpty() ) 
+      {
+         t_shard = new MetricShard();
+         Shards().shards.append(t_shard);
+      }
+      else 
+      {
+         t_shard = Shards().freeShards.takeLast();
+      }
+      t_owner.shard = t_shard;
+   }
+
+   std::atomic<MetricSlot_t*> &block_ptr = t_shard->blocks[slot / SLOTS_PER_BLOCK];
+   MetricSlot_t *block = block_ptr.load(std::memory_order_relaxed);
+   if ( block == NULL ) 
+   {
+      block = new MetricSlot_t[SLOTS_PER_BLOCK]();
+      block_ptr.store(block, std::memory_order_release);
+   }
+   return(&block[slot % SLOTS_PER_BLOCK]);
+}
+
+/********************************************************************//*
+**   quint64 MetricsRegistery::SlotValue(int slot)
+**   
+**   Returns the sum of slot over every thread's shard.
+***********************************************************************/
+quint64 MetricsRegistery::SlotValue(int slot)
+{
+   quint64 rv = 0;
+
+   if ( slot >= 0 && slot < SLOTS_PER_BLOCK * MAX_BLOCKS ) 
+   {
+      QMutexLocker locker(&Shards().lock);
+      foreach (MetricShard *shard, Shards().shards)
+      {
+         MetricSlot_t *block = shard->blocks[slot / SLOTS_PER_BLOCK].load(std::memory_order_acquire);
+         if ( block != NULL ) 
+            rv += block[slot % SLOTS_PER_BLOCK].load(std::memory_order_relaxed);
+      }
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   QString MetricsRegistery::ExportText()
+**   
+**   Returns  every  metric  in  the  Prometheus text exposition
+**   format. Histogram buckets and sums are in seconds.
+***********************************************************************/
+QString MetricsRegistery::ExportText()
+{
+   QString rv;
+   QMap<QString, QList<MetricDescriptor*> > families;
+
+   {
+      QMutexLocker locker(&m_lock);
+      foreach (MetricDescriptor *descr, m_descriptors)
+         families[descr->name].append(descr);
+   }
+
+   for (QMap<QString, QList<MetricDescriptor*> >::const_iterator it = families.constBegin(); 
+        it != families.constEnd(); ++it) 
+   {
+      const MetricDescriptor *first = it.value().first();
+      QString help = first->help;
+      help.replace("\\", "\\\\").replace("\n", "\\n");
+
+      rv += "# HELP " + it.key() + " " + help + "\n";
+      switch ( first->type ) 
+      {
+         case MetricCounterType:
+            rv += "# TYPE " + it.key() + " counter\n";
+            break;
+
+         case MetricGaugeType:
+            rv += "# TYPE " + it.key() + " gauge\n";
+            break;
+
+         case MetricHistogramType:
+            rv += "# TYPE " + it.key() + " histogram\n";
+            break;
+      }
+
+      foreach (const MetricDescriptor *descr, it.value())
+      {
+         if ( descr->type == MetricCounterType ) 
+         {
+            rv += descr->name + Labels(descr->labels) + " " + QString::number(SlotValue(descr->slot)) + "\n";
+         }
+         else if ( descr->type == MetricGaugeType ) 
+         {
+            rv += descr->name + Labels(descr->labels) + " " + 
+                  QString::number(descr->gauge.load(std::memory_order_relaxed)) + "\n";
+         }
+         else 
+         {
+            quint64 cumulative = 0;
+            for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) 
+            {
+               QString le = bucket < HISTOGRAM_BUCKETS - 1 ? 
+                                 QString::number(HISTOGRAM_BOUNDS[bucket] / 1.0e9, 'g', 6) : QString("+Inf");
+               cumulative += SlotValue(descr->slot + bucket);
+               rv += descr->name + "_bucket" + Labels(descr->labels, "le=\"" + le + "\"") + " " + 
+                     QString::number(cumulative) + "\n";
+            }
+            rv += descr->name + "_sum" + Labels(descr->labels) + " " + 
+                  QString::number(SlotValue(descr->slot + HISTOGRAM_BUCKETS + 1) / 1.0e9, 'g', 12) + "\n";
+            rv += descr->name + "_count" + Labels(descr->labels) + " " + 
+                  QString::number(SlotValue(descr->slot + HISTOGRAM_BUCKETS)) + "\n";
+         }
+      }
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   bool MetricsRegistery::ExportToFile(QString filename)
+**   
+**   Replaces  filename  with  ExportText().  The  file is written
+**   to  a  temporary  file  first  so  a reader never sees half an
+**   export.
+***********************************************************************/
+bool MetricsRegistery::ExportToFile(QString filename)
+{
+   bool rv = false;
+   QSaveFile file(filename);
+
+   if ( file.open(QIODevice::WriteOnly) ) 
+   {
+      file.write(ExportText().toUtf8());
+      rv = file.commit();
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   void MetricsRegistery::StartFileExport(QString filename, int interval_ms)
+**   
+**   Exports  to  filename  every  interval_ms  milliseconds. Must
+**   be called from the thread the registry lives in.
+***********************************************************************/
+void MetricsRegistery::StartFileExport(QString filename, int interval_ms)
+{
+   m_exportFile = filename;
+   if ( m_exportTimer == NULL ) 
+   {
+      m_exportTimer = new QTimer(this);
+      connect(m_exportTimer, SIGNAL(timeout()), this, SLOT(SlotExportFile()), Qt::UniqueConnection);
+   }
+   m_exportTimer->start(qMax(interval_ms, 100));
+}
+
+void MetricsRegistery::StopFileExport()
+{
+   if ( m_exportTimer != NULL ) 
+      m_exportTimer->stop();
+}
+
+/********************************************************************//*
+**   bool MetricsRegistery::StartServer(QString socket_name)
+**   
+**   Listens  on  the  local  socket socket_name. Each client that
+**   connects  is sent ExportText() and disconnected, so the metrics
+**   can be scraped with, for instance, "socat - UNIX:<path>".
+**   
+**   Returns true if the server is listening.
+***********************************************************************/
+bool MetricsRegistery::StartServer(QString socket_name)
+{
+   StopServer();
+
+   QLocalServer::removeServer(socket_name);
+   m_server = new QLocalServer(this);
+   connect(m_server, SIGNAL(newConnection()), this, SLOT(SlotNewConnection()), Qt::UniqueConnection);
+   return(m_server->listen(socket_name));
+}
+
+void MetricsRegistery::StopServer()
+{
+   if ( m_server != NULL ) 
+   {
+      m_server->close();
+      delete m_server;
+      m_server = NULL;
+   }
+}
+
+void MetricsRegistery::SlotExportFile()
+{
+   ExportToFile(m_exportFile);
+}
+
+void MetricsRegistery::SlotNewConnection()
+{
+   while ( m_server != NULL && m_server->hasPendingConnections() ) 
+   {
+      QLocalSocket *socket = m_server->nextPendingConnection();
+      connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+      socket->write(ExportText().toUtf8());
+      socket->disconnectFromServer();
+   }
+}
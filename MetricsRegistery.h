@@ -0,0 +1,139 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef METRICSREGISTERY_H
+#define METRICSREGISTERY_H
+
+# include <QHash>
+# include <QList>
+# include <QMutex>
+# include <QObject>
+# include <QString>
+
+# include <atomic>
+
+class QLocalServer;
+class QTimer;
+
+namespace QcjLib
+{
+   static const QString METRICS_FILE_NAME      ("MetricsFileName");
+   static const QString METRICS_FILE_INTERVAL  ("MetricsFileInterval");
+   static const QString METRICS_SOCKET_NAME    ("MetricsSocketName");
+
+   enum MetricType
+   {
+      MetricCounterType,
+      MetricGaugeType,
+      MetricHistogramType
+   };
+
+   /********************************************************************//*
+   **   struct MetricDescriptor
+   **   
+   **   One  metric,  identified by its name and label set. Counters
+   **   and  histograms  are  kept  in  slots of per-thread shards,
+   **   gauges  in  the  descriptor  itself. Descriptors are created
+   **   once and never freed.
+   **
+   **   labels  is  the  Prometheus label list without the braces, for
+   **   instance 'model="CustomerModel"'.
+   ***********************************************************************/
+   struct MetricDescriptor
+   {
+      QString              name;
+      QString              help;
+      QString              labels;
+      MetricType           type;
+      int                  slot;
+      std::atomic<qint64>  gauge;
+   };
+
+   typedef QHash<QString, MetricDescriptor*> MetricDescriptorMap_t;
+
+   /********************************************************************//*
+   **   class MetricsRegistery
+   **   
+   **   Keeps  the  application's  metrics  and  exports  them  in the
+   **   Prometheus  text format, either by rewriting a file on a timer
+   **   or  to  whoever  connects to a QLocalServer socket.
+   **
+   **   Metrics  are normally declared with the MetricCounter,
+   **   MetricGauge and MetricHistogram classes in MetricBuilder.h.
+   **   Updating  a  counter  or  histogram only touches the calling
+   **   thread's  shard,  the  shards  are  summed when the metrics are
+   **   exported.
+   ***********************************************************************/
+   class MetricsRegistery : public QObject
+   {
+      Q_OBJECT
+
+   public:
+      static MetricsRegistery* instance()
+      {
+         static MetricsRegistery *instance = new MetricsRegistery();
+         return(instance);
+      }
+
+      MetricDescriptor *Register(QString name, QString help, MetricType type, QString labels = QString());
+
+      /***********************************************/
+      /*   Returns the calling thread's copy of a    */
+      /*   slot. Only that thread may update it.     */
+      /***********************************************/
+      static std::atomic<quint64> *Slot(int slot);
+
+      quint64  SlotValue(int slot);
+      QString  ExportText();
+      bool     ExportToFile(QString filename);
+      void     StartFileExport(QString filename, int interval_ms);
+      void     StopFileExport();
+      bool     StartServer(QString socket_name);
+      void     StopServer();
+
+      static const int     HISTOGRAM_BUCKETS = 17;
+      static const qint64  HISTOGRAM_BOUNDS[HISTOGRAM_BUCKETS - 1];   /* ns */
+      static const int     SLOTS_PER_BLOCK = 256;
+      static const int     MAX_BLOCKS = 256;
+
+   protected slots:
+      void SlotExportFile();
+      void SlotNewConnection();
+
+   private:
+      MetricsRegistery();
+
+      QMutex                     m_lock;
+      MetricDescriptorMap_t      m_descriptors;
+      int                        m_nextSlot;
+      QString                    m_exportFile;
+      QTimer                    *m_exportTimer;
+      QLocalServer              *m_server;
+   };
+}
+
+#endif
@@ -27,6 +27,7 @@
 /******************************************************************************/
 #include "MultiSortableTableView.h"
 
+#include "SqlPagedTableModel.h"
 #include "SqlSortableTableModel.h"
 
 #include <QDebug>
@@ -47,40 +48,87 @@ MultiSortableTableView::MultiSortableTableView(QWidget *parent) :
    m_sortColumn = -1;
 }
 
+/********************************************************************//*
+**   bool MultiSortableTableView::SetFilter(const SqlFilter &filter)
+**   
+**   Applies  filter  to  the  model  of  the  view  and reselects it.
+**   The  sort  order  already set on the model is kept. A plain
+**   QSqlTableModel gets the filter with its values inlined.
+**   
+**   Returns  true  if  the  model  could  take a filter, false otherwise.
+***********************************************************************/
+bool MultiSortableTableView::SetFilter(const SqlFilter &filter)
+{
+   bool rv = true;
+   SqlSortableTableModel *sort_model = dynamic_cast<SqlSortableTableModel*>(model());
+   SqlPagedTableModel *paged_model = dynamic_cast<SqlPagedTableModel*>(model());
+   QSqlTableModel *tbl_model = dynamic_cast<QSqlTableModel*>(model());
+
+   qcjDebug(LOG, 1) << __FUNCTION__ << "filter = " << filter.Sql() << ", values = " << filter.Values();
+   if ( sort_model != NULL ) 
+   {
+      sort_model->SetFilter(filter);
+      sort_model->select();
+   }
+   else if ( paged_model != NULL ) 
+   {
+      paged_model->SetFilter(filter);
+      paged_model->select();
+   }
+   else if ( tbl_model != NULL ) 
+   {
+      tbl_model->setFilter(filter.InlineSql(tbl_model->database().driver()));
+      tbl_model->select();
+   }
+   else 
+   {
+      rv = false;
+   }
+   return(rv);
+}
+
 void MultiSortableTableView::SortBy(int section)
 {
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << "section = " << section;
+   qcjDebug(LOG, 1) << __FUNCTION__ << "section = " << section;
    SqlSortableTableModel *sort_model = dynamic_cast<SqlSortableTableModel*>(model());
+   SqlPagedTableModel *paged_model = dynamic_cast<SqlPagedTableModel*>(model());
    if ( sort_model != 0 ) 
    {
-      qDebug(*log(LOG, 1)) << __FUNCTION__ << "Setting sort order for section";
+      qcjDebug(LOG, 1) << __FUNCTION__ << "Setting sort order for section";
       m_sortOrder = sort_model->SetOrder(section);
       m_sortColumn = section;
-      sort_model->select();
+      sort_model->ApplyOrder();
+   }
+   else if ( paged_model != NULL ) 
+   {
+      qcjDebug(LOG, 1) << __FUNCTION__ << "Setting sort order for section of paged model";
+      m_sortOrder = paged_model->SetOrder(section);
+      m_sortColumn = section;
+      paged_model->select();
    }
    else 
    {
       QSqlTableModel *tbl_model = dynamic_cast<QSqlTableModel*>(model());
       if ( tbl_model != NULL ) 
       {
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << "Have table model";
+         qcjDebug(LOG, 1) << __FUNCTION__ << "Have table model";
          if ( section == m_sortColumn ) 
          {
             m_sortOrder = (m_sortOrder == Qt::AscendingOrder ) ? Qt::DescendingOrder : Qt::AscendingOrder;
-            qDebug(*log(LOG, 1)) << __FUNCTION__ << "Flipped order for section";
+            qcjDebug(LOG, 1) << __FUNCTION__ << "Flipped order for section";
 
          }
          else 
          {
             m_sortOrder = Qt::AscendingOrder;
-            qDebug(*log(LOG, 1)) << __FUNCTION__ << "Using Ascending order for section";
+            qcjDebug(LOG, 1) << __FUNCTION__ << "Using Ascending order for section";
          }
 
          m_sortColumn = section;
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << "Sorting model";
+         qcjDebug(LOG, 1) << __FUNCTION__ << "Sorting model";
          tbl_model->sort(m_sortColumn, m_sortOrder);
       }
    }
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << "Setting sort Indicator";
+   qcjDebug(LOG, 1) << __FUNCTION__ << "Setting sort Indicator";
    horizontalHeader()->setSortIndicator(m_sortColumn, m_sortOrder);
 }
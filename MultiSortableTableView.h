@@ -29,6 +29,7 @@
 #define MULTISORTABLETABLEVIEW
 
 #include "LogBuilder.h"
+#include "SqlFilter.h"
 
 #include <QDebug>
 #include <QModelIndex>
@@ -44,12 +45,14 @@ namespace QcjLib
    public:
       MultiSortableTableView(QWidget *parent = NULL);
 
+      bool SetFilter(const SqlFilter &filter);
+
       static const QString LOG;
 
    protected:
       void currentChanged(const QModelIndex &current, const QModelIndex &previous)
       {
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << "Current index changed: " << current;
+         qcjDebug(LOG, 1) << __FUNCTION__ << "Current index changed: " << current;
          QTableView::currentChanged(current, previous);
          emit activated(current);
       };
@@ -0,0 +1,130 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+# include "ProfilerDialog.h"
+# include "ScopeProfiler.h"
+# include "TraceRecorder.h"
+
+# include <QDialogButtonBox>
+# include <QFileDialog>
+# include <QFontDatabase>
+# include <QHBoxLayout>
+# include <QLabel>
+# include <QMessageBox>
+# include <QPushButton>
+# include <QVBoxLayout>
+
+using namespace QcjLib;
+
+ProfilerDialog::ProfilerDialog(QWidget *parent) :
+   QDialog(parent, Qt::Dialog | Qt::WindowMinMaxButtonsHint)
+{
+   setWindowTitle("Scope Profiler");
+
+   QVBoxLayout *layout = new QVBoxLayout(this);
+   QHBoxLayout *top_layout = new QHBoxLayout();
+
+   m_topSpin = new QSpinBox(this);
+   m_topSpin->setRange(0, 10000);
+   m_topSpin->setValue(50);
+   m_topSpin->setSpecialValueText("All");
+   top_layout->addWidget(new QLabel("Sites", this));
+   top_layout->addWidget(m_topSpin);
+   top_layout->addStretch();
+   m_traceCheckBox = new QCheckBox("Record Trace", this);
+   m_traceCheckBox->setChecked(TraceRecorder::IsEnabled());
+   top_layout->addWidget(m_traceCheckBox);
+   layout->addLayout(top_layout);
+
+   m_reportEdit = new QPlainTextEdit(this);
+   m_reportEdit->setReadOnly(true);
+   m_reportEdit->setLineWrapMode(QPlainTextEdit::NoWrap);
+   m_reportEdit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+   layout->addWidget(m_reportEdit);
+
+   QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+   QPushButton *refresh_btn = buttons->addButton("Refresh", QDialogButtonBox::ActionRole);
+   QPushButton *reset_btn = buttons->addButton("Reset", QDialogButtonBox::ResetRole);
+   QPushButton *trace_btn = buttons->addButton("Save Trace...", QDialogButtonBox::ActionRole);
+   layout->addWidget(buttons);
+
+   connect(buttons,     SIGNAL(rejected()),         this, SLOT(reject()));
+   connect(refresh_btn, SIGNAL(clicked()),          this, SLOT(SlotRefresh()));
+   connect(reset_btn,   SIGNAL(clicked()),          this, SLOT(SlotReset()));
+   connect(trace_btn,   SIGNAL(clicked()),          this, SLOT(SlotSaveTrace()));
+   connect(m_topSpin,   SIGNAL(valueChanged(int)),  this, SLOT(SlotRefresh()));
+   connect(m_traceCheckBox, SIGNAL(toggled(bool)),  this, SLOT(SlotSetTracing(bool)));
+
+   resize(900, 500);
+   SlotRefresh();
+}
+
+/********************************************************************//*
+**   QAction *ProfilerDialog::CreateAction(QWidget *parent)
+**   
+**   Returns  an  action  that opens the dialog, for applications
+**   to add to the same menu as their LogDialog.
+***********************************************************************/
+QAction *ProfilerDialog::CreateAction(QWidget *parent)
+{
+   QAction *rv = new QAction("Profiler...", parent);
+
+   QObject::connect(rv, &QAction::triggered, parent, [parent]()
+                    {
+                       ProfilerDialog dlg(parent);
+                       dlg.exec();
+                    });
+   return(rv);
+}
+
+void ProfilerDialog::SlotRefresh()
+{
+   m_reportEdit->setPlainText(ScopeProfiler::Dump(m_topSpin->value()));
+}
+
+void ProfilerDialog::SlotReset()
+{
+   ScopeProfiler::Reset();
+   SlotRefresh();
+}
+
+void ProfilerDialog::SlotSaveTrace()
+{
+   QString filename = QFileDialog::getSaveFileName(this, "Save Trace", "trace.json", "Trace Files (*.json)");
+   if ( ! filename.isEmpty() && ! TraceRecorder::Export(filename) ) 
+   {
+      QMessageBox::critical(this, "Error Saving Trace", "File '" + filename + "' could not be written");
+   }
+}
+
+void ProfilerDialog::SlotSetTracing(bool enable)
+{
+   if ( enable ) 
+      TraceRecorder::Start();
+   else
+      TraceRecorder::Stop();
+}
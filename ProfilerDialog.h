@@ -0,0 +1,68 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef PROFILERDIALOG_H
+#define PROFILERDIALOG_H
+
+# include <QAction>
+# include <QCheckBox>
+# include <QDialog>
+# include <QPlainTextEdit>
+# include <QSpinBox>
+
+namespace QcjLib
+{
+   /********************************************************************//*
+   **   class ProfilerDialog
+   **   
+   **   Shows  the  ScopeProfiler  table of the sites with the most
+   **   total time, and switches the TraceRecorder on and off.
+   ***********************************************************************/
+   class ProfilerDialog : public QDialog
+   {
+      Q_OBJECT
+
+   public:
+      ProfilerDialog(QWidget *parent = NULL);
+
+      static QAction *CreateAction(QWidget *parent);
+
+   public slots:
+      void SlotRefresh();
+      void SlotReset();
+      void SlotSaveTrace();
+      void SlotSetTracing(bool enable);
+
+   protected:
+   private:
+      QCheckBox      *m_traceCheckBox;
+      QSpinBox       *m_topSpin;
+      QPlainTextEdit *m_reportEdit;
+   };
+}
+
+#endif
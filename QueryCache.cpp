@@ -0,0 +1,346 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#include "QueryCache.h"
+
+#include <QDataStream>
+#include <QIODevice>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QSqlField>
+#include <QSqlQuery>
+
+#include <climits>
+
+using namespace QcjLib;
+
+const QString QueryCache::LOG("QcjLib_query_cache");
+static LogBuilder mylog(QueryCache::LOG, 1, "QcjLib Query Result Cache");
+
+const qint64 QueryCache::DEFAULT_BUDGET = 8 * 1024 * 1024;
+
+QSqlRecord CachedResult::Record(int row) const
+{
+   QSqlRecord rv = record;
+   for (int x = 0; x < rv.count(); x++) 
+   {
+      rv.setValue(x, Value(row, x));
+   }
+   return(rv);
+}
+
+QueryCache::QueryCache() :
+   QObject(NULL),
+   m_cache((int)DEFAULT_BUDGET)
+{
+   m_hits = MetricCounter("qcjlib_query_cache_hits_total", "Queries answered from the query cache");
+   m_misses = MetricCounter("qcjlib_query_cache_misses_total", "Queries that were not in the query cache");
+   m_invalidations = MetricCounter("qcjlib_query_cache_invalidations_total", "Query cache entries dropped because a table changed");
+   m_bytes = MetricGauge("qcjlib_query_cache_bytes", "Estimated size of the rows held by the query cache");
+   m_entries = MetricGauge("qcjlib_query_cache_entries", "Results held by the query cache");
+}
+
+/********************************************************************//*
+**   CachedResult_t  QueryCache::Exec(QSqlDatabase  db,  QString  sql, 
+**                                    const QVariantList &values, 
+**                                    QStringList tables, QSqlError *error)
+**   
+**   Returns  the  result  of  sql  with  values  bound  to  its 
+**   placeholders,  from  the  cache  if  it is there. Otherwise the
+**   query  is  run  on  db,  all  its  rows  are  read  and kept in
+**   the  cache  under  tables,  or  the tables TablesIn() finds in
+**   sql when tables is empty.
+**   
+**   Returns  the  rows,  or  a  null  pointer  if the query failed.
+**   The error is then stored in error if it is not NULL.
+***********************************************************************/
+CachedResult_t QueryCache::Exec(QSqlDatabase db, QString sql, const QVariantList &values, 
+                                QStringList tables, QSqlError *error)
+{
+   CachedResult_t rv = Lookup(db, sql, values);
+   if ( rv.isNull() ) 
+   {
+      QSqlQuery q1(db);
+      q1.setForwardOnly(true);
+      q1.prepare(sql);
+      for (int x = 0; x < values.count(); x++) 
+      {
+         q1.bindValue(x, values.at(x));
+      }
+      if ( ! q1.exec() ) 
+      {
+         qcjDebug(LOG, 1) << __FUNCTION__ << "Error: " << q1.lastError().text() << ", sql = " << sql;
+         if ( error != NULL ) 
+         {
+            *error = q1.lastError();
+         }
+         return(rv);
+      }
+
+      CachedResult *result = new CachedResult();
+      result->record = q1.record();
+      result->rows = 0;
+      result->cost = sizeof(CachedResult) + result->record.count() * 64 + sql.size() * 2;
+      for (int x = 0; x < result->record.count(); x++) 
+      {
+         result->record.setValue(x, QVariant());
+      }
+      while ( q1.next() ) 
+      {
+         for (int x = 0; x < result->record.count(); x++) 
+         {
+            QVariant value = q1.value(x);
+            result->cost += Cost(value);
+            result->values.append(value);
+         }
+         result->rows++;
+      }
+      result->values.squeeze();
+      rv = CachedResult_t(result);
+
+      if ( tables.isEmpty() ) 
+      {
+         tables = TablesIn(sql);
+      }
+      Insert(db, sql, values, tables, rv);
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   CachedResult_t QueryCache::Lookup(QSqlDatabase db, QString sql, 
+**                                     const QVariantList &values)
+**   
+**   Returns the cached rows of sql, or a null pointer on a miss.
+***********************************************************************/
+CachedResult_t QueryCache::Lookup(QSqlDatabase db, QString sql, const QVariantList &values)
+{
+   CachedResult_t rv;
+   QByteArray key = Key(db, sql, values);
+
+   QMutexLocker locker(&m_lock);
+   Entry *entry = m_cache.object(key);
+   if ( entry != NULL ) 
+   {
+      rv = entry->result;
+      m_hits.Increment();
+   }
+   else 
+   {
+      m_misses.Increment();
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   void  QueryCache::Insert(QSqlDatabase  db,  QString sql, 
+**                            const QVariantList &values, 
+**                            QStringList tables, CachedResult_t result)
+**   
+**   Keeps  result  as  the  rows  of  sql. Results without tables, or
+**   larger than the whole budget, are not kept.
+***********************************************************************/
+void QueryCache::Insert(QSqlDatabase db, QString sql, const QVariantList &values, 
+                        QStringList tables, CachedResult_t result)
+{
+   if ( result.isNull() || tables.isEmpty() ) 
+   {
+      qcjDebug(LOG, 2) << __FUNCTION__ << "Not caching, no tables for: " << sql;
+      return;
+   }
+
+   Entry *entry = new Entry();
+   entry->result = result;
+   for (int x = 0; x < tables.count(); x++) 
+   {
+      entry->tables.append(TableKey(tables.at(x)));
+   }
+
+   QByteArray key = Key(db, sql, values);
+   QStringList entry_tables = entry->tables;
+
+   QMutexLocker locker(&m_lock);
+   if ( m_cache.insert(key, entry, (int)qMin(result->cost, (qint64)INT_MAX)) ) 
+   {
+      m_tables.insert(key, entry_tables);
+      if ( m_tables.count() > 2 * m_cache.count() + 64 ) 
+      {
+         PruneTables();
+      }
+   }
+   else 
+   {
+      m_tables.remove(key);
+   }
+   UpdateGauges();
+   qcjDebug(LOG, 2) << __FUNCTION__ << "cached " << result->rows << " rows, " << result->cost << " bytes, tables " << entry_tables;
+}
+
+/********************************************************************//*
+**   void QueryCache::Invalidate(QString table)
+**   
+**   Drops  every  result  that  read table. The tables are looked
+**   up  in  m_tables,  QCache::object()  would  make  every  entry
+**   the  most  recently  used  and  lose  the  order  the  budget
+**   drops them in.
+***********************************************************************/
+void QueryCache::Invalidate(QString table)
+{
+   QString table_key = TableKey(table);
+
+   QMutexLocker locker(&m_lock);
+   QHash<QByteArray, QStringList>::iterator it = m_tables.begin();
+   while ( it != m_tables.end() ) 
+   {
+      if ( ! m_cache.contains(it.key()) ) 
+      {
+         it = m_tables.erase(it);
+      }
+      else if ( it.value().contains(table_key) ) 
+      {
+         m_cache.remove(it.key());
+         m_invalidations.Increment();
+         it = m_tables.erase(it);
+      }
+      else 
+      {
+         ++it;
+      }
+   }
+   UpdateGauges();
+   qcjDebug(LOG, 1) << __FUNCTION__ << "table " << table_key << ", " << m_cache.count() << " results left";
+}
+
+void QueryCache::Clear()
+{
+   QMutexLocker locker(&m_lock);
+   m_cache.clear();
+   m_tables.clear();
+   UpdateGauges();
+}
+
+void QueryCache::SetBudget(qint64 bytes)
+{
+   QMutexLocker locker(&m_lock);
+   m_cache.setMaxCost((int)qMin(bytes, (qint64)INT_MAX));
+   UpdateGauges();
+}
+
+qint64 QueryCache::Budget()
+{
+   QMutexLocker locker(&m_lock);
+   return(m_cache.maxCost());
+}
+
+/********************************************************************//*
+**   static QStringList QueryCache::TablesIn(QString sql)
+**   
+**   Returns  the  tables  named  after  from  and join in sql. Tables
+**   in  a  comma  separated  from  list  after the first one are not
+**   found,  queries  using  them  should pass their tables to Exec().
+***********************************************************************/
+QStringList QueryCache::TablesIn(QString sql)
+{
+   static const QRegularExpression table_re("\\b(?:from|join)\\s+((?:\"[^\"]+\"|[\\w$]+)(?:\\.(?:\"[^\"]+\"|[\\w$]+))?)", 
+                                            QRegularExpression::CaseInsensitiveOption);
+   QStringList rv;
+   QRegularExpressionMatchIterator it = table_re.globalMatch(sql);
+   while ( it.hasNext() ) 
+   {
+      QString table = TableKey(it.next().captured(1));
+      if ( ! rv.contains(table) ) 
+      {
+         rv.append(table);
+      }
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   static QString QueryCache::TableKey(QString table)
+**   
+**   Returns  table  as  the  cache  compares it, unquoted, in lower
+**   case and without a schema.
+***********************************************************************/
+QString QueryCache::TableKey(QString table)
+{
+   QString rv = table.trimmed();
+   rv.remove('"');
+   rv.remove('`');
+   rv = rv.mid(rv.lastIndexOf('.') + 1);
+   return(rv.toLower());
+}
+
+QByteArray QueryCache::Key(const QSqlDatabase &db, const QString &sql, const QVariantList &values)
+{
+   QByteArray rv;
+   QDataStream out(&rv, QIODevice::WriteOnly);
+   out << db.connectionName() << sql << values;
+   return(rv);
+}
+
+qint64 QueryCache::Cost(const QVariant &value)
+{
+   qint64 rv = sizeof(QVariant);
+   if ( value.userType() == QMetaType::QString ) 
+   {
+      rv += value.toString().size() * 2;
+   }
+   else if ( value.userType() == QMetaType::QByteArray ) 
+   {
+      rv += value.toByteArray().size();
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   void QueryCache::PruneTables()
+**   
+**   Drops  the  tables  of  the  results  the  cache  has  evicted.
+**   Called with m_lock held.
+***********************************************************************/
+void QueryCache::PruneTables()
+{
+   QHash<QByteArray, QStringList>::iterator it = m_tables.begin();
+   while ( it != m_tables.end() ) 
+   {
+      if ( m_cache.contains(it.key()) ) 
+      {
+         ++it;
+      }
+      else 
+      {
+         it = m_tables.erase(it);
+      }
+   }
+}
+
+void QueryCache::UpdateGauges()
+{
+   m_bytes.Set(m_cache.totalCost());
+   m_entries.Set(m_cache.count());
+}
@@ -0,0 +1,151 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef QUERYCACHE_H
+#define QUERYCACHE_H
+
+#include "LogBuilder.h"
+#include "MetricBuilder.h"
+
+#include <QByteArray>
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSharedPointer>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlRecord>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVariantList>
+#include <QVector>
+
+namespace QcjLib
+{
+   /********************************************************************//*
+   **   struct CachedResult
+   **   
+   **   A  snapshot of the rows of a query. The values are kept in one
+   **   row  major  vector,  record  holds  the  field  names and types
+   **   without values.
+   ***********************************************************************/
+   struct CachedResult
+   {
+      QSqlRecord           record;
+      QVector<QVariant>    values;
+      int                  rows;
+      qint64               cost;
+
+      int columnCount() const
+      {
+         return(record.count());
+      }
+
+      QVariant Value(int row, int column) const
+      {
+         return(values.at(row * record.count() + column));
+      }
+
+      QSqlRecord Record(int row) const;
+   };
+
+   typedef QSharedPointer<const CachedResult> CachedResult_t;
+
+   /********************************************************************//*
+   **   class QueryCache
+   **   
+   **   Process  wide  cache  of  read  query  results, keyed by the
+   **   connection  name,  the  SQL  text  and  the  bound values. The
+   **   cache  holds  at  most  Budget()  bytes  of snapshots, the least
+   **   recently  used  are dropped first. A snapshot handed out stays
+   **   valid after it is dropped from the cache.
+   **
+   **   Every  entry  records the tables its query reads. Invalidate()
+   **   drops  all  entries  reading  a  table,  whatever  connection
+   **   they came from. The data forms call it after they write to a
+   **   table,  other  writers  must  call  it  themselves. A query whose
+   **   tables are not known is never cached.
+   **
+   **      CachedResult_t rows = QueryCache::instance()->Exec(db, "select id, name from color");
+   ***********************************************************************/
+   class QueryCache : public QObject
+   {
+      Q_OBJECT
+
+   public:
+      static QueryCache* instance()
+      {
+         static QueryCache *instance = new QueryCache();
+         return(instance);
+      }
+
+      CachedResult_t Exec(QSqlDatabase db, QString sql, const QVariantList &values = QVariantList(), 
+                          QStringList tables = QStringList(), QSqlError *error = NULL);
+      CachedResult_t Lookup(QSqlDatabase db, QString sql, const QVariantList &values = QVariantList());
+      void Insert(QSqlDatabase db, QString sql, const QVariantList &values, 
+                  QStringList tables, CachedResult_t result);
+      void Invalidate(QString table);
+      void Clear();
+
+      void SetBudget(qint64 bytes);
+      qint64 Budget();
+
+      static QStringList TablesIn(QString sql);
+      static QString TableKey(QString table);
+
+      static const QString LOG;
+      static const qint64 DEFAULT_BUDGET;
+
+   private:
+      struct Entry
+      {
+         CachedResult_t    result;
+         QStringList       tables;
+      };
+
+      QueryCache();
+
+      static QByteArray Key(const QSqlDatabase &db, const QString &sql, const QVariantList &values);
+      static qint64 Cost(const QVariant &value);
+      void PruneTables();
+      void UpdateGauges();
+
+      QMutex                        m_lock;
+      QCache<QByteArray, Entry>     m_cache;
+      QHash<QByteArray, QStringList> m_tables;
+
+      MetricCounter                 m_hits;
+      MetricCounter                 m_misses;
+      MetricCounter                 m_invalidations;
+      MetricGauge                   m_bytes;
+      MetricGauge                   m_entries;
+   };
+}
+
+#endif
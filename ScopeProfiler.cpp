@@ -0,0 +1,356 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+# include "ScopeProfiler.h"
+# include "LogRegistery.h"
+
+# include <QMutex>
+# include <QMutexLocker>
+# include <QVector>
+# include <QtAlgorithms>
+
+# include <algorithm>
+# include <ctype.h>
+
+using namespace QcjLib;
+
+namespace
+{
+   struct ProfileThreadStats
+   {
+      std::atomic<ProfileSiteStats*> blocks[ScopeProfiler::MAX_BLOCKS];
+   };
+
+   struct ProfilerState
+   {
+      QMutex                        lock;
+      QVector<const ProfileSite*>   sites;
+      QVector<ProfileThreadStats*>  threads;
+      QVector<ProfileThreadStats*>  freeThreads;
+   };
+
+   ProfilerState &State()
+   {
+      static ProfilerState state;
+      return(state);
+   }
+
+   /***********************************************/
+   /*   Hands a thread's storage back when the    */
+   /*   thread exits so the next new thread can   */
+   /*   reuse it. What it recorded stays part of  */
+   /*   the totals.                               */
+   /***********************************************/
+   struct ThreadStatsOwner
+   {
+      ProfileThreadStats *stats = NULL;
+
+      ~ThreadStatsOwner()
+      {
+         if ( stats != NULL ) 
+         {
+            QMutexLocker locker(&State().lock);
+            State().freeThreads.append(stats);
+         }
+      }
+   };
+
+   thread_local ProfileThreadStats  *t_stats = NULL;
+   thread_local ThreadStatsOwner     t_owner;
+
+   int RegisterSite(const ProfileSite *site)
+   {
+      int rv = -1;
+      QMutexLocker locker(&State().lock);
+
+      if ( State().sites.size() < ScopeProfiler::SITES_PER_BLOCK * ScopeProfiler::MAX_BLOCKS ) 
+      {
+         rv = State().sites.size();
+         State().sites.append(site);
+      }
+      return(rv);
+   }
+}
+
+ProfileSite::ProfileSite(const char *funct, int line) :
+   funct(funct),
+   file(NULL),
+   line(line),
+   id(-1),
+   descriptor(NULL)
+{
+   id = RegisterSite(this);
+}
+
+ProfileSite::ProfileSite(const char *name, const char *file, int line) :
+   funct(name),
+   file(file),
+   line(line),
+   id(-1),
+   descriptor(NULL)
+{
+   QString log_name("timer.");
+   for (const char *ch = name; *ch != '\0'; ch++) 
+      log_name += isalnum((unsigned char)*ch) || *ch == '_' ? QChar(*ch) : QChar('_');
+
+   LogRegistery::instance()->RegisterLog(log_name, 1, QString("Timer %1 (%2:%3)").arg(name).arg(file).arg(line));
+   descriptor = LogRegistery::instance()->Descriptor(log_name);
+   id = RegisterSite(this);
+}
+
+/********************************************************************//*
+**   int ScopeProfiler::BucketFor(quint64 ns)
+**   
+**   Returns the histogram bucket a duration of ns falls in.
+***********************************************************************/
+int ScopeProfiler::BucketFor(quint64 ns)
+{
+   const int sub_buckets = 1 << ProfileSiteStats::SUB_BUCKET_BITS;
+   int rv;
+
+   if ( ns < (quint64)sub_buckets ) 
+   {
+      rv = (int)ns;
+   }
+   else 
+   {
+      int msb = 63 - qCountLeadingZeroBits(ns);
+      int sub = (int)(ns >> (msb - ProfileSiteStats::SUB_BUCKET_BITS)) & (sub_buckets - 1);
+      rv = ((msb - ProfileSiteStats::SUB_BUCKET_BITS + 1) << ProfileSiteStats::SUB_BUCKET_BITS) + sub;
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   quint64 ScopeProfiler::BucketValue(int bucket)
+**   
+**   Returns the duration at the middle of a histogram bucket.
+***********************************************************************/
+quint64 ScopeProfiler::BucketValue(int bucket)
+{
+   const int sub_buckets = 1 << ProfileSiteStats::SUB_BUCKET_BITS;
+   quint64 rv;
+
+   if ( bucket < sub_buckets ) 
+   {
+      rv = bucket;
+   }
+   else 
+   {
+      int shift = (bucket >> ProfileSiteStats::SUB_BUCKET_BITS) - 1;
+      quint64 low = (quint64)(sub_buckets + (bucket & (sub_buckets - 1))) << shift;
+      rv = low + (((quint64)1 << shift) >> 1);
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   ProfileReport_t ScopeProfiler::Report(int top)
+**   
+**   Merges  the  times  recorded  by  every  thread and returns
+**   one entry per site that has been hit, sorted by total time.
+**   If  top  is  greater  than  zero,  only  that many entries are
+**   returned.
+***********************************************************************/
+ProfileReport_t ScopeProfiler::Report(int top)
+{
+   ProfileReport_t rv;
+   QVector<quint64> buckets(ProfileSiteStats::HISTOGRAM_BUCKETS);
+   QMutexLocker locker(&State().lock);
+
+   for (int id = 0; id < State().sites.size(); id++) 
+   {
+      ProfileEntry entry = { QString(), 0, 0, 0, 0, 0, 0, 0 };
+      buckets.fill(0);
+
+      foreach (ProfileThreadStats *thread, State().threads)
+      {
+         ProfileSiteStats *block = thread->blocks[id / SITES_PER_BLOCK].load(std::memory_order_acquire);
+         if ( block == NULL ) 
+            continue;
+
+         ProfileSiteStats &stats = block[id % SITES_PER_BLOCK];
+         quint64 count = stats.count.load(std::memory_order_relaxed);
+         if ( count == 0 ) 
+            continue;
+
+         quint64 min = stats.min.load(std::memory_order_relaxed);
+         if ( entry.count == 0 || min < entry.min ) 
+            entry.min = min;
+         entry.max = qMax(entry.max, stats.max.load(std::memory_order_relaxed));
+         entry.count += count;
+         entry.total += stats.total.load(std::memory_order_relaxed);
+         for (int x = 0; x < ProfileSiteStats::HISTOGRAM_BUCKETS; x++) 
+            buckets[x] += stats.buckets[x].load(std::memory_order_relaxed);
+      }
+
+      if ( entry.count == 0 ) 
+         continue;
+
+      /***********************************************/
+      /*   Walk the histogram for the percentiles.   */
+      /***********************************************/
+      quint64 histogram_count = 0;
+      for (int x = 0; x < ProfileSiteStats::HISTOGRAM_BUCKETS; x++) 
+         histogram_count += buckets.at(x);
+
+      quint64 seen = 0;
+      for (int x = 0; x < ProfileSiteStats::HISTOGRAM_BUCKETS && entry.p99 == 0; x++) 
+      {
+         seen += buckets.at(x);
+         if ( buckets.at(x) == 0 ) 
+            continue;
+         quint64 value = qBound(entry.min, BucketValue(x), entry.max);
+         if ( entry.p50 == 0 && seen * 100 >= histogram_count * 50 ) 
+            entry.p50 = value;
+         if ( entry.p90 == 0 && seen * 100 >= histogram_count * 90 ) 
+            entry.p90 = value;
+         if ( seen * 100 >= histogram_count * 99 ) 
+            entry.p99 = value;
+      }
+
+      const ProfileSite *site = State().sites.at(id);
+      entry.site = QString("%1@%2").arg(site->funct).arg(site->line);
+      rv.append(entry);
+   }
+   locker.unlock();
+
+   std::sort(rv.begin(), rv.end(), [](const ProfileEntry &a, const ProfileEntry &b)
+             {
+                return(a.total > b.total);
+             });
+   if ( top > 0 && rv.size() > top ) 
+      rv.erase(rv.begin() + top, rv.end());
+   return(rv);
+}
+
+/********************************************************************//*
+**   QString ScopeProfiler::Dump(int top)
+**   
+**   Returns Report(top) formatted as a text table.
+***********************************************************************/
+QString ScopeProfiler::Dump(int top)
+{
+   QString rv;
+   ProfileReport_t report = Report(top);
+
+   int site_width = 4;
+   foreach (ProfileEntry entry, report)
+      site_width = qMax(site_width, entry.site.size());
+
+   rv += QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+            .arg("Site", -site_width)
+            .arg("Count", 10)
+            .arg("Total ms", 12)
+            .arg("Mean us", 10)
+            .arg("Min us", 10)
+            .arg("p50 us", 10)
+            .arg("p90 us", 10)
+            .arg("p99 us", 10)
+            .arg("Max us", 10);
+   foreach (ProfileEntry entry, report)
+   {
+      rv += QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+               .arg(entry.site, -site_width)
+               .arg(entry.count, 10)
+               .arg(entry.total / 1.0e6, 12, 'f', 3)
+               .arg(entry.total / entry.count / 1.0e3, 10, 'f', 1)
+               .arg(entry.min / 1.0e3, 10, 'f', 1)
+               .arg(entry.p50 / 1.0e3, 10, 'f', 1)
+               .arg(entry.p90 / 1.0e3, 10, 'f', 1)
+               .arg(entry.p99 / 1.0e3, 10, 'f', 1)
+               .arg(entry.max / 1.0e3, 10, 'f', 1);
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   void ScopeProfiler::Reset()
+**   
+**   Clears  the  times recorded for every site. Scopes that end
+**   while the reset is in progress may be partly counted.
+***********************************************************************/
+void ScopeProfiler::Reset()
+{
+   QMutexLocker locker(&State().lock);
+
+   foreach (ProfileThreadStats *thread, State().threads)
+   {
+      for (int block_no = 0; block_no < MAX_BLOCKS; block_no++) 
+      {
+         ProfileSiteStats *block = thread->blocks[block_no].load(std::memory_order_acquire);
+         for (int x = 0; block != NULL && x < SITES_PER_BLOCK; x++) 
+         {
+            block[x].count.store(0, std::memory_order_relaxed);
+            block[x].total.store(0, std::memory_order_relaxed);
+            block[x].min.store(0, std::memory_order_relaxed);
+            block[x].max.store(0, std::memory_order_relaxed);
+            for (int y = 0; y < ProfileSiteStats::HISTOGRAM_BUCKETS; y++) 
+               block[x].buckets[y].store(0, std::memory_order_relaxed);
+         }
+      }
+   }
+}
+
+/********************************************************************//*
+**   ProfileSiteStats *ScopeProfiler::ThreadStats(int site_id)
+**   
+**   Returns  the  calling  thread's  storage for site_id, setting
+**   it up the first time the thread or the block of sites is used.
+***********************************************************************/
+ProfileSiteStats *ScopeProfiler::ThreadStats(int site_id)
+{
+   ProfileSiteStats *rv = NULL;
+
+   if ( site_id >= 0 ) 
+   {
+      if ( t_stats == NULL ) 
+      {
+         QMutexLocker locker(&State().lock);
+         if ( State().freeThreads.isEmpty() ) 
+         {
+            t_stats = new ProfileThreadStats();
+            State().threads.append(t_stats);
+         }
+         else 
+         {
+            t_stats = State().freeThreads.takeLast();
+         }
+         t_owner.stats = t_stats;
+      }
+
+      std::atomic<ProfileSiteStats*> &slot = t_stats->blocks[site_id / SITES_PER_BLOCK];
+      ProfileSiteStats *block = slot.load(std::memory_order_relaxed);
+      if ( block == NULL ) 
+      {
+         block = new ProfileSiteStats[SITES_PER_BLOCK]();
+         slot.store(block, std::memory_order_release);
+      }
+      rv = &block[site_id % SITES_PER_BLOCK];
+   }
+   return(rv);
+}
@@ -0,0 +1,150 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef SCOPEPROFILER_H
+#define SCOPEPROFILER_H
+
+# include <QList>
+# include <QString>
+
+# include "LogHandle.h"
+
+# include <atomic>
+
+namespace QcjLib
+{
+   /********************************************************************//*
+   **   struct ProfileSite
+   **   
+   **   Identifies  one  profiled  scope  in the source. Sites are
+   **   meant  to  be  function  local statics, see QCJ_PROFILE_SCOPE()
+   **   and  QCJ_TIME_SCOPE(),  so  each one is registered only once
+   **   and never destroyed.
+   **
+   **   A  site  built  with  a  file  name is also registered in the
+   **   LogRegistery  as  the  one  level  log  "timer.<name>", with
+   **   anything  but  letters,  digits  and  underscores  in  the name
+   **   replaced  by  underscores.  Setting that log to level 0 turns
+   **   the site off.
+   ***********************************************************************/
+   struct ProfileSite
+   {
+      ProfileSite(const char *funct, int line);
+      ProfileSite(const char *name, const char *file, int line);
+
+      bool IsEnabled() const
+      {
+         return(descriptor == NULL || descriptor->level.load(std::memory_order_relaxed) > 0);
+      }
+
+      const char     *funct;
+      const char     *file;
+      int             line;
+      int             id;
+      LogDescriptor  *descriptor;
+   };
+
+   /********************************************************************//*
+   **   struct ProfileSiteStats
+   **   
+   **   The  times  recorded for one site by one thread. Only the
+   **   owning  thread  writes  to  it,  the  atomics let reports read
+   **   it while it is being updated.
+   **
+   **   Durations  are  in  nanoseconds.  The  histogram  is  log-
+   **   linear,  each  power of two is split into four buckets, which
+   **   keeps percentiles within about 12% of the actual value.
+   ***********************************************************************/
+   struct ProfileSiteStats
+   {
+      static const int  SUB_BUCKET_BITS = 2;
+      static const int  HISTOGRAM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+      std::atomic<quint64> count;
+      std::atomic<quint64> total;
+      std::atomic<quint64> min;
+      std::atomic<quint64> max;
+      std::atomic<quint64> buckets[HISTOGRAM_BUCKETS];
+   };
+
+   struct ProfileEntry
+   {
+      QString  site;
+      quint64  count;
+      quint64  total;
+      quint64  min;
+      quint64  max;
+      quint64  p50;
+      quint64  p90;
+      quint64  p99;
+   };
+
+   typedef QList<ProfileEntry> ProfileReport_t;
+
+   /********************************************************************//*
+   **   class ScopeProfiler
+   **   
+   **   Aggregates  the  times  of  profiled  scopes  by call site.
+   **   Each  thread  records  into  its  own  storage,  Report()
+   **   merges the storage of all threads when it is called.
+   ***********************************************************************/
+   class ScopeProfiler
+   {
+   public:
+      static void Record(const ProfileSite &site, quint64 ns)
+      {
+         ProfileSiteStats *stats = ThreadStats(site.id);
+         if ( stats != NULL ) 
+         {
+            quint64 count = stats->count.load(std::memory_order_relaxed);
+            int bucket = BucketFor(ns);
+            stats->count.store(count + 1, std::memory_order_relaxed);
+            stats->total.store(stats->total.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+            if ( count == 0 || ns < stats->min.load(std::memory_order_relaxed) ) 
+               stats->min.store(ns, std::memory_order_relaxed);
+            if ( ns > stats->max.load(std::memory_order_relaxed) ) 
+               stats->max.store(ns, std::memory_order_relaxed);
+            stats->buckets[bucket].store(stats->buckets[bucket].load(std::memory_order_relaxed) + 1, 
+                                         std::memory_order_relaxed);
+         }
+      }
+
+      static int              BucketFor(quint64 ns);
+      static quint64          BucketValue(int bucket);
+      static QString          Dump(int top = 0);
+      static ProfileReport_t  Report(int top = 0);
+      static void             Reset();
+
+      static const int  SITES_PER_BLOCK = 16;
+      static const int  MAX_BLOCKS = 256;
+
+   private:
+      static ProfileSiteStats *ThreadStats(int site_id);
+   };
+}
+
+#endif
@@ -0,0 +1,53 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+# include "ScopeStack.h"
+
+using namespace QcjLib;
+
+std::atomic<bool> ScopeStack::s_active(false);
+
+/********************************************************************//*
+**   QStringList ScopeStack::Snapshot() const
+**   
+**   Returns  the  open  scopes  as  "name@line", outermost first.
+**   Scopes nested deeper than MAX_DEPTH are shown as "...".
+***********************************************************************/
+QStringList ScopeStack::Snapshot() const
+{
+   QStringList rv;
+   int depth = m_depth.load(std::memory_order_acquire);
+
+   for (int x = 0; x < depth && x < MAX_DEPTH; x++) 
+   {
+      const char *name = m_names[x].load(std::memory_order_relaxed);
+      rv << QString("%1@%2").arg(name != NULL ? name : "?").arg(m_lines[x].load(std::memory_order_relaxed));
+   }
+   if ( depth > MAX_DEPTH ) 
+      rv << "...";
+   return(rv);
+}
@@ -0,0 +1,110 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef SCOPESTACK_H
+#define SCOPESTACK_H
+
+# include <QStringList>
+
+# include <atomic>
+
+namespace QcjLib
+{
+   /********************************************************************//*
+   **   class ScopeStack
+   **   
+   **   The  DbgTimer  scopes  currently  open on a thread. While the
+   **   stacks  are active, see SetActive(), each thread keeps its own
+   **   stack  and  other  threads  may  take a Snapshot() of it, which
+   **   is how the StallDetector reports what the GUI thread is busy
+   **   with.
+   **
+   **   Only  the  owning  thread  pushes  and  pops.  Readers  see a
+   **   consistent  stack  unless  it changes while they read it, in
+   **   which case the result is a best guess.
+   ***********************************************************************/
+   class ScopeStack
+   {
+   public:
+      static bool IsActive()
+      {
+         return(s_active.load(std::memory_order_relaxed));
+      }
+
+      static void SetActive(bool active)
+      {
+         s_active.store(active, std::memory_order_relaxed);
+      }
+
+      static ScopeStack *Current()
+      {
+         thread_local ScopeStack stack;
+         return(&stack);
+      }
+
+      /***********************************************/
+      /*   name must be a string that is never       */
+      /*   freed, such as a literal.                 */
+      /***********************************************/
+      static bool Push(const char *name, int line)
+      {
+         ScopeStack *stack = Current();
+         int depth = stack->m_depth.load(std::memory_order_relaxed);
+         if ( depth < MAX_DEPTH ) 
+         {
+            stack->m_names[depth].store(name, std::memory_order_relaxed);
+            stack->m_lines[depth].store(line, std::memory_order_relaxed);
+         }
+         stack->m_depth.store(depth + 1, std::memory_order_release);
+         return(true);
+      }
+
+      static void Pop()
+      {
+         ScopeStack *stack = Current();
+         stack->m_depth.store(stack->m_depth.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+      }
+
+      QStringList Snapshot() const;
+
+      static const int  MAX_DEPTH = 32;
+
+   private:
+      ScopeStack() :
+         m_depth(0)
+      {
+      }
+
+      std::atomic<int>           m_depth;
+      std::atomic<const char*>   m_names[MAX_DEPTH];
+      std::atomic<int>           m_lines[MAX_DEPTH];
+
+      static std::atomic<bool>   s_active;
+   };
+}
+
+#endif
@@ -0,0 +1,432 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#include "SqlColumnStore.h"
+
+#include <QDate>
+#include <QDateTime>
+#include <QSqlField>
+#include <QTime>
+
+using namespace QcjLib;
+
+SqlColumnStore::SqlColumnStore() :
+   m_rows(0)
+{
+}
+
+/********************************************************************//*
+**   void SqlColumnStore::Reset(const QSqlRecord &record)
+**   
+**   Drops  all  rows  and  sets  up  the  columns  of  record, whose
+**   field types are kept for the NULLs of columns with no values.
+***********************************************************************/
+void SqlColumnStore::Reset(const QSqlRecord &record)
+{
+   m_record = record;
+   for (int x = 0; x < m_record.count(); x++) 
+   {
+      m_record.setValue(x, QVariant());
+   }
+
+   m_columns.clear();
+   m_columns.resize(m_record.count());
+   for (int x = 0; x < m_columns.count(); x++) 
+   {
+      m_columns[x].type = UnknownColumn;
+      m_columns[x].metaType = m_record.field(x).type();
+   }
+   m_rows = 0;
+}
+
+void SqlColumnStore::AppendRow(const QSqlQuery &query)
+{
+   for (int x = 0; x < m_columns.count(); x++) 
+   {
+      Append(m_columns[x], query.value(x));
+   }
+   m_rows++;
+}
+
+void SqlColumnStore::AppendRow(const QVector<QVariant> &row)
+{
+   for (int x = 0; x < m_columns.count(); x++) 
+   {
+      Append(m_columns[x], row.value(x));
+   }
+   m_rows++;
+}
+
+/********************************************************************//*
+**   void SqlColumnStore::Squeeze()
+**   
+**   Releases  the  spare  capacity  the vectors grew into, for when
+**   no more rows are coming.
+***********************************************************************/
+void SqlColumnStore::Squeeze()
+{
+   for (int x = 0; x < m_columns.count(); x++) 
+   {
+      Column &col = m_columns[x];
+      col.nulls.squeeze();
+      col.ints.squeeze();
+      col.doubles.squeeze();
+      col.arena.squeeze();
+      col.offsets.squeeze();
+      col.variants.squeeze();
+   }
+}
+
+bool SqlColumnStore::IsNumeric(int column) const
+{
+   const Column &col = m_columns.at(column);
+   ColumnType type = (col.type == UnknownColumn) ? TypeOf(col.metaType) : col.type;
+   return(type != StringColumn && type != VariantColumn && type != UnknownColumn);
+}
+
+/********************************************************************//*
+**   bool SqlColumnStore::IsIntegral(int column) const
+**   
+**   Returns  true  if  the  column's  values  are  kept  as qint64,
+**   which Integer() returns exactly.
+***********************************************************************/
+bool SqlColumnStore::IsIntegral(int column) const
+{
+   const Column &col = m_columns.at(column);
+   ColumnType type = (col.type == UnknownColumn) ? TypeOf(col.metaType) : col.type;
+   return(type == Int64Column || type == DateColumn || type == TimeColumn || type == DateTimeColumn);
+}
+
+/********************************************************************//*
+**   double SqlColumnStore::Number(int row, int column) const
+**   
+**   Returns  a  value  of  a  numeric  column as a number to compare
+**   by.  Dates  are  Julian  days,  times  and  timestamps  are
+**   milliseconds. NULLs are 0.
+***********************************************************************/
+double SqlColumnStore::Number(int row, int column) const
+{
+   double rv = 0;
+   const Column &col = m_columns.at(column);
+
+   if ( col.type == DoubleColumn ) 
+   {
+      rv = col.doubles.at(row);
+   }
+   else if ( ! col.ints.isEmpty() ) 
+   {
+      rv = col.ints.at(row);
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   qint64 SqlColumnStore::Integer(int row, int column) const
+**   
+**   As  Number()  for  an  integral  column,  without  rounding values
+**   beyond 2^53. NULLs are 0.
+***********************************************************************/
+qint64 SqlColumnStore::Integer(int row, int column) const
+{
+   const Column &col = m_columns.at(column);
+   return(col.ints.isEmpty() ? 0 : col.ints.at(row));
+}
+
+QString SqlColumnStore::String(int row, int column) const
+{
+   const Column &col = m_columns.at(column);
+
+   if ( col.type == StringColumn ) 
+   {
+      quint32 start = (row > 0) ? col.offsets.at(row - 1) : 0;
+      return(col.arena.mid(start, col.offsets.at(row) - start));
+   }
+   return(Value(row, column).toString());
+}
+
+QVariant SqlColumnStore::Value(int row, int column) const
+{
+   return(ValueOf(m_columns.at(column), row));
+}
+
+/********************************************************************//*
+**   qint64 SqlColumnStore::MemoryUsage() const
+**   
+**   Returns  the  bytes  allocated  for the values, not counting
+**   what QVariant columns point to.
+***********************************************************************/
+qint64 SqlColumnStore::MemoryUsage() const
+{
+   qint64 rv = 0;
+   for (int x = 0; x < m_columns.count(); x++) 
+   {
+      const Column &col = m_columns.at(x);
+      rv += col.nulls.capacity() * sizeof(quint64);
+      rv += col.ints.capacity() * sizeof(qint64);
+      rv += col.doubles.capacity() * sizeof(double);
+      rv += col.arena.capacity() * sizeof(QChar);
+      rv += col.offsets.capacity() * sizeof(quint32);
+      rv += col.variants.capacity() * sizeof(QVariant);
+   }
+   return(rv);
+}
+
+SqlColumnStore::ColumnType SqlColumnStore::TypeOf(int meta_type)
+{
+   ColumnType rv;
+
+   switch (meta_type)
+   {
+      case QMetaType::Bool:
+      case QMetaType::Short:
+      case QMetaType::UShort:
+      case QMetaType::Int:
+      case QMetaType::UInt:
+      case QMetaType::Long:
+      case QMetaType::ULong:
+      case QMetaType::LongLong:
+      case QMetaType::ULongLong:
+         rv = Int64Column;
+         break;
+
+      case QMetaType::Float:
+      case QMetaType::Double:
+         rv = DoubleColumn;
+         break;
+
+      case QMetaType::QDate:
+         rv = DateColumn;
+         break;
+
+      case QMetaType::QTime:
+         rv = TimeColumn;
+         break;
+
+      case QMetaType::QDateTime:
+         rv = DateTimeColumn;
+         break;
+
+      case QMetaType::QString:
+         rv = StringColumn;
+         break;
+
+      default:
+         rv = VariantColumn;
+         break;
+   }
+   return(rv);
+}
+
+void SqlColumnStore::Append(Column &col, const QVariant &value)
+{
+   int row = m_rows;
+
+   if ( (row & 63) == 0 ) 
+   {
+      col.nulls.append(0);
+   }
+   if ( value.isNull() ) 
+   {
+      col.nulls[row >> 6] |= Q_UINT64_C(1) << (row & 63);
+      AppendEmpty(col);
+      return;
+   }
+
+   if ( col.type == UnknownColumn ) 
+   {
+      SetType(col, value.userType(), row);
+   }
+   else if ( col.type != VariantColumn && value.userType() != col.metaType ) 
+   {
+      ToVariant(col, row);
+   }
+
+   switch (col.type)
+   {
+      case Int64Column:
+         col.ints.append(col.metaType == QMetaType::ULongLong ? (qint64)value.toULongLong() : value.toLongLong());
+         break;
+
+      case DoubleColumn:
+         col.doubles.append(value.toDouble());
+         break;
+
+      case DateColumn:
+         col.ints.append(value.toDate().toJulianDay());
+         break;
+
+      case TimeColumn:
+         col.ints.append(value.toTime().msecsSinceStartOfDay());
+         break;
+
+      case DateTimeColumn:
+         col.ints.append(value.toDateTime().toMSecsSinceEpoch());
+         break;
+
+      case StringColumn:
+         col.arena += value.toString();
+         col.offsets.append((quint32)col.arena.size());
+         break;
+
+      default:
+         col.variants.append(value);
+         break;
+   }
+}
+
+void SqlColumnStore::AppendEmpty(Column &col)
+{
+   switch (col.type)
+   {
+      case UnknownColumn:
+         break;
+
+      case DoubleColumn:
+         col.doubles.append(0);
+         break;
+
+      case StringColumn:
+         col.offsets.append((quint32)col.arena.size());
+         break;
+
+      case VariantColumn:
+         col.variants.append(QVariant());
+         break;
+
+      default:
+         col.ints.append(0);
+         break;
+   }
+}
+
+/********************************************************************//*
+**   static void SqlColumnStore::SetType(Column &col, int meta_type, int rows) private
+**   
+**   Gives  a  column  that  so  far  only  had  NULLs  its type, with
+**   room for the rows NULLs before it.
+***********************************************************************/
+void SqlColumnStore::SetType(Column &col, int meta_type, int rows)
+{
+   col.type = TypeOf(meta_type);
+   col.metaType = meta_type;
+
+   switch (col.type)
+   {
+      case DoubleColumn:
+         col.doubles.resize(rows);
+         break;
+
+      case StringColumn:
+         col.offsets.resize(rows);
+         break;
+
+      case VariantColumn:
+         col.variants.resize(rows);
+         break;
+
+      default:
+         col.ints.resize(rows);
+         break;
+   }
+}
+
+/********************************************************************//*
+**   static void SqlColumnStore::ToVariant(Column &col, int rows) private
+**   
+**   Moves the first rows values of a typed column to QVariants.
+***********************************************************************/
+void SqlColumnStore::ToVariant(Column &col, int rows)
+{
+   QVector<QVariant> variants(rows);
+   for (int x = 0; x < rows; x++) 
+   {
+      variants[x] = ValueOf(col, x);
+   }
+
+   col.type = VariantColumn;
+   col.ints = QVector<qint64>();
+   col.doubles = QVector<double>();
+   col.arena = QString();
+   col.offsets = QVector<quint32>();
+   col.variants = variants;
+}
+
+QVariant SqlColumnStore::ValueOf(const Column &col, int row)
+{
+   QVariant rv;
+
+   if ( IsNull(col, row) ) 
+   {
+      return(QVariant((QVariant::Type)col.metaType));
+   }
+
+   switch (col.type)
+   {
+      case Int64Column:
+         switch (col.metaType)
+         {
+            case QMetaType::Bool:      rv = QVariant(col.ints.at(row) != 0);           break;
+            case QMetaType::Int:       rv = QVariant((int)col.ints.at(row));           break;
+            case QMetaType::UInt:      rv = QVariant((uint)col.ints.at(row));          break;
+            case QMetaType::ULongLong: rv = QVariant((qulonglong)col.ints.at(row));    break;
+            case QMetaType::LongLong:  rv = QVariant((qlonglong)col.ints.at(row));     break;
+            default:
+               rv = QVariant((qlonglong)col.ints.at(row));
+               rv.convert(col.metaType);
+               break;
+         }
+         break;
+
+      case DoubleColumn:
+         rv = QVariant(col.doubles.at(row));
+         break;
+
+      case DateColumn:
+         rv = QVariant(QDate::fromJulianDay(col.ints.at(row)));
+         break;
+
+      case TimeColumn:
+         rv = QVariant(QTime::fromMSecsSinceStartOfDay(col.ints.at(row)));
+         break;
+
+      case DateTimeColumn:
+         rv = QVariant(QDateTime::fromMSecsSinceEpoch(col.ints.at(row)));
+         break;
+
+      case StringColumn:
+         {
+            quint32 start = (row > 0) ? col.offsets.at(row - 1) : 0;
+            rv = QVariant(col.arena.mid(start, col.offsets.at(row) - start));
+         }
+         break;
+
+      default:
+         rv = col.variants.at(row);
+         break;
+   }
+   return(rv);
+}
@@ -0,0 +1,144 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef SQLCOLUMNSTORE_H
+#define SQLCOLUMNSTORE_H
+
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+namespace QcjLib
+{
+   /********************************************************************//*
+   **   class SqlColumnStore
+   **   
+   **   Holds  a  query  result  column  by  column, each in a vector
+   **   of  its  own  type  rather  than  a QVariant per cell. Integers,
+   **   booleans,  dates,  times  and  timestamps  are  kept  as qint64,
+   **   floating  point  as  double  and  strings  in one UTF-16 arena
+   **   per  column  with  the end offset of each row. NULLs are a bit
+   **   per row. Other types, blobs for instance, are kept as QVariant.
+   **
+   **   A  column's  type  is  taken  from  its  first  non NULL value.
+   **   Should  a  later  value  be of another type, as SQLite allows,
+   **   the column falls back to QVariant storage.
+   **
+   **   Timestamps  are  kept  as  milliseconds  since the epoch and come
+   **   back in local time. The string arena of a column holds at most
+   **   4G characters.
+   ***********************************************************************/
+   class SqlColumnStore
+   {
+   public:
+      enum ColumnType
+      {
+         UnknownColumn,
+         Int64Column,
+         DoubleColumn,
+         DateColumn,
+         TimeColumn,
+         DateTimeColumn,
+         StringColumn,
+         VariantColumn
+      };
+
+      SqlColumnStore();
+
+      void Reset(const QSqlRecord &record);
+      void AppendRow(const QSqlQuery &query);
+      void AppendRow(const QVector<QVariant> &row);
+      void Squeeze();
+
+      int RowCount() const
+      {
+         return(m_rows);
+      }
+
+      int ColumnCount() const
+      {
+         return(m_columns.count());
+      }
+
+      QSqlRecord Record() const
+      {
+         return(m_record);
+      }
+
+      ColumnType Type(int column) const
+      {
+         return(m_columns.at(column).type);
+      }
+
+      bool IsNull(int row, int column) const
+      {
+         return(IsNull(m_columns.at(column), row));
+      }
+
+      bool IsNumeric(int column) const;
+      bool IsIntegral(int column) const;
+      double Number(int row, int column) const;
+      qint64 Integer(int row, int column) const;
+      QString String(int row, int column) const;
+      QVariant Value(int row, int column) const;
+      qint64 MemoryUsage() const;
+
+      static ColumnType TypeOf(int meta_type);
+
+   private:
+      struct Column
+      {
+         ColumnType           type;
+         int                  metaType;
+         QVector<quint64>     nulls;
+         QVector<qint64>      ints;
+         QVector<double>      doubles;
+         QString              arena;
+         QVector<quint32>     offsets;
+         QVector<QVariant>    variants;
+      };
+
+      static bool IsNull(const Column &col, int row)
+      {
+         return((col.nulls.at(row >> 6) >> (row & 63)) & 1);
+      }
+
+      void Append(Column &col, const QVariant &value);
+      static void AppendEmpty(Column &col);
+      static void SetType(Column &col, int meta_type, int rows);
+      static void ToVariant(Column &col, int rows);
+      static QVariant ValueOf(const Column &col, int row);
+
+      QSqlRecord        m_record;
+      QVector<Column>   m_columns;
+      int               m_rows;
+   };
+}
+
+#endif
@@ -36,6 +36,7 @@
 # include <QWidget>
 # include <QTextEdit>
 
+# include "QueryCache.h"
 # include "SqlDbFormDelegate.h"
 
 using namespace QcjLib;
@@ -46,8 +47,8 @@ static LogBuilder mylog(SqlDbForm::LOG, 3, "QcjLib Database Form");
 SqlDbForm::SqlDbForm(QWidget *parent) : QFrame(parent),
                                         m_model(NULL)
 {
-   qDebug(*log(LOG, 3)) << __FUNCTION__ << "Enter: this = " << (unsigned long)this;
-   qDebug(*log(LOG, 3)) << __FUNCTION__ << "Exit";
+   qcjDebug(LOG, 3) << __FUNCTION__ << "Enter: this = " << (unsigned long)this;
+   qcjDebug(LOG, 3) << __FUNCTION__ << "Exit";
 }
 
 SqlDbForm::~SqlDbForm()
@@ -58,37 +59,37 @@ void SqlDbForm::SetDatabase(DbInterface *dbLoader)
 {
    QMap<int, QString>      forder;
 
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << "Enter: " << (unsigned long)this;
+   qcjDebug(LOG, 1) << __FUNCTION__ << "Enter: " << (unsigned long)this;
    m_dbInterface = dbLoader;
 
    m_formMapper = new QDataWidgetMapper(this);
-   qDebug(*log(LOG, 2)) << __FUNCTION__ << "QDataWidgetMapper submit policy: " << m_formMapper->submitPolicy();
+   qcjDebug(LOG, 2) << __FUNCTION__ << "QDataWidgetMapper submit policy: " << m_formMapper->submitPolicy();
    m_fields.clear();
    m_rawFieldNames.clear();
 
    QString table = property("sql_table_name").toString();
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << ": Table: " << table;
+   qcjDebug(LOG, 1) << __FUNCTION__ << ": Table: " << table;
    m_rawTableName = table;
    m_table = m_dbInterface->GetTableName(table);
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << ": xlated table name: " << m_table;
+   qcjDebug(LOG, 1) << __FUNCTION__ << ": xlated table name: " << m_table;
    QString sql = "select * from " + m_table;
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << ": sql = " << sql;
+   qcjDebug(LOG, 1) << __FUNCTION__ << ": sql = " << sql;
    QSqlQuery q1(m_dbInterface->database());
    q1.prepare(sql);
    q1.exec();
    q1.next();
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << ": Executed query: " << q1.executedQuery();
-   qDebug(*log(LOG, 2)) << __FUNCTION__ << ": Error reading query: " <<
+   qcjDebug(LOG, 1) << __FUNCTION__ << ": Executed query: " << q1.executedQuery();
+   qcjDebug(LOG, 2) << __FUNCTION__ << ": Error reading query: " <<
                q1.lastError().databaseText() <<
                " - " <<
                q1.lastError().driverText();
    QSqlRecord tableRecord = q1.record();
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << ": have " << tableRecord.count() << " record fields";
+   qcjDebug(LOG, 1) << __FUNCTION__ << ": have " << tableRecord.count() << " record fields";
    if ( tableRecord.count() > 0 ) 
    {
-      qDebug(*log(LOG, 1)) << __FUNCTION__ << ": have " << tableRecord.count() << " record fields";
+      qcjDebug(LOG, 1) << __FUNCTION__ << ": have " << tableRecord.count() << " record fields";
       QObjectList childList = children();
-      qDebug(*log(LOG, 1)) << __FUNCTION__ << ": found " << childList.count() << " child widgets";
+      qcjDebug(LOG, 1) << __FUNCTION__ << ": found " << childList.count() << " child widgets";
       
       int column = 0;
       foreach (QObject *child, childList)
@@ -100,7 +101,7 @@ void SqlDbForm::SetDatabase(DbInterface *dbLoader)
             QVariant primary        = cw->property("primary_field");
             QVariant sort_order     = cw->property("sort_order");
             QVariant force_enabled  = cw->property("force_enabled");
-            qDebug(*log(LOG, 1)) << __FUNCTION__ << ": found widget name: " << field << ", index = " << tableRecord.indexOf(field.toString());
+            qcjDebug(LOG, 1) << __FUNCTION__ << ": found widget name: " << field << ", index = " << tableRecord.indexOf(field.toString());
 
             QString fname = field.toString();
             QStringList sl = fname.split("@");
@@ -108,26 +109,26 @@ void SqlDbForm::SetDatabase(DbInterface *dbLoader)
             fname = m_dbInterface->GetIndexName(rawName);
             if ( field.isValid() && tableRecord.indexOf(fname) >= 0 ) 
             {
-               qDebug(*log(LOG, 1)) << __FUNCTION__ << ": fname: " << fname;
+               qcjDebug(LOG, 1) << __FUNCTION__ << ": fname: " << fname;
                
                if ( sl.count() > 1 ) 
                {
-                  qDebug(*log(LOG, 1)) << __FUNCTION__ << ": adding relation: " << sl[1];
+                  qcjDebug(LOG, 1) << __FUNCTION__ << ": adding relation: " << sl[1];
                   m_relations.insert(fname, sl[1]);
                }
 
                if ( primary.isValid() && primary.toBool() ) 
                {
-                  qDebug(*log(LOG, 1)) << __FUNCTION__ << ": Prepending field: " << fname;
+                  qcjDebug(LOG, 1) << __FUNCTION__ << ": Prepending field: " << fname;
                   m_fields.prepend(fname);
                }
                else 
                {
-                  qDebug(*log(LOG, 1)) << __FUNCTION__ << ": Appending field: " << fname;
+                  qcjDebug(LOG, 1) << __FUNCTION__ << ": Appending field: " << fname;
                   m_fields.append(fname);
                }
                m_formWidgets.insert(fname, cw);
-               qDebug(*log(LOG, 1)) << __FUNCTION__ << ": Appending raw field name: " << rawName;
+               qcjDebug(LOG, 1) << __FUNCTION__ << ": Appending raw field name: " << rawName;
                m_rawFieldNames.append(rawName);
 
                if ( sort_order.isValid() ) 
@@ -145,7 +146,7 @@ void SqlDbForm::SetDatabase(DbInterface *dbLoader)
       if ( m_fields.count() > 0 ) 
       {
          m_select = "select " + m_fields.join(", ") + " from " + m_table + " ";
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << ": m_select = " << m_select;
+         qcjDebug(LOG, 1) << __FUNCTION__ << ": m_select = " << m_select;
          m_order.clear();
          foreach (int priority, forder.keys())
          {
@@ -162,7 +163,7 @@ void SqlDbForm::SetDatabase(DbInterface *dbLoader)
       }
    }
    m_model = new QSqlQueryModel(this);
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << "Exit";
+   qcjDebug(LOG, 1) << __FUNCTION__ << "Exit";
 }
 
 /***********************************************************************************************************/
@@ -172,8 +173,8 @@ void SqlDbForm::SetDatabase(DbInterface *dbLoader)
 /***********************************************************************************************************/
 void SqlDbForm::setQueryStatement(QString whereClause)
 {
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << "Enter: " << (unsigned long)this;
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << ": m_select = " << m_select;
+   qcjDebug(LOG, 1) << __FUNCTION__ << "Enter: " << (unsigned long)this;
+   qcjDebug(LOG, 1) << __FUNCTION__ << ": m_select = " << m_select;
    QString sql = m_select;
    if ( whereClause.size() > 0 ) 
    {
@@ -195,51 +196,49 @@ void SqlDbForm::setQueryStatement(QString whereClause)
    if ( it != m_formWidgets.constEnd() && 
         m_formMapper->mappedSection(it.value()) == -1) 
    {
-      qDebug(*log(LOG, 1)) << __FUNCTION__ << "Mapping widgets!";
+      qcjDebug(LOG, 1) << __FUNCTION__ << "Mapping widgets!";
       SqlDbFormDelegate *delegate = new SqlDbFormDelegate(this);
       m_formMapper->setItemDelegate(delegate);
 
       QSqlRecord rec = m_model->record();
       while ( it != m_formWidgets.constEnd() )
       {
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << ": Index of field " << it.key() << ": " << rec.indexOf(it.key());
+         qcjDebug(LOG, 1) << __FUNCTION__ << ": Index of field " << it.key() << ": " << rec.indexOf(it.key());
          if ( m_relations.contains(it.key()) && it.value()->inherits("QComboBox") ) 
          {
-            qDebug(*log(LOG, 1)) << __FUNCTION__ << "Have relational combobox";
+            qcjDebug(LOG, 1) << __FUNCTION__ << "Have relational combobox";
             QComboBox *wdt = dynamic_cast<QComboBox*>(it.value());
             wdt->clear();
             QString sql = m_relations.value(it.key());
-            qDebug(*log(LOG, 1)) << __FUNCTION__ << "sql = " << sql;
-            QSqlQuery q1(m_dbInterface->database());
-            q1.prepare(sql);
-            q1.exec();
-            while (q1.next())
+            qcjDebug(LOG, 1) << __FUNCTION__ << "sql = " << sql;
+            CachedResult_t rows = QueryCache::instance()->Exec(m_dbInterface->database(), sql);
+            for (int row = 0; ! rows.isNull() && row < rows->rows; row++)
             {
-               qDebug(*log(LOG, 1)) << __FUNCTION__ << "text = " << q1.value(1) << ", value = " << q1.value(0);
-               wdt->addItem(q1.value(1).toString(), q1.value(0).toInt());
+               qcjDebug(LOG, 1) << __FUNCTION__ << "text = " << rows->Value(row, 1) << ", value = " << rows->Value(row, 0);
+               wdt->addItem(rows->Value(row, 1).toString(), rows->Value(row, 0).toInt());
             }
          }
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << "mapping Object named" << it.value()->objectName() << " to field " << it.key();
+         qcjDebug(LOG, 1) << __FUNCTION__ << "mapping Object named" << it.value()->objectName() << " to field " << it.key();
          m_formMapper->addMapping(it.value(), rec.indexOf(it.key()));
          ++it;
       }         
    }
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << "Exit";
+   qcjDebug(LOG, 1) << __FUNCTION__ << "Exit";
 }
 
 QSqlQueryModel *SqlDbForm::model()
 {
-   qDebug(*log(LOG, 2)) << __FUNCTION__ << "Enter";
-   qDebug(*log(LOG, 2)) << __FUNCTION__ << "Exit";
+   qcjDebug(LOG, 2) << __FUNCTION__ << "Enter";
+   qcjDebug(LOG, 2) << __FUNCTION__ << "Exit";
    return(m_model);
 }
 
 void SqlDbForm::setCurrentModelIndex(QModelIndex index)
 {
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << "Enter- form = " << this;
+   qcjDebug(LOG, 1) << __FUNCTION__ << "Enter- form = " << this;
    if ( index.isValid() ) 
    {
-      qDebug(*log(LOG, 1)) << __FUNCTION__ << "Index is valid: " << index;
+      qcjDebug(LOG, 1) << __FUNCTION__ << "Index is valid: " << index;
       setEnabled(true);
       m_formMapper->setCurrentModelIndex(index);
       foreach(QWidget *wdt, m_formWidgets)
@@ -276,7 +275,7 @@ void SqlDbForm::setCurrentModelIndex(QModelIndex index)
          {
             if ( static_cast<QComboBox*>(wdt)->isEnabled() )
             {
-               qDebug(*log(LOG, 1)) << __FUNCTION__ << "Disabling combobox";
+               qcjDebug(LOG, 1) << __FUNCTION__ << "Disabling combobox";
                static_cast<QComboBox*>(wdt)->setEnabled(true);
             }
          }
@@ -284,7 +283,7 @@ void SqlDbForm::setCurrentModelIndex(QModelIndex index)
    }
    else 
    {
-      qDebug(*log(LOG, 1)) << __FUNCTION__ << "Index is INVALID!!";
+      qcjDebug(LOG, 1) << __FUNCTION__ << "Index is INVALID!!";
       setEnabled(false);
    }
 }
@@ -299,27 +298,27 @@ QString SqlDbForm::GetFormValue(QString field_name)
       wdt = m_formWidgets.value(field_name);
       if ( wdt->inherits("QLineEdit")  ) 
       {
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << "field " << field_name << " is a QLineEdit";
+         qcjDebug(LOG, 1) << __FUNCTION__ << "field " << field_name << " is a QLineEdit";
          rv = static_cast<QLineEdit*>(wdt)->text();         
       }
       else if ( wdt->inherits("QTextEdit")  ) 
       {
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << "field " << field_name << " is a QTextEdit";
+         qcjDebug(LOG, 1) << __FUNCTION__ << "field " << field_name << " is a QTextEdit";
          rv = static_cast<QTextEdit*>(wdt)->toPlainText();         
       }
       else if ( wdt->inherits("QDoubleSpinBox")  ) 
       {
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << "field " << field_name << " is a QDoubleSpinBox";
+         qcjDebug(LOG, 1) << __FUNCTION__ << "field " << field_name << " is a QDoubleSpinBox";
          rv = static_cast<QDoubleSpinBox*>(wdt)->cleanText();         
       }
       else if ( wdt->inherits("QSpinBox")  ) 
       {
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << "field " << field_name << " is a QSpinBox";
+         qcjDebug(LOG, 1) << __FUNCTION__ << "field " << field_name << " is a QSpinBox";
          rv = static_cast<QSpinBox*>(wdt)->cleanText();         
       }
       else if ( wdt->inherits("QComboBox")  ) 
       {
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << "field " << field_name << " is a QComboBox";
+         qcjDebug(LOG, 1) << __FUNCTION__ << "field " << field_name << " is a QComboBox";
          rv = static_cast<QComboBox*>(wdt)->itemData(static_cast<QComboBox*>(wdt)->currentIndex()).toString();         
       }
    }
@@ -339,7 +338,7 @@ QSqlQuery SqlDbForm::BuildUpdateQuery(QString where)
    {
       if ( ! field.endsWith("_id") && ! field.startsWith("sys_") ) 
       {
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << "adding field: " << field;
+         qcjDebug(LOG, 1) << __FUNCTION__ << "adding field: " << field;
          if ( ! field_list.isEmpty() ) 
          {
             field_list += ", ";
@@ -348,10 +347,16 @@ QSqlQuery SqlDbForm::BuildUpdateQuery(QString where)
       }
    }
    sql += field_list + " " + where;
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << "sql = " << sql;
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << "sql = " << sql;
+   qcjDebug(LOG, 1) << __FUNCTION__ << "sql = " << sql;
+   qcjDebug(LOG, 1) << __FUNCTION__ << "sql = " << sql;
    rv.prepare(sql);
 
+   /***********************************************/
+   /*   The caller runs the update, the cached    */
+   /*   results of the table are dropped now.     */
+   /***********************************************/
+   QueryCache::instance()->Invalidate(m_table);
+
    foreach(QString field, m_rawFieldNames)
    {
       if ( ! field.startsWith("sys_") ) 
@@ -364,7 +369,7 @@ QSqlQuery SqlDbForm::BuildUpdateQuery(QString where)
             bind_name = "id";
          }
          bind_name = ":" + bind_name;
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << "binding value: " << value << " to " << bind_name;
+         qcjDebug(LOG, 1) << __FUNCTION__ << "binding value: " << value << " to " << bind_name;
          rv.bindValue(bind_name, value);
       }
    }
@@ -385,7 +390,7 @@ QSqlQuery SqlDbForm::BuildInsertQuery()
    {
       if ( ! field.endsWith("_id") ) 
       {
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << "adding field: " << field;
+         qcjDebug(LOG, 1) << __FUNCTION__ << "adding field: " << field;
          if ( ! field_list.isEmpty() ) 
          {
             field_list += ", ";
@@ -403,7 +408,7 @@ QSqlQuery SqlDbForm::BuildInsertQuery()
    {
       if ( ! field.endsWith("_id") ) 
       {
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << "adding field: " << field;
+         qcjDebug(LOG, 1) << __FUNCTION__ << "adding field: " << field;
          if ( ! field_list.isEmpty() ) 
          {
             field_list += ", ";
@@ -419,9 +424,10 @@ QSqlQuery SqlDbForm::BuildInsertQuery()
    }
    
    sql += field_list + ") values (" + value_list + ")";
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << "sql = " << sql;
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << "sql = " << sql;
+   qcjDebug(LOG, 1) << __FUNCTION__ << "sql = " << sql;
+   qcjDebug(LOG, 1) << __FUNCTION__ << "sql = " << sql;
    rv.prepare(sql);
+   QueryCache::instance()->Invalidate(m_table);
 
    foreach(QString field, m_rawFieldNames)
    {
@@ -433,7 +439,7 @@ QSqlQuery SqlDbForm::BuildInsertQuery()
          bind_name = "id";
       }
       bind_name = ":" + bind_name;
-      qDebug(*log(LOG, 1)) << __FUNCTION__ << "binding value: " << value << " to " << bind_name;
+      qcjDebug(LOG, 1) << __FUNCTION__ << "binding value: " << value << " to " << bind_name;
       rv.bindValue(bind_name, value);
    }
    foreach(QString field, m_addedFields.keys())
@@ -441,7 +447,7 @@ QSqlQuery SqlDbForm::BuildInsertQuery()
       QVariant value;
       value = m_addedFields.value(field);
       bind_name = ":" + field;
-      qDebug(*log(LOG, 1)) << __FUNCTION__ << "binding value: " << value << " to " << bind_name;
+      qcjDebug(LOG, 1) << __FUNCTION__ << "binding value: " << value << " to " << bind_name;
       rv.bindValue(bind_name, value);
    }
    return(rv);
@@ -463,5 +469,9 @@ bool SqlDbForm::InsertNew(bool throwErrors)
          throw(m_lastError);
       }
    }
+   else 
+   {
+      QueryCache::instance()->Invalidate(m_table);
+   }
    return(rv);
 }
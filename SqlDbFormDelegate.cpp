@@ -47,7 +47,7 @@ void SqlDbFormDelegate::setEditorData(QWidget *editor, const QModelIndex &index)
       QString name = comboBox->property("sql_field_name").toString();
       int value = index.model()->data(index, Qt::EditRole).toInt();
       int offset = comboBox->findData(value);
-      qDebug(*log(LOG, 1)) << __FUNCTION__ << "field name: " << name << ", value = " << value << ", offset = " << offset;
+      qcjDebug(LOG, 1) << __FUNCTION__ << "field name: " << name << ", value = " << value << ", offset = " << offset;
       comboBox->setCurrentIndex(offset);
    }
    else 
@@ -65,7 +65,7 @@ void SqlDbFormDelegate::setModelData(QWidget *editor, QAbstractItemModel *model,
       QString name = comboBox->property("sql_field_name").toString();
       int offset = comboBox->currentIndex();
       QVariant value = comboBox->itemData(offset);
-      qDebug(*log(LOG, 1)) << __FUNCTION__ << "field name: " << name << "index = " << index << ", value = " << value << ", value(int) " << value.toInt() << ", offset = " << offset;
+      qcjDebug(LOG, 1) << __FUNCTION__ << "field name: " << name << "index = " << index << ", value = " << value << ", value(int) " << value.toInt() << ", offset = " << offset;
       model->setData(index, value, Qt::EditRole);
    }
    else 
@@ -0,0 +1,270 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#include "SqlFilter.h"
+
+#include <QSqlField>
+
+using namespace QcjLib;
+
+SqlFilter::SqlFilter()
+{
+}
+
+SqlFilter::SqlFilter(Node *node) :
+   m_node(node)
+{
+}
+
+SqlFilter SqlFilter::Compare(QString column, Operator op, const QVariant &value)
+{
+   Node *node = new Node();
+   node->type = NodeCompare;
+   node->op = op;
+   node->column = column;
+   node->values.append(value);
+   return(SqlFilter(node));
+}
+
+/********************************************************************//*
+**   static SqlFilter SqlFilter::In(QString column, const QVariantList &values)
+**   
+**   Matches  rows  where  column  equals one of values. There is a
+**   placeholder  per  value,  so  lists  of  different length are
+**   different shapes. An empty list matches nothing.
+***********************************************************************/
+SqlFilter SqlFilter::In(QString column, const QVariantList &values)
+{
+   Node *node = new Node();
+   node->type = NodeIn;
+   node->op = Equal;
+   node->column = column;
+   node->values = values;
+   return(SqlFilter(node));
+}
+
+SqlFilter SqlFilter::IsNull(QString column)
+{
+   Node *node = new Node();
+   node->type = NodeIsNull;
+   node->op = Equal;
+   node->column = column;
+   return(SqlFilter(node));
+}
+
+SqlFilter SqlFilter::IsNotNull(QString column)
+{
+   Node *node = new Node();
+   node->type = NodeIsNotNull;
+   node->op = Equal;
+   node->column = column;
+   return(SqlFilter(node));
+}
+
+SqlFilter SqlFilter::And(const SqlFilter &other) const
+{
+   return(Combine(NodeAnd, other));
+}
+
+SqlFilter SqlFilter::Or(const SqlFilter &other) const
+{
+   return(Combine(NodeOr, other));
+}
+
+/********************************************************************//*
+**   SqlFilter SqlFilter::Combine(NodeType type, const SqlFilter &other) const private
+**   
+**   Joins  two  filters.  An  empty  filter  is  left  out and runs of
+**   the  same  operator  are  flattened, so a && b && c comes out as
+**   one group however it was put together.
+***********************************************************************/
+SqlFilter SqlFilter::Combine(NodeType type, const SqlFilter &other) const
+{
+   if ( other.isEmpty() ) 
+   {
+      return(*this);
+   }
+   if ( isEmpty() ) 
+   {
+      return(other);
+   }
+
+   Node *node = new Node();
+   node->type = type;
+   node->op = Equal;
+
+   const SqlFilter *operands[2] = { this, &other };
+   for (int x = 0; x < 2; x++) 
+   {
+      if ( operands[x]->m_node->type == type ) 
+      {
+         node->children += operands[x]->m_node->children;
+      }
+      else 
+      {
+         node->children.append(*operands[x]);
+      }
+   }
+   return(SqlFilter(node));
+}
+
+QString SqlFilter::Sql() const
+{
+   QString rv;
+   if ( ! isEmpty() ) 
+   {
+      Build(rv, NULL, NULL, false);
+   }
+   return(rv);
+}
+
+QVariantList SqlFilter::Values() const
+{
+   QVariantList rv;
+   QString sql;
+   if ( ! isEmpty() ) 
+   {
+      Build(sql, &rv, NULL, false);
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   QString SqlFilter::InlineSql(const QSqlDriver *driver) const
+**   
+**   Returns  the  clause  with  the  values  written  into it as
+**   literals,  escaped  by  driver.  Only for interfaces that take a
+**   plain  where  string,  each  set  of values is a new statement
+**   to the server.
+***********************************************************************/
+QString SqlFilter::InlineSql(const QSqlDriver *driver) const
+{
+   QString rv;
+   if ( ! isEmpty() ) 
+   {
+      Build(rv, NULL, driver, false);
+   }
+   return(rv);
+}
+
+QString SqlFilter::OperatorText(Operator op)
+{
+   QString rv;
+
+   switch (op)
+   {
+      case Equal:          rv = "=";         break;
+      case NotEqual:       rv = "<>";        break;
+      case Less:           rv = "<";         break;
+      case LessEqual:      rv = "<=";        break;
+      case Greater:        rv = ">";         break;
+      case GreaterEqual:   rv = ">=";        break;
+      case Like:           rv = "like";      break;
+      case NotLike:        rv = "not like";  break;
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   void  SqlFilter::Build(QString &sql, QVariantList *values, 
+**                          const QSqlDriver *driver, bool nested) const private
+**   
+**   Appends  the  clause  to  sql. Values are appended to values if
+**   it  is not NULL. With a driver the values are written as literals
+**   rather than placeholders.
+***********************************************************************/
+void SqlFilter::Build(QString &sql, QVariantList *values, const QSqlDriver *driver, bool nested) const
+{
+   const Node *node = m_node.data();
+
+   switch (node->type)
+   {
+      case NodeCompare:
+         sql += Quote(node->column) + " " + OperatorText(node->op) + " ";
+         sql += (driver != NULL) ? Literal(node->values.first(), driver) : QString("?");
+         break;
+
+      case NodeIn:
+         if ( node->values.isEmpty() ) 
+         {
+            sql += "1 = 0";
+            break;
+         }
+         sql += Quote(node->column) + " in (";
+         for (int x = 0; x < node->values.count(); x++) 
+         {
+            sql += (x > 0) ? ", " : "";
+            sql += (driver != NULL) ? Literal(node->values.at(x), driver) : QString("?");
+         }
+         sql += ")";
+         break;
+
+      case NodeIsNull:
+         sql += Quote(node->column) + " is null";
+         break;
+
+      case NodeIsNotNull:
+         sql += Quote(node->column) + " is not null";
+         break;
+
+      case NodeAnd:
+      case NodeOr:
+         sql += nested ? "(" : "";
+         for (int x = 0; x < node->children.count(); x++) 
+         {
+            sql += (x > 0) ? ((node->type == NodeAnd) ? " and " : " or ") : "";
+            node->children.at(x).Build(sql, values, driver, true);
+         }
+         sql += nested ? ")" : "";
+         break;
+   }
+
+   if ( values != NULL && (node->type == NodeCompare || node->type == NodeIn) ) 
+   {
+      *values += node->values;
+   }
+}
+
+QString SqlFilter::Quote(const QString &column)
+{
+   QString rv = column;
+   return("\"" + rv.replace("\"", "\"\"") + "\"");
+}
+
+/********************************************************************//*
+**   static  QString  SqlFilter::Literal(const  QVariant  &value, 
+**                                       const QSqlDriver *driver)
+**   
+**   Returns  value  written  as  an  SQL  literal  by  driver, for
+**   statements that can not be prepared.
+***********************************************************************/
+QString SqlFilter::Literal(const QVariant &value, const QSqlDriver *driver)
+{
+   QSqlField field(QString(), value.type());
+   field.setValue(value);
+   return(driver->formatValue(field));
+}
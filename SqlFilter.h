@@ -0,0 +1,134 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef SQLFILTER_H
+#define SQLFILTER_H
+
+#include <QSharedPointer>
+#include <QSqlDriver>
+#include <QString>
+#include <QVariant>
+#include <QVariantList>
+#include <QVector>
+
+namespace QcjLib
+{
+   /********************************************************************//*
+   **   class SqlFilter
+   **   
+   **   Builds  a  where  clause  out  of  column comparisons joined by
+   **   and  and  or.  Sql()  returns the clause with a ? placeholder
+   **   for  every  value,  in  a  canonical  form, and Values() the
+   **   values  to  bind  in  order.  Filters  of  the  same  shape  thus
+   **   produce  the  same  SQL  text whatever their values, so the
+   **   statement is prepared and planned once.
+   **
+   **      SqlFilter filter = SqlFilter::Compare("status", SqlFilter::Equal, "open") &&
+   **                         (SqlFilter::Compare("amount", SqlFilter::Greater, 100) ||
+   **                          SqlFilter::IsNull("due"));
+   **      model->SetFilter(filter);
+   **
+   **   Filters are values, combining them never changes the operands.
+   ***********************************************************************/
+   class SqlFilter
+   {
+   public:
+      enum Operator
+      {
+         Equal,
+         NotEqual,
+         Less,
+         LessEqual,
+         Greater,
+         GreaterEqual,
+         Like,
+         NotLike
+      };
+
+      SqlFilter();
+
+      static SqlFilter Compare(QString column, Operator op, const QVariant &value);
+      static SqlFilter In(QString column, const QVariantList &values);
+      static SqlFilter IsNull(QString column);
+      static SqlFilter IsNotNull(QString column);
+
+      SqlFilter And(const SqlFilter &other) const;
+      SqlFilter Or(const SqlFilter &other) const;
+
+      SqlFilter operator&&(const SqlFilter &other) const
+      {
+         return(And(other));
+      }
+
+      SqlFilter operator||(const SqlFilter &other) const
+      {
+         return(Or(other));
+      }
+
+      bool isEmpty() const
+      {
+         return(m_node.isNull());
+      }
+
+      QString Sql() const;
+      QVariantList Values() const;
+      QString InlineSql(const QSqlDriver *driver) const;
+
+      static QString OperatorText(Operator op);
+      static QString Literal(const QVariant &value, const QSqlDriver *driver);
+
+   private:
+      enum NodeType
+      {
+         NodeCompare,
+         NodeIn,
+         NodeIsNull,
+         NodeIsNotNull,
+         NodeAnd,
+         NodeOr
+      };
+
+      struct Node
+      {
+         NodeType             type;
+         Operator             op;
+         QString              column;
+         QVariantList         values;
+         QVector<SqlFilter>   children;
+      };
+
+      SqlFilter(Node *node);
+      SqlFilter Combine(NodeType type, const SqlFilter &other) const;
+      void Build(QString &sql, QVariantList *values, const QSqlDriver *driver, bool nested) const;
+
+      static QString Quote(const QString &column);
+
+      QSharedPointer<const Node>  m_node;
+   };
+}
+
+#endif
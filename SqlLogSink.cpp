@@ -0,0 +1,305 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+# include "SqlLogSink.h"
+# include "Logger.h"
+
+# include <QDateTime>
+# include <QElapsedTimer>
+# include <QSqlError>
+# include <QVariant>
+
+using namespace QcjLib;
+
+const int     SqlLogSink::BATCH_SIZE            = 1000;
+const int     SqlLogSink::BATCH_INTERVAL_MS     = 250;
+const int     SqlLogSink::MAX_PENDING           = 100000;
+const int     SqlLogSink::RETENTION_CHUNK       = 5000;
+const int     SqlLogSink::RETENTION_INTERVAL_MS = 60000;
+const QString SqlLogSink::CONNECTION_NAME       ("QcjLib_log_sink");
+const QString SqlLogSink::TABLE_NAME            ("log");
+
+SqlLogSink::SqlLogSink(QString filename, int retention_days, QObject *parent) :
+   QThread(parent),
+   m_fileName(filename),
+   m_connectionName(CONNECTION_NAME + "_" + QString::number((quintptr)this, 16)),
+   m_retentionDays(retention_days),
+   m_stop(false),
+   m_dropped(0)
+{
+   m_pending.reserve(BATCH_SIZE);
+}
+
+SqlLogSink::~SqlLogSink()
+{
+   Stop();
+}
+
+/********************************************************************//*
+**   void SqlLogSink::Append(const LogRecord &rec)
+**   
+**   Adds  a  copy  of  rec  to  the  pending  batch. If the database
+**   can  not  keep  up  and  MAX_PENDING  records are waiting, the
+**   record is dropped and counted instead.
+**   
+**   Returns N/A
+***********************************************************************/
+void SqlLogSink::Append(const LogRecord &rec)
+{
+   QMutexLocker lock(&m_pendingLock);
+
+   if ( m_pending.size() >= MAX_PENDING ) 
+   {
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+   }
+
+   m_pending.append(rec);
+   if ( m_pending.size() >= BATCH_SIZE ) 
+   {
+      m_pendingCondition.wakeOne();
+   }
+}
+
+/********************************************************************//*
+**   void SqlLogSink::Stop()
+**   
+**   Writes  out  the  pending  batch  and  waits  for  the  sink's
+**   thread to finish.
+**   
+**   Returns N/A
+***********************************************************************/
+void SqlLogSink::Stop()
+{
+   {
+      QMutexLocker lock(&m_pendingLock);
+      m_stop = true;
+      m_pendingCondition.wakeOne();
+   }
+   wait();
+}
+
+/********************************************************************//*
+**   static bool SqlLogSink::CreateSchema(QSqlDatabase &db)
+**   
+**   Creates  the  log  table  and the indexes used by the queries of
+**   LogQueryWidget  if  they  do  not exist yet, and switches the
+**   database to WAL mode.
+**   
+**   Returns true if all statements succeeded.
+***********************************************************************/
+bool SqlLogSink::CreateSchema(QSqlDatabase &db)
+{
+   bool rv = true;
+   QSqlQuery q1(db);
+
+   QStringList statements;
+   statements << "pragma journal_mode = wal"
+              << "pragma synchronous = normal"
+              << "create table if not exists " + TABLE_NAME + " ("
+                 "id integer primary key, "
+                 "timestamp integer not null, "
+                 "thread integer, "
+                 "category text, "
+                 "level integer, "
+                 "type integer, "
+                 "function text, "
+                 "message text)"
+              << "create index if not exists " + TABLE_NAME + "_time_idx on " + TABLE_NAME + " (timestamp)"
+              << "create index if not exists " + TABLE_NAME + "_category_idx on " + TABLE_NAME + " (category, timestamp)"
+              << "create index if not exists " + TABLE_NAME + "_level_idx on " + TABLE_NAME + " (level, timestamp)";
+
+   foreach (QString statement, statements)
+   {
+      if ( ! q1.exec(statement) ) 
+      {
+         qWarning() << __FUNCTION__ << "Error:" << q1.lastError().text() << "in" << statement;
+         rv = false;
+      }
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   static bool SqlLogSink::InitializeDatabase(QString filename)
+**   
+**   Creates  the  database and its schema from the calling thread,
+**   so  a  bad  filename  is reported to the caller rather than by
+**   the sink's thread.
+**   
+**   Returns true if the database could be opened and set up.
+***********************************************************************/
+bool SqlLogSink::InitializeDatabase(QString filename)
+{
+   bool rv = false;
+   QString connection = CONNECTION_NAME + "_setup";
+   {
+      QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connection);
+      db.setDatabaseName(filename);
+      if ( db.open() ) 
+      {
+         rv = CreateSchema(db);
+         db.close();
+      }
+   }
+   QSqlDatabase::removeDatabase(connection);
+   return(rv);
+}
+
+/********************************************************************//*
+**   void SqlLogSink::run() protected
+**   
+**   The  sink's  thread.  Owns its own database connection, takes
+**   the  pending  records  whenever  BATCH_SIZE  of them are waiting
+**   or BATCH_INTERVAL_MS has passed and inserts them.
+***********************************************************************/
+void SqlLogSink::run()
+{
+   {
+      QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
+      db.setDatabaseName(m_fileName);
+      if ( ! db.open() || ! CreateSchema(db) ) 
+      {
+         qWarning() << __FUNCTION__ << "Could not open log database" << m_fileName << db.lastError().text();
+         db.close();
+      }
+      else 
+      {
+         QSqlQuery insert(db);
+         insert.prepare("insert into " + TABLE_NAME + " (timestamp, thread, category, level, type, function, message) "
+                        "values (?, ?, ?, ?, ?, ?, ?)");
+
+         QVector<LogRecord> batch;
+         QElapsedTimer retention_timer;
+         bool stop = false;
+
+         batch.reserve(BATCH_SIZE);
+         retention_timer.start();
+         EnforceRetention(db);
+         while ( ! stop ) 
+         {
+            {
+               QMutexLocker lock(&m_pendingLock);
+               if ( ! m_stop && m_pending.size() < BATCH_SIZE ) 
+               {
+                  m_pendingCondition.wait(&m_pendingLock, BATCH_INTERVAL_MS);
+               }
+               stop = m_stop;
+               batch.swap(m_pending);
+            }
+
+            if ( ! batch.isEmpty() ) 
+            {
+               InsertBatch(db, insert, batch);
+               batch.resize(0);
+            }
+
+            if ( retention_timer.elapsed() >= RETENTION_INTERVAL_MS ) 
+            {
+               EnforceRetention(db);
+               retention_timer.restart();
+            }
+         }
+         insert.finish();
+         db.close();
+      }
+   }
+   QSqlDatabase::removeDatabase(m_connectionName);
+}
+
+/********************************************************************//*
+**   void  SqlLogSink::InsertBatch(QSqlDatabase &db, QSqlQuery &insert, 
+**                                 const QVector<LogRecord> &batch) private
+**   
+**   Inserts  a  batch  of records in a single transaction. Records
+**   that  were  not  formatted  by the Logger are formatted here, on
+**   the sink's thread.
+***********************************************************************/
+void SqlLogSink::InsertBatch(QSqlDatabase &db, QSqlQuery &insert, const QVector<LogRecord> &batch)
+{
+   QString message;
+
+   db.transaction();
+   foreach (const LogRecord &rec, batch)
+   {
+      if ( rec.isFormatted() ) 
+      {
+         message = rec.text;
+      }
+      else if ( rec.isStructured() ) 
+      {
+         message.resize(0);
+         Logger::FormatMessage(rec, message);
+      }
+      else 
+      {
+         message = rec.message;
+      }
+
+      insert.bindValue(0, rec.timestamp);
+      insert.bindValue(1, rec.threadId);
+      insert.bindValue(2, rec.category);
+      insert.bindValue(3, rec.level);
+      insert.bindValue(4, (int)rec.type);
+      insert.bindValue(5, rec.function.isEmpty() ? QString() : QString::fromUtf8(rec.function));
+      insert.bindValue(6, message);
+      if ( ! insert.exec() ) 
+      {
+         m_dropped.fetch_add(1, std::memory_order_relaxed);
+      }
+   }
+   db.commit();
+}
+
+/********************************************************************//*
+**   void SqlLogSink::EnforceRetention(QSqlDatabase &db) private
+**   
+**   Deletes  records  older  than  the  retention period, at most
+**   RETENTION_CHUNK per transaction.
+***********************************************************************/
+void SqlLogSink::EnforceRetention(QSqlDatabase &db)
+{
+   if ( m_retentionDays <= 0 ) 
+   {
+      return;
+   }
+
+   qint64 cutoff = QDateTime::currentMSecsSinceEpoch() - (qint64)m_retentionDays * 24 * 3600 * 1000;
+   QSqlQuery q1(db);
+   q1.prepare("delete from " + TABLE_NAME + " where id in "
+              "(select id from " + TABLE_NAME + " where timestamp < ? order by timestamp limit ?)");
+
+   int deleted;
+   do
+   {
+      q1.bindValue(0, cutoff);
+      q1.bindValue(1, RETENTION_CHUNK);
+      db.transaction();
+      deleted = q1.exec() ? q1.numRowsAffected() : 0;
+      db.commit();
+   } while ( deleted >= RETENTION_CHUNK );
+}
@@ -0,0 +1,113 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef SQLLOGSINK_H
+#define SQLLOGSINK_H
+
+# include <QMutex>
+# include <QSqlDatabase>
+# include <QSqlQuery>
+# include <QString>
+# include <QThread>
+# include <QVector>
+# include <QWaitCondition>
+
+# include "LogRecord.h"
+
+#include <atomic>
+
+namespace QcjLib
+{
+   /********************************************************************//*
+   **   class SqlLogSink
+   **   
+   **   Writes  log  records  to  a  table  in  a  local SQLite database
+   **   so  they  can  be  searched  with  SQL, see LogQueryWidget. The
+   **   Logger  only  appends  records  to  a  pending batch, a thread
+   **   of  the  sink  inserts  each  batch  with  a  prepared statement
+   **   inside  one  transaction.  The  database  runs  in  WAL mode so
+   **   it can be queried while it is being written.
+   **
+   **   Records  older  than the retention period are deleted a chunk
+   **   at  a  time,  each  in  its  own transaction, so the writer and
+   **   readers are never held up for long.
+   **
+   **   Each  sink's  connection  is  named  after  CONNECTION_NAME and
+   **   the  sink's  address,  so  a sink that is still shutting down
+   **   never shares its connection with the next one.
+   ***********************************************************************/
+   class SqlLogSink : public QThread
+   {
+      Q_OBJECT
+
+   public:
+      SqlLogSink(QString filename, int retention_days = 0, QObject *parent = NULL);
+      ~SqlLogSink();
+
+      void     Append(const LogRecord &rec);
+      void     Stop();
+
+      QString FileName() const
+      {
+         return(m_fileName);
+      }
+
+      quint64 DroppedCount() const
+      {
+         return(m_dropped.load(std::memory_order_relaxed));
+      }
+
+      static bool CreateSchema(QSqlDatabase &db);
+      static bool InitializeDatabase(QString filename);
+
+      static const int     BATCH_SIZE;
+      static const int     BATCH_INTERVAL_MS;
+      static const int     MAX_PENDING;
+      static const int     RETENTION_CHUNK;
+      static const int     RETENTION_INTERVAL_MS;
+      static const QString CONNECTION_NAME;
+      static const QString TABLE_NAME;
+
+   protected:
+      void run();
+
+   private:
+      void InsertBatch(QSqlDatabase &db, QSqlQuery &insert, const QVector<LogRecord> &batch);
+      void EnforceRetention(QSqlDatabase &db);
+
+      QString                    m_fileName;
+      QString                    m_connectionName;
+      int                        m_retentionDays;
+      QVector<LogRecord>         m_pending;
+      QMutex                     m_pendingLock;
+      QWaitCondition             m_pendingCondition;
+      bool                       m_stop;
+      std::atomic<quint64>       m_dropped;
+   };
+};
+
+#endif
@@ -0,0 +1,651 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#include "SqlPagedTableModel.h"
+
+#include <QDebug>
+#include <QRegularExpression>
+#include <QSqlError>
+#include <QSqlField>
+
+#include <algorithm>
+
+#define  ASCENDING   "asc"
+#define  DESCENDING  "desc"
+
+using namespace QcjLib;
+
+const QString SqlPagedTableModel::LOG("QcjLib_paged_table_model");
+static LogBuilder mylog(SqlPagedTableModel::LOG, 1, "QcjLib Paged Table Model");
+
+const int SqlPagedTableModel::PAGE_SIZE = 256;
+const int SqlPagedTableModel::MAX_PAGES = 64;
+
+SqlPagedTableModel::SqlPagedTableModel(QObject *parent) :
+   QAbstractTableModel(parent),
+   m_rowCount(0),
+   m_rowCountExact(true),
+   m_pages(MAX_PAGES)
+{
+}
+
+/********************************************************************//*
+**   void SqlPagedTableModel::SetKeyColumn(QString field_name)
+**   
+**   Names  a  result  column,  normally  the primary key, that is
+**   unique  within  the  result.  It  is added as the last sort key
+**   so  the  order  is  total,  which  keyset  pagination needs. An
+**   empty name turns keyset pagination off.
+***********************************************************************/
+void SqlPagedTableModel::SetKeyColumn(QString field_name)
+{
+   m_keyColumn = field_name;
+}
+
+/********************************************************************//*
+**   void  SqlPagedTableModel::SetFilter(QString  where, const QVariantList &values)
+**   
+**   Sets  the  where  clause  used  by the next select(), with the
+**   values for its ? placeholders.
+***********************************************************************/
+void SqlPagedTableModel::SetFilter(QString where, const QVariantList &values)
+{
+   m_queryFilter = where;
+   m_filterValues = values;
+}
+
+void SqlPagedTableModel::SetFilter(const SqlFilter &filter)
+{
+   SetFilter(filter.Sql(), filter.Values());
+}
+
+Qt::SortOrder SqlPagedTableModel::SetOrder(QString field_name)
+{
+   return(SqlSortableTableModel::UpdateOrder(m_queryOrder, field_name));
+}
+
+Qt::SortOrder SqlPagedTableModel::SetOrder(int column)
+{
+   Qt::SortOrder rv = Qt::AscendingOrder;
+   QString field_name = m_record.fieldName(column);
+   qcjDebug(LOG, 1) << __FUNCTION__ << "found field " << field_name << " in column " << column;
+   if ( ! field_name.isEmpty() ) 
+   {
+      rv = SetOrder(field_name);
+   }
+   return(rv);
+}
+
+void SqlPagedTableModel::ClearOrder()
+{
+   m_queryOrder.clear();
+}
+
+void SqlPagedTableModel::SetQuery(QString query, QSqlDatabase database)
+{
+   m_db = database;
+   m_queryBase = query;
+   m_queryFilter.clear();
+   m_filterValues.clear();
+   m_queryOrder.clear();
+   select();
+}
+
+/********************************************************************//*
+**   void SqlPagedTableModel::select()
+**   
+**   Drops  all  cached  pages,  fetches  the  first  page for the
+**   current filter and order and estimates the number of rows.
+***********************************************************************/
+void SqlPagedTableModel::select()
+{
+   InitMetrics();
+   beginResetModel();
+   m_pages.clear();
+   m_bounds.clear();
+   m_keyIndexes.clear();
+   m_record = QSqlRecord();
+
+   Page_t *first = new Page_t();
+   if ( FetchPage(0, *first, &m_record) ) 
+   {
+      /************************************************************/
+      /*   Keyset  pagination  needs  every  key  column  in  the   */
+      /*   result.                                                  */
+      /************************************************************/
+      foreach (const FieldDescr_t &fd, KeyOrder())
+      {
+         int index = m_record.indexOf(fd.first);
+         if ( index < 0 ) 
+         {
+            m_keyIndexes.clear();
+            break;
+         }
+         m_keyIndexes.append(index);
+      }
+
+      if ( first->count() < PAGE_SIZE ) 
+      {
+         m_rowCount = first->count();
+         m_rowCountExact = true;
+      }
+      else 
+      {
+         m_rowCount = qMax(EstimateRows(m_rowCountExact), (int)first->count());
+      }
+
+      if ( ! m_keyIndexes.isEmpty() && ! first->isEmpty() ) 
+      {
+         PageBounds bounds;
+         bounds.first = RowKey(first->first());
+         bounds.last = RowKey(first->last());
+         m_bounds.insert(0, bounds);
+      }
+      m_pages.insert(0, first);
+   }
+   else 
+   {
+      delete first;
+      m_rowCount = 0;
+      m_rowCountExact = true;
+   }
+   endResetModel();
+   qcjDebug(LOG, 1) << __FUNCTION__ << "rows = " << m_rowCount << ", exact = " << m_rowCountExact << ", keyset = " << ! m_keyIndexes.isEmpty();
+}
+
+int SqlPagedTableModel::rowCount(const QModelIndex &parent) const
+{
+   return(parent.isValid() ? 0 : m_rowCount);
+}
+
+int SqlPagedTableModel::columnCount(const QModelIndex &parent) const
+{
+   return(parent.isValid() ? 0 : m_record.count());
+}
+
+/********************************************************************//*
+**   QVariant SqlPagedTableModel::data(const QModelIndex &index, int role) const
+**   
+**   Returns  the  value  of  a  cell,  fetching the page holding it
+**   if it is not cached. Views only ask for the rows they show, so
+**   only those pages are fetched.
+***********************************************************************/
+QVariant SqlPagedTableModel::data(const QModelIndex &index, int role) const
+{
+   QVariant rv;
+
+   if ( index.isValid() && (role == Qt::DisplayRole || role == Qt::EditRole) ) 
+   {
+      const Page_t *page = Page(index.row() / PAGE_SIZE);
+      int row = index.row() % PAGE_SIZE;
+      if ( page != NULL && row < page->count() && index.column() < page->at(row).count() ) 
+      {
+         rv = page->at(row).at(index.column());
+      }
+   }
+   return(rv);
+}
+
+QVariant SqlPagedTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+   QVariant rv;
+
+   if ( role == Qt::DisplayRole ) 
+   {
+      if ( orientation == Qt::Horizontal ) 
+      {
+         rv = m_record.fieldName(section);
+      }
+      else 
+      {
+         rv = section + 1;
+      }
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   bool SqlPagedTableModel::canFetchMore(const QModelIndex &parent) const
+**   
+**   With  only  an  estimate  of  the  row count there may be rows
+**   past the end, fetchMore() looks for them.
+***********************************************************************/
+bool SqlPagedTableModel::canFetchMore(const QModelIndex &parent) const
+{
+   return(! parent.isValid() && ! m_rowCountExact);
+}
+
+void SqlPagedTableModel::fetchMore(const QModelIndex &parent)
+{
+   if ( ! canFetchMore(parent) ) 
+   {
+      return;
+   }
+
+   int page_no = m_rowCount / PAGE_SIZE;
+   const Page_t *page = Page(page_no);
+   int rows = page_no * PAGE_SIZE + (page != NULL ? page->count() : 0);
+   if ( page == NULL || page->count() < PAGE_SIZE ) 
+   {
+      m_rowCountExact = true;
+   }
+   if ( rows > m_rowCount ) 
+   {
+      beginInsertRows(QModelIndex(), m_rowCount, rows - 1);
+      m_rowCount = rows;
+      endInsertRows();
+   }
+}
+
+/********************************************************************//*
+**   void SqlPagedTableModel::SlotSetRowCount(int rows) protected slot
+**   
+**   Corrects  the  estimated  row count once a short page shows
+**   where the result really ends.
+***********************************************************************/
+void SqlPagedTableModel::SlotSetRowCount(int rows)
+{
+   m_rowCountExact = true;
+   if ( rows > m_rowCount ) 
+   {
+      beginInsertRows(QModelIndex(), m_rowCount, rows - 1);
+      m_rowCount = rows;
+      endInsertRows();
+   }
+   else if ( rows < m_rowCount ) 
+   {
+      beginRemoveRows(QModelIndex(), rows, m_rowCount - 1);
+      m_rowCount = rows;
+      endRemoveRows();
+   }
+}
+
+/********************************************************************//*
+**   const Page_t *SqlPagedTableModel::Page(int page) const protected
+**   
+**   Returns  the  rows  of  page,  from  the  cache  or  fetched  from
+**   the  database,  or NULL if the query failed. The pointer is only
+**   good until the next page is fetched.
+***********************************************************************/
+const SqlPagedTableModel::Page_t *SqlPagedTableModel::Page(int page) const
+{
+   Page_t *rv = m_pages.object(page);
+   if ( rv == NULL ) 
+   {
+      rv = new Page_t();
+      if ( ! FetchPage(page, *rv) ) 
+      {
+         delete rv;
+         return(NULL);
+      }
+
+      if ( ! m_keyIndexes.isEmpty() && ! rv->isEmpty() ) 
+      {
+         PageBounds bounds;
+         bounds.first = RowKey(rv->first());
+         bounds.last = RowKey(rv->last());
+         m_bounds.insert(page, bounds);
+      }
+
+      /************************************************************/
+      /*   A  short  page  is  the  end  of  the  result. The row   */
+      /*   count  can  not  change while a view is asking for data  */
+      /*   so that is left for the event loop.                      */
+      /************************************************************/
+      int rows = page * PAGE_SIZE + rv->count();
+      if ( rv->count() < PAGE_SIZE && rows != m_rowCount ) 
+      {
+         QMetaObject::invokeMethod(const_cast<SqlPagedTableModel*>(this), "SlotSetRowCount", 
+                                   Qt::QueuedConnection, Q_ARG(int, rows));
+      }
+      m_pages.insert(page, rv);
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   bool  SqlPagedTableModel::FetchPage(int  page,  Page_t  &rows, 
+**                                       QSqlRecord *record) const protected
+**   
+**   Reads  one  page  from the database. If a neighbouring page has
+**   been  fetched  the  page  is  found  by  keyset  from  that page's
+**   last  or  first  key, reading backwards in the latter case, and
+**   otherwise by offset.
+**   
+**   Returns true if the query succeeded. The result's record is put
+**   in record if that is not NULL.
+***********************************************************************/
+bool SqlPagedTableModel::FetchPage(int page, Page_t &rows, QSqlRecord *record) const
+{
+   QString sql = "select * from (" + FilteredQuery() + ") qcj_page";
+   QVariantList values = m_filterValues;
+   QList<FieldDescr_t> order = m_keyIndexes.isEmpty() ? m_queryOrder : KeyOrder();
+   QString condition;
+   bool reverse = false;
+
+   if ( ! m_keyIndexes.isEmpty() && page > 0 && m_bounds.contains(page - 1) ) 
+   {
+      condition = KeysetCondition(m_bounds.value(page - 1).last, true, values);
+   }
+   else if ( ! m_keyIndexes.isEmpty() && m_bounds.contains(page + 1) ) 
+   {
+      condition = KeysetCondition(m_bounds.value(page + 1).first, false, values);
+      reverse = ! condition.isEmpty();
+   }
+
+   if ( reverse ) 
+   {
+      for (int x = 0; x < order.count(); x++) 
+      {
+         order[x].second = (order[x].second == ASCENDING) ? DESCENDING : ASCENDING;
+      }
+   }
+
+   if ( ! condition.isEmpty() ) 
+   {
+      sql += " where " + condition;
+   }
+   if ( ! order.isEmpty() ) 
+   {
+      sql += " order by " + SqlSortableTableModel::OrderClause(order);
+   }
+   sql += " limit " + QString::number(PAGE_SIZE);
+   if ( condition.isEmpty() && page > 0 ) 
+   {
+      sql += " offset " + QString::number((qint64)page * PAGE_SIZE);
+   }
+   qcjDebug(LOG, 1) << __FUNCTION__ << "page = " << page << ", sql = " << sql;
+
+   QSqlQuery q1(m_db);
+   q1.setForwardOnly(true);
+   q1.prepare(sql);
+   for (int x = 0; x < values.count(); x++) 
+   {
+      q1.bindValue(x, values.at(x));
+   }
+   if ( ! q1.exec() ) 
+   {
+      qcjDebug(LOG, 1) << __FUNCTION__ << "Error: " << q1.lastError().text();
+      return(false);
+   }
+   m_queryCount.Increment();
+
+   int columns = q1.record().count();
+   rows.reserve(PAGE_SIZE);
+   while ( q1.next() ) 
+   {
+      Row_t row(columns);
+      for (int x = 0; x < columns; x++) 
+      {
+         row[x] = q1.value(x);
+      }
+      rows.append(row);
+   }
+   m_rowsFetched.Increment(rows.count());
+
+   if ( reverse ) 
+   {
+      std::reverse(rows.begin(), rows.end());
+   }
+   if ( record != NULL ) 
+   {
+      *record = q1.record();
+   }
+   return(true);
+}
+
+QString SqlPagedTableModel::FilteredQuery() const
+{
+   QString rv = m_queryBase;
+   if ( ! m_queryFilter.isEmpty() ) 
+   {
+      rv += " where " + m_queryFilter;
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   QString  SqlPagedTableModel::KeysetCondition(const QVariantList &key, 
+**                                                bool after, QVariantList &values) const protected
+**   
+**   Builds  the  condition  selecting  the rows that sort after, or
+**   before,  the  row  with the given key, appending the values it
+**   binds  to  values.  For keys a, b in ascending order, after is
+**   (a > ?) or (a = ? and b > ?).
+**
+**   NULLs  are  placed  where  the  database  sorts  them,  see
+**   SqlSortableTableModel::NullsSortHigh(),  so  where  they  sort
+**   after  the  key  "a  >  ?"  becomes  ("a"  >  ?  or "a" is null),
+**   a  NULL  in  the key is matched with is null and is followed,
+**   or preceded, by every row with a value.
+**   
+**   Returns  the  condition,  or  an  empty  string  if no row can
+**   follow the key.
+***********************************************************************/
+QString SqlPagedTableModel::KeysetCondition(const QVariantList &key, bool after, QVariantList &values) const
+{
+   QString rv;
+   QList<FieldDescr_t> order = KeyOrder();
+   bool nulls_high = SqlSortableTableModel::NullsSortHigh(m_db);
+   QVariantList bound;
+
+   if ( key.count() != order.count() ) 
+   {
+      return(QString());
+   }
+
+   for (int x = 0; x < order.count(); x++) 
+   {
+      bool ascending = order.at(x).second == ASCENDING;
+      bool nulls_last = nulls_high == ascending;
+      QString column = "\"" + order.at(x).first + "\"";
+
+      /************************************************************/
+      /*   Nothing follows a NULL that sorts last, nothing comes    */
+      /*   before one that sorts first.                             */
+      /************************************************************/
+      if ( key.at(x).isNull() && after == nulls_last ) 
+      {
+         continue;
+      }
+
+      QString term;
+      for (int y = 0; y < x; y++) 
+      {
+         if ( key.at(y).isNull() ) 
+         {
+            term += "\"" + order.at(y).first + "\" is null and ";
+         }
+         else 
+         {
+            term += "\"" + order.at(y).first + "\" = ? and ";
+            bound.append(key.at(y));
+         }
+      }
+
+      if ( key.at(x).isNull() ) 
+      {
+         term += column + " is not null";
+      }
+      else 
+      {
+         term += "(" + column + " " + ((ascending == after) ? ">" : "<") + " ?";
+         term += (after == nulls_last) ? " or " + column + " is null)" : QString(")");
+         bound.append(key.at(x));
+      }
+
+      rv += rv.isEmpty() ? "" : " or ";
+      rv += "(" + term + ")";
+   }
+
+   if ( rv.isEmpty() ) 
+   {
+      return(QString());
+   }
+   values += bound;
+   return("(" + rv + ")");
+}
+
+/********************************************************************//*
+**   QList<FieldDescr_t> SqlPagedTableModel::KeyOrder() const protected
+**   
+**   Returns  the  sort  order  with  the  key column added last, or
+**   an empty list if there is no key column.
+***********************************************************************/
+QList<SqlPagedTableModel::FieldDescr_t> SqlPagedTableModel::KeyOrder() const
+{
+   QList<FieldDescr_t> rv;
+
+   if ( ! m_keyColumn.isEmpty() ) 
+   {
+      rv = m_queryOrder;
+      bool have_key = false;
+      foreach (const FieldDescr_t &fd, rv)
+      {
+         have_key = have_key || fd.first == m_keyColumn;
+      }
+      if ( ! have_key ) 
+      {
+         rv.append(FieldDescr_t(m_keyColumn, ASCENDING));
+      }
+   }
+   return(rv);
+}
+
+QVariantList SqlPagedTableModel::RowKey(const Row_t &row) const
+{
+   QVariantList rv;
+   foreach (int index, m_keyIndexes)
+   {
+      rv.append(row.at(index));
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   int SqlPagedTableModel::EstimateRows(bool &exact) const protected
+**   
+**   Returns  the  number  of  rows  in  the  result.  PostgreSQL's
+**   planner  estimate  is  used  where available since an exact
+**   count  scans  the  whole result, other databases get a count(*)
+**   which  at  least  does  not  send  any rows. exact is set to
+**   whether the count is exact.
+***********************************************************************/
+int SqlPagedTableModel::EstimateRows(bool &exact) const
+{
+   int rv = 0;
+   bool ok;
+   QSqlQuery q1(m_db);
+
+   exact = q1.driver()->dbmsType() != QSqlDriver::PostgreSQL;
+   if ( exact ) 
+   {
+      q1.prepare("select count(*) from (" + FilteredQuery() + ") qcj_page");
+      for (int x = 0; x < m_filterValues.count(); x++) 
+      {
+         q1.bindValue(x, m_filterValues.at(x));
+      }
+      ok = q1.exec();
+   }
+   else 
+   {
+      /************************************************************/
+      /*   PostgreSQL  can  not  prepare  an explain, the values    */
+      /*   are written into the statement instead.                  */
+      /************************************************************/
+      ok = q1.exec("explain select * from (" + InlineValues(FilteredQuery(), m_filterValues, q1.driver()) + ") qcj_page");
+   }
+
+   if ( ok && q1.next() ) 
+   {
+      if ( exact ) 
+      {
+         rv = q1.value(0).toInt();
+      }
+      else 
+      {
+         QRegularExpressionMatch match = QRegularExpression("rows=(\\d+)").match(q1.value(0).toString());
+         rv = match.hasMatch() ? match.captured(1).toInt() : 0;
+      }
+   }
+   m_queryCount.Increment();
+   return(rv);
+}
+
+/********************************************************************//*
+**   static  QString  SqlPagedTableModel::InlineValues(const QString &sql, 
+**                          const QVariantList &values, const QSqlDriver *driver) protected
+**   
+**   Returns  sql  with  each  ?  placeholder  outside  of  quotes
+**   replaced by the next of values written as a literal by driver.
+***********************************************************************/
+QString SqlPagedTableModel::InlineValues(const QString &sql, const QVariantList &values, const QSqlDriver *driver)
+{
+   QString rv;
+   QChar quote;
+   int next = 0;
+
+   rv.reserve(sql.size());
+   for (int x = 0; x < sql.size(); x++) 
+   {
+      QChar ch = sql.at(x);
+      if ( ! quote.isNull() ) 
+      {
+         quote = (ch == quote) ? QChar() : quote;
+      }
+      else if ( ch == '\'' || ch == '"' ) 
+      {
+         quote = ch;
+      }
+      else if ( ch == '?' && next < values.count() ) 
+      {
+         rv += SqlFilter::Literal(values.at(next++), driver);
+         continue;
+      }
+      rv += ch;
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   void SqlPagedTableModel::InitMetrics() protected
+**   
+**   Registers  the  model's  query  and  row  counters, labeled as
+**   those of SqlSortableTableModel.
+***********************************************************************/
+void SqlPagedTableModel::InitMetrics()
+{
+   if ( ! m_queryCount.IsValid() ) 
+   {
+      QString model = metaObject()->className();
+      if ( ! objectName().isEmpty() ) 
+         model += ":" + objectName();
+      QString labels = "model=\"" + model + "\"";
+      m_queryCount = MetricCounter("qcjlib_model_queries_total", "Queries executed by a table model", labels);
+      m_rowsFetched = MetricCounter("qcjlib_model_rows_fetched_total", "Rows fetched by a table model", labels);
+   }
+}
@@ -0,0 +1,145 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef SQLPAGEDTABLEMODEL_H
+#define SQLPAGEDTABLEMODEL_H
+
+#include "LogBuilder.h"
+#include "MetricBuilder.h"
+#include "SqlFilter.h"
+#include "SqlSortableTableModel.h"
+
+#include <QAbstractTableModel>
+#include <QCache>
+#include <QHash>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QString>
+#include <QVariantList>
+#include <QVector>
+
+namespace QcjLib
+{
+   /********************************************************************//*
+   **   class SqlPagedTableModel
+   **   
+   **   A  read  only  table  model  over  a  query  that  may  return
+   **   millions  of  rows.  Rather  than  fetching  everything up to
+   **   the  rows  being  looked  at,  as  QSqlQueryModel  does,  it
+   **   fetches  PAGE_SIZE  row pages on demand, only for the rows a
+   **   view actually asks for, and keeps the MAX_PAGES most recently
+   **   used ones.
+   **
+   **   Pages  next  to  one  already  fetched  are found by keyset
+   **   pagination,  continuing  from  the  sort  key  of  its  last (or
+   **   first)  row,  which  an  index  on  the sort columns turns into
+   **   a  short  range  scan.  This  needs  a key column that makes
+   **   the  order  unique,  see SetKeyColumn(). Without one, or when
+   **   jumping to a page with no fetched neighbour, the page is read
+   **   with LIMIT and OFFSET.
+   **
+   **   Sorting  and  filtering  work  as  in  SqlSortableTableModel,
+   **   with  the  order  and  filter  applied  to  the  result  of the
+   **   base query, so they refer to its result column names.
+   ***********************************************************************/
+   class SqlPagedTableModel : public QAbstractTableModel
+   {
+      Q_OBJECT
+
+   public:
+      typedef SqlSortableTableModel::FieldDescr_t FieldDescr_t;
+      typedef QVector<QVariant> Row_t;
+      typedef QVector<Row_t> Page_t;
+
+      SqlPagedTableModel(QObject *parent = NULL);
+
+      void SetKeyColumn(QString field_name);
+      void SetFilter(QString where, const QVariantList &values = QVariantList());
+      void SetFilter(const SqlFilter &filter);
+      Qt::SortOrder SetOrder(QString field_name);
+      Qt::SortOrder SetOrder(int column);
+      void ClearOrder();
+      void SetQuery(QString query, QSqlDatabase database = QSqlDatabase());
+      void select();
+
+      QSqlRecord record() const
+      {
+         return(m_record);
+      }
+
+      int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+      int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+      QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+      QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+      bool canFetchMore(const QModelIndex &parent = QModelIndex()) const override;
+      void fetchMore(const QModelIndex &parent = QModelIndex()) override;
+
+      static const QString LOG;
+      static const int     PAGE_SIZE;
+      static const int     MAX_PAGES;
+
+   protected slots:
+      void SlotSetRowCount(int rows);
+
+   protected:
+      struct PageBounds
+      {
+         QVariantList   first;
+         QVariantList   last;
+      };
+
+      const Page_t *Page(int page) const;
+      bool     FetchPage(int page, Page_t &rows, QSqlRecord *record = NULL) const;
+      QString  FilteredQuery() const;
+      QString  KeysetCondition(const QVariantList &key, bool after, QVariantList &values) const;
+      QList<FieldDescr_t>  KeyOrder() const;
+      QVariantList         RowKey(const Row_t &row) const;
+      int      EstimateRows(bool &exact) const;
+      void     InitMetrics();
+
+      static QString InlineValues(const QString &sql, const QVariantList &values, const QSqlDriver *driver);
+
+   private:
+      QString                    m_queryBase;
+      QString                    m_queryFilter;
+      QVariantList               m_filterValues;
+      QList<FieldDescr_t>        m_queryOrder;
+      QString                    m_keyColumn;
+      QSqlDatabase               m_db;
+      QSqlRecord                 m_record;
+      QVector<int>               m_keyIndexes;
+      int                        m_rowCount;
+      bool                       m_rowCountExact;
+      mutable QCache<int, Page_t>         m_pages;
+      mutable QHash<int, PageBounds>      m_bounds;
+      MetricCounter              m_queryCount;
+      MetricCounter              m_rowsFetched;
+   };
+}
+
+#endif
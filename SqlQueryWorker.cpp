@@ -0,0 +1,151 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#include "SqlQueryWorker.h"
+
+#include <QSqlError>
+#include <QSqlQuery>
+
+using namespace QcjLib;
+
+const int SqlQueryWorker::BATCH_SIZE = 500;
+
+SqlQueryWorker::SqlQueryWorker(QString source_connection, const std::atomic<quint64> *generation) :
+   QObject(NULL),
+   m_source(source_connection),
+   m_connection(QString("QcjLib_async_%1").arg((quintptr)this)),
+   m_generation(generation)
+{
+}
+
+/********************************************************************//*
+**   void  SqlQueryWorker::Run(quint64  generation,  QString  sql, 
+**                             QVariantList values)
+**   
+**   Executes  sql  with  values  bound to its placeholders and
+**   streams  the  rows back. Started() is sent once the query has
+**   run,  then  RowsReady()  for  each  batch  and Finished() at the
+**   end. Nothing is sent for a query that has gone stale.
+***********************************************************************/
+void SqlQueryWorker::Run(quint64 generation, QString sql, QVariantList values)
+{
+   if ( IsStale(generation) ) 
+   {
+      return;
+   }
+
+   /***************************************************************/
+   /*   Connections  can only be used by the thread that made them  */
+   /*   so the model's connection is cloned here on first use.     */
+   /***************************************************************/
+   QSqlDatabase db;
+   if ( QSqlDatabase::contains(m_connection) ) 
+   {
+      db = QSqlDatabase::database(m_connection);
+   }
+   else 
+   {
+      db = QSqlDatabase::cloneDatabase(m_source, m_connection);
+      db.open();
+   }
+
+   if ( ! db.isOpen() ) 
+   {
+      emit Finished(generation, false, db.lastError().text());
+      return;
+   }
+
+   QSqlQuery q1(db);
+   q1.setForwardOnly(true);
+   q1.prepare(sql);
+   for (int x = 0; x < values.count(); x++) 
+   {
+      q1.bindValue(x, values.at(x));
+   }
+
+   if ( ! q1.exec() ) 
+   {
+      if ( ! IsStale(generation) ) 
+      {
+         emit Finished(generation, false, q1.lastError().text());
+      }
+      return;
+   }
+
+   if ( IsStale(generation) ) 
+   {
+      return;
+   }
+
+   QSqlRecord record = q1.record();
+   int columns = record.count();
+   SqlRows_t rows;
+   emit Started(generation, record);
+
+   rows.reserve(BATCH_SIZE);
+   while ( q1.next() ) 
+   {
+      QVector<QVariant> row(columns);
+      for (int x = 0; x < columns; x++) 
+      {
+         row[x] = q1.value(x);
+      }
+      rows.append(row);
+
+      if ( rows.count() >= BATCH_SIZE ) 
+      {
+         if ( IsStale(generation) ) 
+         {
+            return;
+         }
+         emit RowsReady(generation, rows);
+         rows.clear();
+         rows.reserve(BATCH_SIZE);
+      }
+   }
+
+   if ( ! rows.isEmpty() ) 
+   {
+      emit RowsReady(generation, rows);
+   }
+   emit Finished(generation, true, QString());
+}
+
+/********************************************************************//*
+**   void SqlQueryWorker::Close()
+**   
+**   Closes  and  removes  the  worker's connection. Must run on the
+**   worker's thread before it is stopped.
+***********************************************************************/
+void SqlQueryWorker::Close()
+{
+   if ( QSqlDatabase::contains(m_connection) ) 
+   {
+      QSqlDatabase::database(m_connection, false).close();
+      QSqlDatabase::removeDatabase(m_connection);
+   }
+}
@@ -0,0 +1,90 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef SQLQUERYWORKER_H
+#define SQLQUERYWORKER_H
+
+#include <QObject>
+#include <QSqlDatabase>
+#include <QSqlRecord>
+#include <QString>
+#include <QThread>
+#include <QVariant>
+#include <QVariantList>
+#include <QVector>
+
+#include <atomic>
+
+namespace QcjLib
+{
+   typedef QVector<QVector<QVariant> > SqlRows_t;
+
+   /********************************************************************//*
+   **   class SqlQueryWorker
+   **   
+   **   Runs  queries  for  a  model  on  a  thread  of its own, using
+   **   a  clone  of  the  model's  database connection made in that
+   **   thread.  The  result  is  sent back in batches of BATCH_SIZE
+   **   rows through queued signals.
+   **
+   **   Each  query  carries  a  generation  number.  Once  the model's
+   **   generation  counter  has  moved  past  it,  the query is stale
+   **   and  the  worker  stops  reading  its rows. The database call
+   **   running  the  query  itself can not be interrupted, so a new
+   **   query starts when the stale one returns.
+   ***********************************************************************/
+   class SqlQueryWorker : public QObject
+   {
+      Q_OBJECT
+
+   public:
+      SqlQueryWorker(QString source_connection, const std::atomic<quint64> *generation);
+
+      static const int  BATCH_SIZE;
+
+   public slots:
+      void Run(quint64 generation, QString sql, QVariantList values);
+      void Close();
+
+   signals:
+      void Started(quint64 generation, QSqlRecord record);
+      void RowsReady(quint64 generation, QcjLib::SqlRows_t rows);
+      void Finished(quint64 generation, bool ok, QString error);
+
+   private:
+      bool IsStale(quint64 generation) const
+      {
+         return(m_generation->load(std::memory_order_relaxed) != generation);
+      }
+
+      QString                       m_source;
+      QString                       m_connection;
+      const std::atomic<quint64>    *m_generation;
+   };
+}
+
+#endif
@@ -28,8 +28,14 @@
 #include "SqlSortableTableModel.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QSqlError>
+#include <QSqlField>
 #include <QSqlRecord>
 
+#include <algorithm>
+#include <utility>
+
 #define  ASCENDING   "asc"
 #define  DESCENDING  "desc"
 
@@ -38,26 +44,133 @@ using namespace QcjLib;
 const QString SqlSortableTableModel::LOG("QcjLib_sortable_table_model");
 static LogBuilder mylog(SqlSortableTableModel::LOG, 1, "QcjLib Sortable Table Model");
 
+const int SqlSortableTableModel::MAX_PREPARED = 8;
+
 SqlSortableTableModel::SqlSortableTableModel(QObject *parent) :
-   QSqlQueryModel(parent)
+   QSqlQueryModel(parent),
+   m_rowsCounted(0),
+   m_async(false),
+   m_asyncBusy(false),
+   m_columnar(false),
+   m_generation(0),
+   m_workerThread(NULL),
+   m_worker(NULL)
+{
+}
+
+SqlSortableTableModel::~SqlSortableTableModel()
+{
+   StopWorker();
+}
+
+/********************************************************************//*
+**   void SqlSortableTableModel::SetAsync(bool enable)
+**   
+**   In  async  mode  select()  returns  at  once and the query runs
+**   on  a  worker  thread  with  a  clone of the model's connection.
+**   The  rows  are  inserted  in  batches  as they arrive, reported
+**   by  SelectProgress(),  and  SelectFinished() is sent at the end.
+**   A  newer  select()  makes  the  one  in flight stale, its rows
+**   are dropped.
+**
+**   The  rows  are  kept  by  this  model  rather  than  the
+**   QSqlQueryModel,  in  a SqlColumnStore, so in async mode use
+**   data() or record(int) of this class, not query().
+***********************************************************************/
+void SqlSortableTableModel::SetAsync(bool enable)
+{
+   if ( enable != m_async ) 
+   {
+      beginResetModel();
+      m_generation.fetch_add(1);
+      m_async = enable;
+      m_asyncBusy = false;
+      m_store.Reset(QSqlRecord());
+      ClearPermutation();
+      endResetModel();
+   }
+}
+
+/********************************************************************//*
+**   void SqlSortableTableModel::SetColumnar(bool enable)
+**   
+**   In  columnar  mode  select()  reads  the  whole  result  at once
+**   into  a  SqlColumnStore,  a  typed  vector  per column, instead
+**   of  leaving  it  to  QSqlQueryModel.  That  takes  a fraction of
+**   the  memory  for  large  results  and  a  sort  is always done
+**   locally  on  the  typed  values.  As  in  async  mode  use  data()
+**   or record(int) of this class, not query().
+**
+**   The  change  takes  effect  with  the  next select(). Async mode
+**   keeps its rows in a column store as well.
+***********************************************************************/
+void SqlSortableTableModel::SetColumnar(bool enable)
 {
+   if ( enable != m_columnar ) 
+   {
+      beginResetModel();
+      m_columnar = enable;
+      m_store.Reset(QSqlRecord());
+      ClearPermutation();
+      endResetModel();
+   }
 }
 
-void SqlSortableTableModel::SetFilter(QString where)
+/********************************************************************//*
+**   void  SqlSortableTableModel::SetFilter(QString  where, 
+**                                          const QVariantList &values)
+**   
+**   Sets  the  where  clause  used by the next select(). Values for
+**   the  clause  should  be  passed  in  values  and  referred to by
+**   ?  placeholders  rather  than  pasted  into  where.  That  keeps
+**   the  statement  text  the  same  when  only  the  values change,
+**   so the prepared query is reused.
+**   
+**   Parameters
+**   
+**   where    The where clause without the where keyword
+**   
+**   values   Values bound to the placeholders in order
+**   
+**   Returns N/A
+***********************************************************************/
+void SqlSortableTableModel::SetFilter(QString where, const QVariantList &values)
 {
    m_queryFilter = where;
+   m_filterValues = values;
 }
 
-Qt::SortOrder SqlSortableTableModel::SetOrder(QString field_name)
+/********************************************************************//*
+**   void SqlSortableTableModel::SetFilter(const SqlFilter &filter)
+**   
+**   Sets  the  where  clause  of  the next select() from filter. The
+**   values are bound, never written into the statement.
+***********************************************************************/
+void SqlSortableTableModel::SetFilter(const SqlFilter &filter)
+{
+   SetFilter(filter.Sql(), filter.Values());
+}
+
+/********************************************************************//*
+**   static  Qt::SortOrder  SqlSortableTableModel::UpdateOrder(QList<FieldDescr_t> &order, 
+**                                                             QString field_name)
+**   
+**   Moves  field_name  to  the  front  of  the  order  list. If it
+**   already  was  in front its direction is flipped, otherwise it
+**   sorts ascending. Shared with SqlPagedTableModel.
+**   
+**   Returns the new direction of field_name.
+***********************************************************************/
+Qt::SortOrder SqlSortableTableModel::UpdateOrder(QList<FieldDescr_t> &order, QString field_name)
 {
    FieldDescr_t fd;
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << "setting sort order for column named: " << field_name << ", sorted column count = " << m_queryOrder.count();
-   if ( m_queryOrder.count() > 0 ) 
+   qcjDebug(LOG, 1) << __FUNCTION__ << "setting sort order for column named: " << field_name << ", sorted column count = " << order.count();
+   if ( order.count() > 0 ) 
    {
-      if ( m_queryOrder.first().first == field_name ) 
+      if ( order.first().first == field_name ) 
       {
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << "Flipping sort order";
-         fd = m_queryOrder.takeFirst();
+         qcjDebug(LOG, 1) << __FUNCTION__ << "Flipping sort order";
+         fd = order.takeFirst();
          if ( fd.second == ASCENDING ) 
          {
             fd.second = DESCENDING;
@@ -69,13 +182,13 @@ Qt::SortOrder SqlSortableTableModel::SetOrder(QString field_name)
       }
       else
       {
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << "Adding additional sort column";
-         for (int x = 0; x < m_queryOrder.count(); x++) 
+         qcjDebug(LOG, 1) << __FUNCTION__ << "Adding additional sort column";
+         for (int x = 0; x < order.count(); x++) 
          {
-            if ( m_queryOrder[x].first == field_name ) 
+            if ( order[x].first == field_name ) 
             {
-               qDebug(*log(LOG, 1)) << __FUNCTION__ << "Found column already in the list, removing it";
-               fd = m_queryOrder.takeAt(x);
+               qcjDebug(LOG, 1) << __FUNCTION__ << "Found column already in the list, removing it";
+               fd = order.takeAt(x);
                fd.second = ASCENDING;
                break; 
             }
@@ -87,18 +200,22 @@ Qt::SortOrder SqlSortableTableModel::SetOrder(QString field_name)
       fd.first = field_name;
       fd.second = ASCENDING;
    }
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << "Placing column up front";
-   m_queryOrder.push_front(fd);
+   qcjDebug(LOG, 1) << __FUNCTION__ << "Placing column up front";
+   order.push_front(fd);
    return((fd.second == ASCENDING) ? Qt::AscendingOrder : Qt::DescendingOrder);
 }
 
+Qt::SortOrder SqlSortableTableModel::SetOrder(QString field_name)
+{
+   return(UpdateOrder(m_queryOrder, field_name));
+}
 
 Qt::SortOrder SqlSortableTableModel::SetOrder(int column)
 {
    Qt::SortOrder rv = Qt::AscendingOrder;
-   QSqlRecord rec = record();
+   QSqlRecord rec = ResultRecord();
    QString field_name = rec.fieldName(column);
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << "found field " << field_name << " in column " << column;
+   qcjDebug(LOG, 1) << __FUNCTION__ << "found field " << field_name << " in column " << column;
    if ( ! field_name.isEmpty() ) 
    {
       rv = SetOrder(field_name);
@@ -113,21 +230,714 @@ void SqlSortableTableModel::ClearOrder()
 
 void SqlSortableTableModel::SetQuery(QString query, QSqlDatabase database)
 {
+   if ( database.connectionName() != m_db.connectionName() ) 
+   {
+      StopWorker();
+   }
    m_db = database;
    m_queryBase = query;
    m_queryFilter.clear();
+   m_filterValues.clear();
    m_queryOrder.clear();
+   m_prepared.clear();
+   m_preparedOrder.clear();
    select();
 }
    
+/********************************************************************//*
+**   void SqlSortableTableModel::select()
+**   
+**   Runs  the  query  for  the  current  filter and sort order once
+**   and  hands  the  result  to  the model. The model keeps the
+**   prepared query, see PreparedQuery().
+***********************************************************************/
 void SqlSortableTableModel::select()
 {
-   QString query = constructQueryString();
-   setQuery(query, m_db);
-   m_query = QSqlQuery(m_db);
-   m_query.prepare(query);
-   m_query.exec();
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << "record = " << record();
+   ClearPermutation();
+   if ( m_async ) 
+   {
+      SelectAsync();
+      return;
+   }
+   if ( m_columnar ) 
+   {
+      SelectColumnar();
+      return;
+   }
+
+   InitMetrics();
+   QString sql = constructQueryString();
+   QSqlQuery previous = m_query;
+
+   m_rowsCounted = 0;
+   m_query = PreparedQuery(sql);
+   for (int x = 0; x < m_filterValues.count(); x++) 
+   {
+      m_query.bindValue(x, m_filterValues.at(x));
+   }
+   if ( ! m_query.exec() ) 
+   {
+      qcjDebug(LOG, 1) << __FUNCTION__ << "Error: " << m_query.lastError().text();
+   }
+   m_queryCount.Increment();
+   setQuery(QSqlQuery(m_query));
+   CountRows();
+
+   /***************************************************************/
+   /*   Release  the  result  set  of  the query we switched away  */
+   /*   from, it stays prepared in the cache.                      */
+   /***************************************************************/
+   if ( previous.isActive() && previous.lastQuery() != sql ) 
+   {
+      previous.finish();
+   }
+   qcjDebug(LOG, 1) << __FUNCTION__ << "record = " << record();
+}
+
+/********************************************************************//*
+**   QSqlQuery SqlSortableTableModel::PreparedQuery(const QString &sql) protected
+**   
+**   Returns  the  prepared  query for sql, preparing it only if it
+**   is  not  among  the  MAX_PREPARED  most recently used ones. A
+**   header  click  only  changes  the  order  by,  so flipping back
+**   and  forth  between  orders, or changing the filter's bound
+**   values, does not prepare the statement again.
+***********************************************************************/
+QSqlQuery SqlSortableTableModel::PreparedQuery(const QString &sql)
+{
+   PreparedMap_t::iterator it = m_prepared.find(sql);
+   if ( it != m_prepared.end() ) 
+   {
+      m_preparedOrder.removeOne(sql);
+      m_preparedOrder.append(sql);
+      return(it.value());
+   }
+
+   QSqlQuery rv(m_db);
+   if ( rv.prepare(sql) ) 
+   {
+      m_prepareCount.Increment();
+      if ( m_prepared.count() >= MAX_PREPARED ) 
+      {
+         m_prepared.remove(m_preparedOrder.takeFirst());
+      }
+      m_prepared.insert(sql, rv);
+      m_preparedOrder.append(sql);
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   void SqlSortableTableModel::SelectColumnar() protected
+**   
+**   Runs  the  query  forward  only  and  copies every row into the
+**   column store, then releases the result set.
+***********************************************************************/
+void SqlSortableTableModel::SelectColumnar()
+{
+   QElapsedTimer timer;
+   InitMetrics();
+   QString sql = constructQueryString();
+   QSqlQuery q1 = PreparedQuery(sql);
+
+   timer.start();
+   q1.setForwardOnly(true);
+   for (int x = 0; x < m_filterValues.count(); x++) 
+   {
+      q1.bindValue(x, m_filterValues.at(x));
+   }
+   if ( ! q1.exec() ) 
+   {
+      qcjDebug(LOG, 1) << __FUNCTION__ << "Error: " << q1.lastError().text();
+   }
+   m_queryCount.Increment();
+
+   beginResetModel();
+   m_rowsCounted = 0;
+   m_store.Reset(q1.record());
+   while ( q1.next() ) 
+   {
+      m_store.AppendRow(q1);
+   }
+   m_store.Squeeze();
+   endResetModel();
+   CountRows();
+
+   /***************************************************************/
+   /*   The  prepared  query is shared with the QSqlQueryModel     */
+   /*   mode, which needs to scroll.                               */
+   /***************************************************************/
+   q1.finish();
+   q1.setForwardOnly(false);
+
+   m_storeBytes.Set(m_store.MemoryUsage());
+   qcjDebug(LOG, 1) << __FUNCTION__ << "read " << m_store.RowCount() << " rows, " << m_store.MemoryUsage() << " bytes in " << timer.elapsed() << " ms";
+}
+
+/********************************************************************//*
+**   void SqlSortableTableModel::SelectAsync() protected
+**   
+**   Starts  the  query  on  the  worker  thread  and  clears  the
+**   rows.  The  columns  stay  until  the  new  result  arrives so
+**   the header does not flicker.
+***********************************************************************/
+void SqlSortableTableModel::SelectAsync()
+{
+   InitMetrics();
+   QString sql = constructQueryString();
+   quint64 generation = m_generation.fetch_add(1) + 1;
+
+   StartWorker();
+   beginResetModel();
+   m_store.Reset(m_store.Record());
+   m_rowsCounted = 0;
+   m_asyncBusy = true;
+   endResetModel();
+
+   QMetaObject::invokeMethod(m_worker, "Run", Qt::QueuedConnection, 
+                             Q_ARG(quint64, generation), Q_ARG(QString, sql), Q_ARG(QVariantList, m_filterValues));
+   m_queryCount.Increment();
+}
+
+void SqlSortableTableModel::StartWorker()
+{
+   if ( m_worker == NULL ) 
+   {
+      qRegisterMetaType<QSqlRecord>("QSqlRecord");
+      qRegisterMetaType<QcjLib::SqlRows_t>("QcjLib::SqlRows_t");
+
+      /***************************************************************/
+      /*   SetQuery()  without  a  database  leaves  m_db  invalid, the  */
+      /*   queries then run on the default connection.                */
+      /***************************************************************/
+      QString connection = m_db.connectionName();
+      if ( ! m_db.isValid() || connection.isEmpty() ) 
+      {
+         connection = QLatin1String(QSqlDatabase::defaultConnection);
+      }
+
+      m_workerThread = new QThread(this);
+      m_worker = new SqlQueryWorker(connection, &m_generation);
+      m_worker->moveToThread(m_workerThread);
+
+      connect(m_worker, SIGNAL(Started(quint64, QSqlRecord)), 
+              this, SLOT(SlotAsyncStarted(quint64, QSqlRecord)));
+      connect(m_worker, SIGNAL(RowsReady(quint64, QcjLib::SqlRows_t)), 
+              this, SLOT(SlotAsyncRows(quint64, QcjLib::SqlRows_t)));
+      connect(m_worker, SIGNAL(Finished(quint64, bool, QString)), 
+              this, SLOT(SlotAsyncFinished(quint64, bool, QString)));
+      m_workerThread->start();
+   }
+}
+
+/********************************************************************//*
+**   void SqlSortableTableModel::StopWorker() protected
+**   
+**   Stops  the  worker  thread  after  closing its connection. This
+**   waits for a query still running on it to return.
+***********************************************************************/
+void SqlSortableTableModel::StopWorker()
+{
+   if ( m_worker != NULL ) 
+   {
+      m_generation.fetch_add(1);
+      QMetaObject::invokeMethod(m_worker, "Close", Qt::BlockingQueuedConnection);
+      m_workerThread->quit();
+      m_workerThread->wait();
+      delete m_worker;
+      delete m_workerThread;
+      m_worker = NULL;
+      m_workerThread = NULL;
+   }
+}
+
+void SqlSortableTableModel::SlotAsyncStarted(quint64 generation, QSqlRecord record)
+{
+   if ( generation == m_generation.load() && record != m_store.Record() ) 
+   {
+      beginResetModel();
+      m_store.Reset(record);
+      endResetModel();
+   }
+}
+
+void SqlSortableTableModel::SlotAsyncRows(quint64 generation, QcjLib::SqlRows_t rows)
+{
+   if ( generation != m_generation.load() || rows.isEmpty() ) 
+   {
+      return;
+   }
+
+   beginInsertRows(QModelIndex(), m_store.RowCount(), m_store.RowCount() + rows.count() - 1);
+   foreach (const QVector<QVariant> &row, rows)
+   {
+      m_store.AppendRow(row);
+   }
+   endInsertRows();
+   CountRows();
+   emit SelectProgress(m_store.RowCount());
+}
+
+void SqlSortableTableModel::SlotAsyncFinished(quint64 generation, bool ok, QString error)
+{
+   if ( generation == m_generation.load() ) 
+   {
+      m_asyncBusy = false;
+      m_store.Squeeze();
+      m_storeBytes.Set(m_store.MemoryUsage());
+      if ( ! ok ) 
+      {
+         qcjDebug(LOG, 1) << __FUNCTION__ << "Error: " << error;
+      }
+      emit SelectFinished(ok, error);
+   }
+}
+
+void SqlSortableTableModel::fetchMore(const QModelIndex &parent)
+{
+   if ( ! IsLocal() ) 
+   {
+      m_sortKeys.clear();
+      QSqlQueryModel::fetchMore(parent);
+      CountRows();
+   }
+}
+
+bool SqlSortableTableModel::canFetchMore(const QModelIndex &parent) const
+{
+   return(IsLocal() ? false : QSqlQueryModel::canFetchMore(parent));
+}
+
+int SqlSortableTableModel::rowCount(const QModelIndex &parent) const
+{
+   if ( IsLocal() ) 
+   {
+      return(parent.isValid() ? 0 : m_store.RowCount());
+   }
+   return(QSqlQueryModel::rowCount(parent));
+}
+
+int SqlSortableTableModel::columnCount(const QModelIndex &parent) const
+{
+   if ( IsLocal() ) 
+   {
+      return(parent.isValid() ? 0 : m_store.ColumnCount());
+   }
+   return(QSqlQueryModel::columnCount(parent));
+}
+
+QVariant SqlSortableTableModel::data(const QModelIndex &item, int role) const
+{
+   if ( ! item.isValid() ) 
+   {
+      return(QVariant());
+   }
+
+   int row = item.row();
+   if ( ! m_permutation.isEmpty() && row < m_permutation.count() ) 
+   {
+      row = m_permutation.at(row);
+   }
+
+   if ( IsLocal() ) 
+   {
+      QVariant rv;
+      if ( (role == Qt::DisplayRole || role == Qt::EditRole) &&
+           row < m_store.RowCount() && item.column() < m_store.ColumnCount() ) 
+      {
+         rv = m_store.Value(row, item.column());
+      }
+      return(rv);
+   }
+   return(QSqlQueryModel::data(row == item.row() ? item : index(row, item.column()), role));
+}
+
+/********************************************************************//*
+**   QSqlRecord SqlSortableTableModel::record(int row) const
+**   
+**   Returns  the  row  as  it  is  currently  sorted,  in  any  mode.
+**   QSqlQueryModel::record(int)  is  not  virtual  and  knows nothing
+**   of  a  local  sort  or  the  column store, so call this one, not
+**   the QSqlQueryModel one.
+***********************************************************************/
+QSqlRecord SqlSortableTableModel::record(int row) const
+{
+   if ( ! m_permutation.isEmpty() && row >= 0 && row < m_permutation.count() ) 
+   {
+      row = m_permutation.at(row);
+   }
+
+   if ( IsLocal() ) 
+   {
+      QSqlRecord rv = m_store.Record();
+      if ( row >= 0 && row < m_store.RowCount() ) 
+      {
+         for (int x = 0; x < rv.count(); x++) 
+         {
+            rv.setValue(x, m_store.Value(row, x));
+         }
+      }
+      return(rv);
+   }
+   return(QSqlQueryModel::record(row));
+}
+
+/********************************************************************//*
+**   QVariant SqlSortableTableModel::SourceData(int row, int column) const protected
+**   
+**   Returns  a  value  by  its  row  in the result as fetched, not
+**   as currently sorted.
+***********************************************************************/
+QVariant SqlSortableTableModel::SourceData(int row, int column) const
+{
+   if ( IsLocal() ) 
+   {
+      return(m_store.Value(row, column));
+   }
+   return(QSqlQueryModel::data(index(row, column)));
+}
+
+/********************************************************************//*
+**   void SqlSortableTableModel::ApplyOrder()
+**   
+**   Applies  the  order  set  by  SetOrder(). If the whole result
+**   has  been  fetched  it  is  sorted  here,  otherwise the query
+**   is run again with the new order by.
+***********************************************************************/
+void SqlSortableTableModel::ApplyOrder()
+{
+   if ( ! SortLocally() ) 
+   {
+      select();
+   }
+}
+
+/********************************************************************//*
+**   bool SqlSortableTableModel::SortLocally()
+**   
+**   Sorts  the  fetched  rows  by  the  order  list without asking
+**   the  server.  The  rows  are  not  moved,  data()  reads  them
+**   through  a  permutation,  and  each  column's  values are only
+**   converted  once  for  sorting.  The  sort is stable, rows that
+**   compare  equal  keep  the order the server returned them in.
+**
+**   The  order  follows  the  database's  where  it can, so a click
+**   sorts  the  same  whether  or  not  every row was fetched. NULLs
+**   go  where  the  driver  puts  them, see NullsSortHigh(), integers
+**   are  compared  exactly  and  strings  by  their  characters,  as
+**   SQLite's  binary  collation  does.  Other  databases  sort strings
+**   by  a  collation  of  their  own,  so a string column is only
+**   sorted  here  when  the  rows are kept locally, and then in the
+**   user's locale.
+**   
+**   Returns  false,  leaving  the  rows as they are, if not all rows
+**   have  been  fetched,  a  sort  column  is  not in the result or
+**   is a string column the server should sort.
+***********************************************************************/
+bool SqlSortableTableModel::SortLocally()
+{
+   QElapsedTimer timer;
+   QSqlRecord rec = ResultRecord();
+   QVector<int> columns;
+   QVector<bool> descending;
+
+   if ( m_asyncBusy || (! IsLocal() && QSqlQueryModel::canFetchMore()) || 
+        m_queryOrder.isEmpty() ) 
+   {
+      return(false);
+   }
+
+   foreach (const FieldDescr_t &fd, m_queryOrder)
+   {
+      int column = rec.indexOf(fd.first);
+      if ( column < 0 ) 
+      {
+         return(false);
+      }
+      columns.append(column);
+      descending.append(fd.second == DESCENDING);
+   }
+
+   QSqlDatabase db = m_db.isValid() ? m_db : QSqlDatabase::database(QSqlDatabase::defaultConnection, false);
+   bool nulls_high = NullsSortHigh(db);
+   bool binary = db.driverName() == "QSQLITE";
+
+   timer.start();
+   QVector<const SortKey*> keys;
+   foreach (int column, columns)
+   {
+      const SortKey *key = &ColumnKey(column);
+      if ( ! key->numeric && ! binary && ! IsLocal() ) 
+      {
+         return(false);
+      }
+      keys.append(key);
+   }
+
+   int rows = rowCount();
+   QVector<int> permutation(rows);
+   for (int x = 0; x < rows; x++) 
+   {
+      permutation[x] = x;
+   }
+
+   std::stable_sort(permutation.begin(), permutation.end(), [&keys, &descending, nulls_high, binary](int a, int b)
+   {
+      for (int x = 0; x < keys.count(); x++) 
+      {
+         const SortKey *key = keys.at(x);
+         int cmp;
+         if ( key->nulls.at(a) || key->nulls.at(b) ) 
+         {
+            cmp = nulls_high ? (int)key->nulls.at(a) - (int)key->nulls.at(b) : 
+                               (int)key->nulls.at(b) - (int)key->nulls.at(a);
+         }
+         else if ( key->integral ) 
+         {
+            cmp = (key->integers.at(a) < key->integers.at(b)) ? -1 : (key->integers.at(b) < key->integers.at(a)) ? 1 : 0;
+         }
+         else if ( key->numeric ) 
+         {
+            cmp = (key->numbers.at(a) < key->numbers.at(b)) ? -1 : (key->numbers.at(b) < key->numbers.at(a)) ? 1 : 0;
+         }
+         else if ( binary ) 
+         {
+            cmp = key->strings.at(a).compare(key->strings.at(b));
+         }
+         else 
+         {
+            cmp = key->strings.at(a).localeAwareCompare(key->strings.at(b));
+         }
+
+         if ( cmp != 0 ) 
+         {
+            return(descending.at(x) ? cmp > 0 : cmp < 0);
+         }
+      }
+      return(false);
+   });
+
+   /***************************************************************/
+   /*   Keep  the  selection  and  current  index  on  the same     */
+   /*   rows.                                                      */
+   /***************************************************************/
+   emit layoutAboutToBeChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint);
+   QVector<int> new_rows(rows);
+   for (int x = 0; x < rows; x++) 
+   {
+      new_rows[permutation.at(x)] = x;
+   }
+   QModelIndexList old_list = persistentIndexList();
+   QModelIndexList new_list;
+   foreach (const QModelIndex &idx, old_list)
+   {
+      int source = m_permutation.isEmpty() ? idx.row() : m_permutation.value(idx.row(), idx.row());
+      new_list.append(index(new_rows.value(source, idx.row()), idx.column()));
+   }
+   m_permutation = permutation;
+   changePersistentIndexList(old_list, new_list);
+   emit layoutChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint);
+
+   qcjDebug(LOG, 1) << __FUNCTION__ << "sorted " << rows << " rows in " << timer.elapsed() << " ms";
+   return(true);
+}
+
+/********************************************************************//*
+**   const SortKey &SqlSortableTableModel::ColumnKey(int column) private
+**   
+**   Returns  the  sort  key  of  column, building it on first use.
+**   Integers,  dates  and  times  are  compared  as  64  bit integers,
+**   floating  point  as  doubles,  all  else as strings. Rows in the
+**   column  store  are  read  from  its typed columns without going
+**   through QVariant.
+***********************************************************************/
+const SqlSortableTableModel::SortKey &SqlSortableTableModel::ColumnKey(int column)
+{
+   SortKeyMap_t::iterator it = m_sortKeys.find(column);
+   if ( it != m_sortKeys.end() ) 
+   {
+      return(it.value());
+   }
+
+   SortKey key;
+   int rows = rowCount();
+   QVariant::Type type = ResultRecord().field(column).type();
+
+   if ( IsLocal() ) 
+   {
+      key.numeric = m_store.IsNumeric(column);
+      key.integral = m_store.IsIntegral(column);
+      key.integers.resize(key.integral ? rows : 0);
+      key.numbers.resize(key.numeric && ! key.integral ? rows : 0);
+      key.strings.resize(key.numeric ? 0 : rows);
+      key.nulls.resize(rows);
+      for (int x = 0; x < rows; x++) 
+      {
+         key.nulls[x] = m_store.IsNull(x, column);
+         if ( key.nulls.at(x) ) 
+         {
+            continue;
+         }
+         if ( key.integral ) 
+         {
+            key.integers[x] = m_store.Integer(x, column);
+         }
+         else if ( key.numeric ) 
+         {
+            key.numbers[x] = m_store.Number(x, column);
+         }
+         else 
+         {
+            key.strings[x] = m_store.String(x, column);
+         }
+      }
+      return(m_sortKeys.insert(column, key).value());
+   }
+
+   switch (type)
+   {
+      case QVariant::Int:
+      case QVariant::UInt:
+      case QVariant::LongLong:
+      case QVariant::ULongLong:
+      case QVariant::Bool:
+      case QVariant::Date:
+      case QVariant::Time:
+      case QVariant::DateTime:
+         key.numeric = true;
+         key.integral = true;
+         key.integers.resize(rows);
+         break;
+
+      case QVariant::Double:
+         key.numeric = true;
+         key.integral = false;
+         key.numbers.resize(rows);
+         break;
+
+      default:
+         key.numeric = false;
+         key.integral = false;
+         key.strings.resize(rows);
+         break;
+   }
+   key.nulls.resize(rows);
+
+   for (int x = 0; x < rows; x++) 
+   {
+      QVariant value = SourceData(x, column);
+      key.nulls[x] = value.isNull();
+      if ( key.nulls.at(x) ) 
+      {
+         continue;
+      }
+
+      if ( ! key.numeric ) 
+      {
+         key.strings[x] = value.toString();
+      }
+      else if ( type == QVariant::DateTime ) 
+      {
+         key.integers[x] = value.toDateTime().toMSecsSinceEpoch();
+      }
+      else if ( type == QVariant::Date ) 
+      {
+         key.integers[x] = value.toDate().toJulianDay();
+      }
+      else if ( type == QVariant::Time ) 
+      {
+         key.integers[x] = value.toTime().msecsSinceStartOfDay();
+      }
+      else if ( type == QVariant::ULongLong ) 
+      {
+         /************************************************************/
+         /*   Flipping  the  top  bit  keeps  the  unsigned order in    */
+         /*   a signed compare.                                        */
+         /************************************************************/
+         key.integers[x] = (qint64)(value.toULongLong() ^ Q_UINT64_C(0x8000000000000000));
+      }
+      else if ( key.integral ) 
+      {
+         key.integers[x] = value.toLongLong();
+      }
+      else 
+      {
+         key.numbers[x] = value.toDouble();
+      }
+   }
+   return(m_sortKeys.insert(column, key).value());
+}
+
+/********************************************************************//*
+**   void SqlSortableTableModel::ClearPermutation() protected
+**   
+**   Drops  the  local  sort  and  the  sort keys, for when the rows
+**   are replaced. The caller resets the model.
+***********************************************************************/
+void SqlSortableTableModel::ClearPermutation()
+{
+   m_permutation.clear();
+   m_sortKeys.clear();
+}
+
+QVariant SqlSortableTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+   if ( IsLocal() && orientation == Qt::Horizontal && role == Qt::DisplayRole ) 
+   {
+      return(m_store.Record().fieldName(section));
+   }
+   return(QSqlQueryModel::headerData(section, orientation, role));
+}
+
+/********************************************************************//*
+**   QSqlRecord SqlSortableTableModel::ResultRecord() const protected
+**   
+**   Returns the field names of the current result in either mode.
+***********************************************************************/
+QSqlRecord SqlSortableTableModel::ResultRecord() const
+{
+   return(IsLocal() ? m_store.Record() : record());
+}
+
+/********************************************************************//*
+**   void SqlSortableTableModel::CountRows()
+**   
+**   Adds  the  rows  fetched  since  the  last  call to the rows
+**   fetched  metric.  QSqlQueryModel  may  or  may not fetch the
+**   first  rows  through fetchMore(), so both it and select() call
+**   this.
+***********************************************************************/
+void SqlSortableTableModel::CountRows()
+{
+   int rows = rowCount();
+   if ( m_rowCount.IsValid() && rows > m_rowsCounted ) 
+   {
+      m_rowCount.Increment(rows - m_rowsCounted);
+      m_rowsCounted = rows;
+   }
+}
+
+/********************************************************************//*
+**   void SqlSortableTableModel::InitMetrics()
+**   
+**   Registers  the  model's  query,  prepare  and  row counters and
+**   its  column  store  gauge,  labeled  with the model's class and
+**   object  name.  This  is  put  off  until  the first select() so
+**   the derived class and object name are known.
+***********************************************************************/
+void SqlSortableTableModel::InitMetrics()
+{
+   if ( ! m_queryCount.IsValid() ) 
+   {
+      QString model = metaObject()->className();
+      if ( ! objectName().isEmpty() ) 
+         model += ":" + objectName();
+      QString labels = "model=\"" + model + "\"";
+      m_queryCount = MetricCounter("qcjlib_model_queries_total", "Queries executed by a table model", labels);
+      m_prepareCount = MetricCounter("qcjlib_model_prepares_total", "Statements prepared by a table model", labels);
+      m_rowCount = MetricCounter("qcjlib_model_rows_fetched_total", "Rows fetched by a table model", labels);
+      m_storeBytes = MetricGauge("qcjlib_model_store_bytes", "Bytes held by a table model's column store", labels);
+   }
 }
 
 QString SqlSortableTableModel::constructQueryString()
@@ -140,17 +950,45 @@ QString SqlSortableTableModel::constructQueryString()
 
    if ( m_queryOrder.count() > 0) 
    {
-      rv += " order by ";
-      for (int x = 0; x < m_queryOrder.count(); x++) 
+      rv += " order by " + OrderClause(m_queryOrder);
+   }
+   qcjDebug(LOG, 1) << __FUNCTION__ << "rv = " << rv;
+   return(rv);
+}
+
+/********************************************************************//*
+**   static QString SqlSortableTableModel::OrderClause(const QList<FieldDescr_t> &order)
+**   
+**   Returns  the  comma  separated  list of quoted field names and
+**   directions for an order by clause.
+***********************************************************************/
+QString SqlSortableTableModel::OrderClause(const QList<FieldDescr_t> &order)
+{
+   QString rv;
+   for (int x = 0; x < order.count(); x++) 
+   {
+      if ( x > 0 ) 
       {
-         if ( x > 0 ) 
-         {
-            rv += ", ";
-         }
-         rv += "\"" + m_queryOrder[x].first + "\" " + m_queryOrder[x].second;
+         rv += ", ";
       }
+
+/********************************************************************//*
+**   static bool SqlSortableTableModel::NullsSortHigh(const QSqlDatabase &db)
+**   
+**   Returns  true  if  the  database  sorts NULLs as larger than any
+**   value,  last  in  ascending  order,  as PostgreSQL, Oracle and
+**   DB2  do.  SQLite,  MySQL  and  SQL  Server  sort them as smaller
+**   than any value. An invalid db means the default connection.
+**   Shared with SqlPagedTableModel.
+***********************************************************************/
+bool SqlSortableTableModel::NullsSortHigh(const QSqlDatabase &db)
+{
+   QString driver = db.isValid() ? db.driverName() : 
+                       QSqlDatabase::database(QSqlDatabase::defaultConnection, false).driverName();
+   return(driver == "QPSQL" || driver == "QOCI" || driver == "QDB2");
+}
+      rv += "\"" + order[x].first + "\" " + order[x].second;
    }
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << "rv = " << rv;
    return(rv);
 }
 
@@ -29,12 +29,22 @@
 #define SQLSORTABLETABLEMDEL_H
 
 #include "LogBuilder.h"
+#include "MetricBuilder.h"
+#include "SqlColumnStore.h"
+#include "SqlFilter.h"
+#include "SqlQueryWorker.h"
 
+#include <QHash>
 #include <QString>
 #include <QStringList>
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlQueryModel>
+#include <QSqlRecord>
+#include <QThread>
+#include <QVariantList>
+
+#include <atomic>
 
 namespace QcjLib
 {
@@ -44,27 +54,128 @@ namespace QcjLib
 
    public:
       typedef QPair<QString, QString> FieldDescr_t;
+      typedef QHash<QString, QSqlQuery> PreparedMap_t;
 
       SqlSortableTableModel(QObject *parent = NULL);
+      ~SqlSortableTableModel();
+
+      void SetAsync(bool enable);
+      bool IsAsync() const
+      {
+         return(m_async);
+      }
+
+      bool IsBusy() const
+      {
+         return(m_asyncBusy);
+      }
 
-      void SetFilter(QString where);
+      void SetColumnar(bool enable);
+      bool IsColumnar() const
+      {
+         return(m_columnar);
+      }
+
+      void SetFilter(QString where, const QVariantList &values = QVariantList());
+      void SetFilter(const SqlFilter &filter);
       Qt::SortOrder SetOrder(QString field_name);
       Qt::SortOrder SetOrder(int column);
       void ClearOrder();
       void SetQuery(QString query, QSqlDatabase database = QSqlDatabase());
       void select();
+      void ApplyOrder();
+      bool SortLocally();
+      void fetchMore(const QModelIndex &parent = QModelIndex()) override;
+      bool canFetchMore(const QModelIndex &parent = QModelIndex()) const override;
+      int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+      int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+      QVariant data(const QModelIndex &item, int role = Qt::DisplayRole) const override;
+      QSqlRecord record(int row) const;
+      using QSqlQueryModel::record;
+      QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+      static Qt::SortOrder UpdateOrder(QList<FieldDescr_t> &order, QString field_name);
+      static QString OrderClause(const QList<FieldDescr_t> &order);
+      static bool NullsSortHigh(const QSqlDatabase &db);
 
       static const QString LOG;
+      static const int     MAX_PREPARED;
+
+   signals:
+      void SelectProgress(int rows);
+      void SelectFinished(bool ok, QString error);
+
+   protected slots:
+      void SlotAsyncStarted(quint64 generation, QSqlRecord record);
+      void SlotAsyncRows(quint64 generation, QcjLib::SqlRows_t rows);
+      void SlotAsyncFinished(quint64 generation, bool ok, QString error);
 
    protected:
       QString constructQueryString();
+      void CountRows();
+      void InitMetrics();
+      QSqlQuery PreparedQuery(const QString &sql);
+      QSqlRecord ResultRecord() const;
+      QVariant SourceData(int row, int column) const;
+      void ClearPermutation();
+      void SelectAsync();
+      void SelectColumnar();
+      void StartWorker();
+      void StopWorker();
 
    private:
+      /***********************************************/
+      /*   The values of one column converted once  */
+      /*   for sorting, as numbers where the        */
+      /*   column's type allows. Integers, dates    */
+      /*   and times are kept exactly in integers.  */
+      /***********************************************/
+      struct SortKey
+      {
+         bool              numeric;
+         bool              integral;
+         QVector<qint64>   integers;
+         QVector<double>   numbers;
+         QVector<QString>  strings;
+         QVector<bool>     nulls;
+      };
+      typedef QHash<int, SortKey> SortKeyMap_t;
+
+      const SortKey &ColumnKey(int column);
+
+      /***********************************************/
+      /*   True when the rows are in m_store rather */
+      /*   than the QSqlQueryModel.                 */
+      /***********************************************/
+      bool IsLocal() const
+      {
+         return(m_async || m_columnar);
+      }
+
       QString              m_queryBase;
       QString              m_queryFilter;
+      QVariantList         m_filterValues;
       QList<FieldDescr_t>  m_queryOrder;
       QSqlDatabase         m_db;
       QSqlQuery            m_query;
+      PreparedMap_t        m_prepared;
+      QStringList          m_preparedOrder;
+      MetricCounter        m_queryCount;
+      MetricCounter        m_prepareCount;
+      MetricCounter        m_rowCount;
+      MetricGauge          m_storeBytes;
+      int                  m_rowsCounted;
+
+      bool                    m_async;
+      bool                    m_asyncBusy;
+      bool                    m_columnar;
+      SqlColumnStore          m_store;
+      std::atomic<quint64>    m_generation;
+      QThread                 *m_workerThread;
+      SqlQueryWorker          *m_worker;
+
+      QVector<int>            m_permutation;
+      SortKeyMap_t            m_sortKeys;
    };
 }
 
@@ -67,12 +67,12 @@ namespace QcjLib
       virtual Qt::ItemFlags  flags(const QModelIndex &index) const
       {
          Qt::ItemFlags rv;
-//         qDebug(*log(LOG, 1)) <<  "m_itemFlags = " << m_itemFlags;
+//         qcjDebug(LOG, 1) <<  "m_itemFlags = " << m_itemFlags;
          if ( m_itemFlags == 0 ) 
          {
             QSqlRecord rec = record();
             QString fieldName = rec.fieldName(index.column());
-//            qDebug(*log(LOG, 1)) <<  "Fieldname = " << fieldName;
+//            qcjDebug(LOG, 1) <<  "Fieldname = " << fieldName;
             if ( fieldName == "id" ||
                  fieldName == "ident" ||
                  fieldName.endsWith("_id") ||
@@ -81,21 +81,21 @@ namespace QcjLib
                  m_fields.value(fieldName).fieldType == "image"
                ) 
             {
-//               qDebug(*log(LOG, 1)) <<  "NO EDIT";;
+//               qcjDebug(LOG, 1) <<  "NO EDIT";;
                rv = Qt::ItemIsSelectable | Qt::ItemIsDragEnabled | Qt::ItemIsEnabled;
             }
             else 
             {
-//               qDebug(*log(LOG, 1)) <<  "EDIT";;
+//               qcjDebug(LOG, 1) <<  "EDIT";;
                rv = Qt::ItemIsSelectable | Qt::ItemIsDragEnabled | Qt::ItemIsEnabled | Qt::ItemIsEditable;  
             }
          }
          else 
          {
- //           qDebug(*log(LOG, 1)) <<  "Default!";;
+ //           qcjDebug(LOG, 1) <<  "Default!";;
             rv = m_itemFlags;
          }
-//         qDebug(*log(LOG, 1)) <<  "rv = " << rv;
+//         qcjDebug(LOG, 1) <<  "rv = " << rv;
          return(rv);
       }
 
@@ -0,0 +1,213 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+# include "StallDetector.h"
+# include "LogBuilder.h"
+# include "Logger.h"
+# include "ScopeProfiler.h"
+# include "ScopeStack.h"
+
+# include <QCoreApplication>
+# include <QMutexLocker>
+
+using namespace QcjLib;
+
+const QString StallDetector::LOG("QcjLib_stall_detector");
+static LogBuilder mylog(StallDetector::LOG, 1, "QcjLib GUI Stall Detector");
+
+const QEvent::Type StallDetector::HEARTBEAT_EVENT = (QEvent::Type)QEvent::registerEventType();
+
+static void StopStallDetector()
+{
+   StallDetector::instance()->Stop();
+}
+
+namespace
+{
+   class HeartbeatEvent : public QEvent
+   {
+   public:
+      HeartbeatEvent(QEvent::Type type, quint64 seq) :
+         QEvent(type),
+         m_seq(seq)
+      {
+      }
+
+      quint64 m_seq;
+   };
+}
+
+StallDetector::StallDetector() :
+   m_watcher(NULL),
+   m_thresholdMs(DEFAULT_THRESHOLD_MS),
+   m_intervalMs(DEFAULT_INTERVAL_MS),
+   m_stop(false),
+   m_servicedSeq(0),
+   m_servicedNs(0),
+   m_stalls(0),
+   m_guiStack(NULL)
+{
+   /***********************************************/
+   /*   Heartbeats are handled by this object, so */
+   /*   it has to live in the GUI thread.         */
+   /***********************************************/
+   if ( QCoreApplication::instance() != NULL ) 
+      moveToThread(QCoreApplication::instance()->thread());
+}
+
+bool StallDetector::IsRunning() const
+{
+   return(m_watcher != NULL);
+}
+
+quint64 StallDetector::StallCount() const
+{
+   return(m_stalls.load(std::memory_order_relaxed));
+}
+
+/********************************************************************//*
+**   void StallDetector::Start(int threshold_ms, int interval_ms)
+**   
+**   Starts  watching  the  event loop, restarting the watch thread
+**   if it is already running. A stall is a heartbeat that waits
+**   more  than  threshold_ms to be handled. Heartbeats are posted
+**   interval_ms after the previous one was handled.
+**
+**   The  watch  thread  is  stopped  and  joined when the
+**   application object is destroyed.
+***********************************************************************/
+void StallDetector::Start(int threshold_ms, int interval_ms)
+{
+   static bool have_post_routine = false;
+
+   Stop();
+
+   m_thresholdMs = qMax(threshold_ms, 1);
+   m_intervalMs = qMax(interval_ms, 1);
+   m_stop = false;
+   ScopeStack::SetActive(true);
+
+   m_watcher = new WatchThread(this);
+   m_watcher->setObjectName("StallDetector");
+   m_watcher->start();
+
+   if ( ! have_post_routine ) 
+   {
+      qAddPostRoutine(StopStallDetector);
+      have_post_routine = true;
+   }
+}
+
+void StallDetector::Stop()
+{
+   if ( m_watcher != NULL ) 
+   {
+      {
+         QMutexLocker locker(&m_wakeLock);
+         m_stop = true;
+         m_wakeCondition.wakeAll();
+      }
+      m_watcher->wait();
+      delete m_watcher;
+      m_watcher = NULL;
+      ScopeStack::SetActive(false);
+   }
+}
+
+/********************************************************************//*
+**   void StallDetector::customEvent(QEvent *event)
+**   
+**   Runs  on  the  GUI thread. Notes when the heartbeat was handled
+**   and which scope stack belongs to the GUI thread.
+***********************************************************************/
+void StallDetector::customEvent(QEvent *event)
+{
+   if ( event->type() == HEARTBEAT_EVENT ) 
+   {
+      m_guiStack.store(ScopeStack::Current(), std::memory_order_relaxed);
+
+      QMutexLocker locker(&m_wakeLock);
+      m_servicedSeq = static_cast<HeartbeatEvent*>(event)->m_seq;
+      m_servicedNs = Logger::MonotonicNs();
+      m_wakeCondition.wakeAll();
+   }
+}
+
+void StallDetector::WatchLoop()
+{
+   static ProfileSite latency_site("GUI event loop latency", __LINE__);
+   quint64 seq = 0;
+
+   QMutexLocker locker(&m_wakeLock);
+   while ( ! m_stop ) 
+   {
+      qint64 posted = Logger::MonotonicNs();
+      QStringList scopes;
+      bool stalled = false;
+
+      QCoreApplication::postEvent(this, new HeartbeatEvent(HEARTBEAT_EVENT, ++seq));
+      while ( ! m_stop && m_servicedSeq != seq ) 
+      {
+         qint64 waited_ms = (Logger::MonotonicNs() - posted) / 1000000;
+         if ( ! stalled && waited_ms >= m_thresholdMs ) 
+         {
+            /***********************************************/
+            /*   Grab the GUI thread's scopes while it is  */
+            /*   still stuck in them.                      */
+            /***********************************************/
+            ScopeStack *gui_stack = m_guiStack.load(std::memory_order_relaxed);
+            if ( gui_stack != NULL ) 
+               scopes = gui_stack->Snapshot();
+            stalled = true;
+
+            locker.unlock();
+            qWarning(*QcjLib::log(LOG, 1)) << "GUI event loop blocked for" << waited_ms << "ms in" 
+                                           << qPrintable(scopes.isEmpty() ? QString("<no open scopes>") : scopes.join(" -> "));
+            locker.relock();
+            continue;
+         }
+         m_wakeCondition.wait(&m_wakeLock, stalled ? m_intervalMs : qMax(m_thresholdMs - waited_ms, (qint64)1));
+      }
+
+      if ( m_stop ) 
+         break;
+
+      qint64 latency = m_servicedNs - posted;
+      ScopeProfiler::Record(latency_site, (quint64)qMax(latency, (qint64)0));
+      if ( stalled ) 
+      {
+         m_stalls.fetch_add(1, std::memory_order_relaxed);
+         locker.unlock();
+         qWarning(*QcjLib::log(LOG, 1)) << "GUI event loop stalled for" << latency / 1000000 << "ms in" 
+                                        << qPrintable(scopes.isEmpty() ? QString("<no open scopes>") : scopes.join(" -> "));
+         locker.relock();
+      }
+
+      if ( ! m_stop ) 
+         m_wakeCondition.wait(&m_wakeLock, m_intervalMs);
+   }
+}
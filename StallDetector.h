@@ -0,0 +1,120 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef STALLDETECTOR_H
+#define STALLDETECTOR_H
+
+# include <QEvent>
+# include <QMutex>
+# include <QObject>
+# include <QString>
+# include <QThread>
+# include <QWaitCondition>
+
+# include <atomic>
+
+namespace QcjLib
+{
+   class ScopeStack;
+
+   static const QString STALL_THRESHOLD_MS   ("StallThreshold");
+
+   /********************************************************************//*
+   **   class StallDetector
+   **   
+   **   Watches  the  GUI  thread's event loop from its own thread. A
+   **   heartbeat  event  is  posted  to the event loop every interval
+   **   and  the  time  it takes to be handled is added to the
+   **   ScopeProfiler  histogram  "GUI  event loop latency". If it takes
+   **   longer  than  the  threshold,  the  stall  and  the  DbgTimer
+   **   scopes  open  on  the  GUI  thread  at  that moment are logged
+   **   as  warnings  to  the  "QcjLib_stall_detector"  log,  once when
+   **   the  threshold  is  crossed  and  again when the event loop
+   **   catches up. Warnings are written whatever the log's level.
+   **
+   **   Scopes  only show up if they are timed with QCJ_TIME_SCOPE(),
+   **   QCJ_PROFILE_SCOPE() or a DbgTimer given a const char* name.
+   ***********************************************************************/
+   class StallDetector : public QObject
+   {
+      Q_OBJECT
+
+   public:
+      static StallDetector *instance()
+      {
+         static StallDetector *instance = new StallDetector();
+         return(instance);
+      }
+
+      bool     IsRunning() const;
+      void     Start(int threshold_ms = DEFAULT_THRESHOLD_MS, int interval_ms = DEFAULT_INTERVAL_MS);
+      quint64  StallCount() const;
+      void     Stop();
+
+      static const QString LOG;
+      static const int     DEFAULT_THRESHOLD_MS = 250;
+      static const int     DEFAULT_INTERVAL_MS = 100;
+
+   protected:
+      void customEvent(QEvent *event) override;
+
+   private:
+      class WatchThread : public QThread
+      {
+      public:
+         WatchThread(StallDetector *detector) : m_detector(detector) {}
+
+      protected:
+         void run() override
+         {
+            m_detector->WatchLoop();
+         }
+
+      private:
+         StallDetector  *m_detector;
+      };
+
+      StallDetector();
+
+      void WatchLoop();
+
+      WatchThread                *m_watcher;
+      int                         m_thresholdMs;
+      int                         m_intervalMs;
+      bool                        m_stop;
+      quint64                     m_servicedSeq;
+      qint64                      m_servicedNs;
+      std::atomic<quint64>        m_stalls;
+      std::atomic<ScopeStack*>    m_guiStack;
+      QMutex                      m_wakeLock;
+      QWaitCondition              m_wakeCondition;
+
+      static const QEvent::Type  HEARTBEAT_EVENT;
+   };
+}
+
+#endif
@@ -0,0 +1,101 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+# include "StructuredLog.h"
+# include "Logger.h"
+
+# include <QDateTime>
+
+using namespace QcjLib;
+
+LogEvent::LogEvent(const LogHandle &handle, QtMsgType type, const char *format, const char *function) :
+   m_descriptor(handle.Descriptor()),
+   m_key(NULL)
+{
+   LogDescriptor *descr = m_descriptor;
+
+   m_rec.type = type;
+   m_rec.level = handle.Level();
+   m_rec.sinks = descr->sinks.load(std::memory_order_relaxed);
+   m_rec.category = descr->name;
+   m_rec.function = QByteArray::fromRawData(function, qstrlen(function));   /* Q_FUNC_INFO, static */
+   m_rec.format = format;
+   m_rec.threadId = Logger::CurrentThreadId();
+   m_rec.timestamp = QDateTime::currentMSecsSinceEpoch();
+   m_rec.monotonic = Logger::MonotonicNs();
+}
+
+LogEvent::~LogEvent()
+{
+   Logger *logger = Logger::instance();
+   logger->ReportSuppressed(m_descriptor, m_rec.monotonic);
+   logger->Submit(m_rec);
+}
+
+LogEvent &LogEvent::arg(double value)
+{
+   Append(LogArg::Double).d = value;
+   return(*this);
+}
+
+LogEvent &LogEvent::arg(const QString &value)
+{
+   Append(LogArg::String).str = value;
+   return(*this);
+}
+
+LogEvent &LogEvent::arg(const void *value)
+{
+   Append(LogArg::Pointer).p = (quintptr)value;
+   return(*this);
+}
+
+LogEvent &LogEvent::AddInt(qint64 value)
+{
+   Append(LogArg::Int).i = value;
+   return(*this);
+}
+
+LogEvent &LogEvent::AddUInt(quint64 value)
+{
+   Append(LogArg::UInt).u = value;
+   return(*this);
+}
+
+/***********************************************/
+/*   Adds an argument, keyed if field() set a  */
+/*   key for it.                               */
+/***********************************************/
+LogArg &LogEvent::Append(LogArg::Type type)
+{
+   m_rec.args.append(LogArg());
+   LogArg &rv = m_rec.args.last();
+   rv.type = type;
+   rv.key = m_key;
+   m_key = NULL;
+   return(rv);
+}
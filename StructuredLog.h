@@ -0,0 +1,106 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef STRUCTUREDLOG_H
+#define STRUCTUREDLOG_H
+
+# include <QString>
+
+# include "LogHandle.h"
+# include "LogRecord.h"
+
+namespace QcjLib
+{
+   /********************************************************************//*
+   **   class LogEvent
+   **   
+   **   Builds  a  structured  LogRecord  and  hands it to the Logger
+   **   when  it  is  destroyed. Normally used through qcjLog() as a
+   **   temporary:
+   **   
+   **      qcjLog(LOG, 2, "Loaded %1 rows from %2")
+   **         .arg(rows).arg(table)
+   **         .field("table", table).field("elapsed_us", us);
+   **   
+   **   Arguments  are  stored  typed,  QStrings  by  sharing  their
+   **   data,  and  the  text  is  only  rendered  if a text sink wants
+   **   it.  format  and  field  keys  must  be  string literals or
+   **   otherwise never freed.
+   ***********************************************************************/
+   class LogEvent
+   {
+   public:
+      LogEvent(const LogHandle &handle, QtMsgType type, const char *format, const char *function);
+      ~LogEvent();
+
+      LogEvent &arg(int value)                  { return(AddInt(value)); }
+      LogEvent &arg(long value)                 { return(AddInt(value)); }
+      LogEvent &arg(long long value)            { return(AddInt(value)); }
+      LogEvent &arg(unsigned int value)         { return(AddUInt(value)); }
+      LogEvent &arg(unsigned long value)        { return(AddUInt(value)); }
+      LogEvent &arg(unsigned long long value)   { return(AddUInt(value)); }
+      LogEvent &arg(double value);
+      LogEvent &arg(const QString &value);
+      LogEvent &arg(const char *value)          { return(arg(QString::fromUtf8(value))); }
+      LogEvent &arg(const void *value);
+
+      template <typename T> LogEvent &field(const char *key, const T &value)
+      {
+         m_key = key;
+         return(arg(value));
+      }
+
+   private:
+      LogEvent &AddInt(qint64 value);
+      LogEvent &AddUInt(quint64 value);
+      LogArg   &Append(LogArg::Type type);
+
+      LogRecord      m_rec;
+      LogDescriptor *m_descriptor;
+      const char     *m_key;
+   };
+}
+
+/********************************************************************//*
+**   qcjLog(log_name, level, format)
+**   qcjWarning(log_name, level, format)
+**   
+**   Structured  counterparts  of  qcjDebug().  The  level checks,
+**   rate  limits  and  sink  selection  of  the  log  apply  as usual,
+**   and  neither  the  arguments  nor  the record are built when the
+**   log is not enabled at the given level or the message is
+**   suppressed.
+***********************************************************************/
+#define qcjLogType(log_name, level, type, format) \
+   for (const QcjLib::LogHandle *qcj_handle = &QCJ_LOG_HANDLE(log_name, level); \
+        qcj_handle != NULL && qcj_handle->IsEnabled() && qcj_handle->Admit(); qcj_handle = NULL) \
+      QcjLib::LogEvent(*qcj_handle, (type), (format), Q_FUNC_INFO)
+
+#define qcjLog(log_name, level, format)      qcjLogType(log_name, level, QtDebugMsg, format)
+#define qcjWarning(log_name, level, format)  qcjLogType(log_name, level, QtWarningMsg, format)
+
+#endif
@@ -58,7 +58,7 @@ void TableView::setFields(int row)
       /*******************************************************************/
       if ( ! m_haveDelegates)
       {
-         qDebug(*log(LOG, 1)) << "Have field: " << field.label;
+         qcjDebug(LOG, 1) << "Have field: " << field.label;
          if (field.widget != nullptr)
          {
             field.widget->hide();
@@ -78,7 +78,7 @@ void TableView::setFields(int row)
       }
       if (model_ptr != nullptr && field.dataName != "--ENDOFFIELDS--")
       {
-         qDebug(*log(LOG, 1)) << "Adding column label: " << field.label
+         qcjDebug(LOG, 1) << "Adding column label: " << field.label
                               << ", dataName: " << field.dataName;
          if (row == 0)
          {
@@ -89,10 +89,10 @@ void TableView::setFields(int row)
          if (defaultValue.startsWith("config:"))
          {
             QStringList sl = defaultValue.split(":");
-            qDebug(*log(LOG, 1)) << "Using setting " << sl[1];
+            qcjDebug(LOG, 1) << "Using setting " << sl[1];
             defaultValue = pConfig->value(sl[1], QVariant("")).toString();
          }
-         qDebug(*log(LOG, 1)) << "Setting default value for " << field.label << ": " << defaultValue;
+         qcjDebug(LOG, 1) << "Setting default value for " << field.label << ": " << defaultValue;
          model_ptr->SetValue(row, field.label, defaultValue);
       }
       column++;
@@ -92,7 +92,7 @@ namespace QcjLib
             }
             m_sortColumn = column; 
             tbl_model->sort(m_sortColumn, m_sortOrder);
-            qDebug(*log(LOG, 1)) << __FUNCTION__ << "current index row: " << currentIndex().row() << ", col: " << currentIndex().column();
+            qcjDebug(LOG, 1) << __FUNCTION__ << "current index row: " << currentIndex().row() << ", col: " << currentIndex().column();
          }
       }
 
@@ -101,10 +101,10 @@ namespace QcjLib
    protected:
       void currentChanged(const QModelIndex &current, const QModelIndex &previous)
       {
-         qDebug(*log(LOG, 1)) << "TableView::currentChanged(): Enter...";
+         qcjDebug(LOG, 1) << "TableView::currentChanged(): Enter...";
          QTableView::currentChanged(current, previous);
          emit clicked(current);
-         qDebug(*log(LOG, 1)) << "TableView::currentChanged(): Exit";
+         qcjDebug(LOG, 1) << "TableView::currentChanged(): Exit";
       };
 
       bool focusInEvent(QEvent *evt);
@@ -114,7 +114,7 @@ namespace QcjLib
    protected slots:
       void SlotSectionClicked(int logicalSection)
       {
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << "have click on logical section " << logicalSection;
+         qcjDebug(LOG, 1) << __FUNCTION__ << "have click on logical section " << logicalSection;
          SetSortColumn(logicalSection);
       }
 
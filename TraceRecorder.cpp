@@ -0,0 +1,336 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+# include "TraceRecorder.h"
+# include "Logger.h"
+
+# include <QCoreApplication>
+# include <QFile>
+# include <QHash>
+# include <QMutex>
+# include <QMutexLocker>
+# include <QThread>
+# include <QVector>
+
+using namespace QcjLib;
+
+const qint64 TraceRecorder::DEFAULT_BUDGET = 64 * 1024 * 1024;
+
+std::atomic<bool> TraceRecorder::s_enabled(false);
+
+namespace
+{
+   struct TraceThreadBuffer
+   {
+      QMutex               lock;
+      QVector<TraceEvent>  events;
+   };
+
+   struct TraceState
+   {
+      QMutex                        lock;
+      QVector<TraceThreadBuffer*>   buffers;
+      QVector<TraceThreadBuffer*>   freeBuffers;
+      QHash<quint32, QString>       threadNames;
+      std::atomic<qint64>           used;
+      std::atomic<qint64>           budget;
+      std::atomic<quint64>          dropped;
+      std::atomic<qint64>           origin;
+
+      TraceState() :
+         used(0),
+         budget(TraceRecorder::DEFAULT_BUDGET),
+         dropped(0),
+         origin(0)
+      {
+      }
+   };
+
+   TraceState &State()
+   {
+      static TraceState state;
+      return(state);
+   }
+
+   /***********************************************/
+   /*   Hands a thread's buffer back when the     */
+   /*   thread exits, its events stay in the      */
+   /*   buffer until Clear().                     */
+   /***********************************************/
+   struct TraceBufferOwner
+   {
+      TraceThreadBuffer *buffer = NULL;
+
+      ~TraceBufferOwner()
+      {
+         if ( buffer != NULL ) 
+         {
+            QMutexLocker locker(&State().lock);
+            State().freeBuffers.append(buffer);
+         }
+      }
+   };
+
+   thread_local TraceThreadBuffer  *t_buffer = NULL;
+   thread_local TraceBufferOwner    t_owner;
+
+   TraceThreadBuffer *ThreadBuffer()
+   {
+      if ( t_buffer == NULL ) 
+      {
+         QMutexLocker locker(&State().lock);
+         if ( State().freeBuffers.isEmpty() ) 
+         {
+            t_buffer = new TraceThreadBuffer();
+            State().buffers.append(t_buffer);
+         }
+         else 
+         {
+            t_buffer = State().freeBuffers.takeLast();
+         }
+         t_owner.buffer = t_buffer;
+
+         quint32 tid = Logger::CurrentThreadId();
+         QString name = QThread::currentThread()->objectName();
+         if ( QCoreApplication::instance() != NULL && 
+              QThread::currentThread() == QCoreApplication::instance()->thread() ) 
+            name = "GUI";
+         else if ( name.isEmpty() ) 
+            name = QString("Thread %1").arg(tid);
+         State().threadNames.insert(tid, name);
+      }
+      return(t_buffer);
+   }
+
+   void AppendJsonString(QByteArray &out, const QByteArray &str)
+   {
+      out += '"';
+      for (int x = 0; x < str.size(); x++) 
+      {
+         char ch = str.at(x);
+         if ( ch == '"' || ch == '\\' ) 
+         {
+            out += '\\';
+            out += ch;
+         }
+         else if ( (unsigned char)ch < 0x20 ) 
+            out += QByteArray("\\u00") + QByteArray::number((int)ch, 16).rightJustified(2, '0');
+         else
+            out += ch;
+      }
+      out += '"';
+   }
+}
+
+/********************************************************************//*
+**   bool TraceRecorder::Begin(const char *name, int line)
+**   bool TraceRecorder::Begin(const QString &name, int line)
+**   
+**   Records  the begin of a scope on the calling thread. Room for
+**   the  matching  end event is reserved at the same time so every
+**   begin recorded gets its end.
+**   
+**   Returns  false  if recording is off or the budget is used up,
+**   in which case End() must not be called for the scope.
+***********************************************************************/
+bool TraceRecorder::Begin(const char *name, int line)
+{
+   TraceEvent event = { 0, name, QString(), line, 0, 'B' };
+   return(Append(event));
+}
+
+bool TraceRecorder::Begin(const QString &name, int line)
+{
+   TraceEvent event = { 0, NULL, name, line, 0, 'B' };
+   return(Append(event));
+}
+
+/********************************************************************//*
+**   void TraceRecorder::End()
+**   
+**   Records the end of the innermost open scope on the calling
+**   thread.
+***********************************************************************/
+void TraceRecorder::End()
+{
+   TraceThreadBuffer *buffer = ThreadBuffer();
+   TraceEvent event = { Logger::MonotonicNs(), NULL, QString(), 0, Logger::CurrentThreadId(), 'E' };
+
+   QMutexLocker locker(&buffer->lock);
+   buffer->events.append(event);
+}
+
+bool TraceRecorder::Append(TraceEvent &event)
+{
+   bool rv = false;
+   const qint64 pair_size = 2 * sizeof(TraceEvent);
+
+   if ( IsEnabled() ) 
+   {
+      if ( State().used.fetch_add(pair_size, std::memory_order_relaxed) + pair_size <= 
+           State().budget.load(std::memory_order_relaxed) ) 
+      {
+         TraceThreadBuffer *buffer = ThreadBuffer();
+         event.timestamp = Logger::MonotonicNs();
+         event.threadId = Logger::CurrentThreadId();
+
+         QMutexLocker locker(&buffer->lock);
+         buffer->events.append(event);
+         rv = true;
+      }
+      else 
+      {
+         State().used.fetch_sub(pair_size, std::memory_order_relaxed);
+         State().dropped.fetch_add(1, std::memory_order_relaxed);
+      }
+   }
+   return(rv);
+}
+
+/********************************************************************//*
+**   void TraceRecorder::Start(qint64 budget_bytes)
+**   
+**   Starts  recording  with  at  most budget_bytes of events held.
+**   Events already recorded count against the budget.
+***********************************************************************/
+void TraceRecorder::Start(qint64 budget_bytes)
+{
+   State().budget.store(budget_bytes, std::memory_order_relaxed);
+   if ( State().origin.load(std::memory_order_relaxed) == 0 ) 
+      State().origin.store(Logger::MonotonicNs(), std::memory_order_relaxed);
+   s_enabled.store(true, std::memory_order_relaxed);
+}
+
+void TraceRecorder::Stop()
+{
+   s_enabled.store(false, std::memory_order_relaxed);
+}
+
+/********************************************************************//*
+**   void TraceRecorder::Clear()
+**   
+**   Discards  the  events  recorded. Scopes still open when it is
+**   called will record end events without a matching begin, the
+**   trace viewers ignore those.
+***********************************************************************/
+void TraceRecorder::Clear()
+{
+   QMutexLocker locker(&State().lock);
+
+   foreach (TraceThreadBuffer *buffer, State().buffers)
+   {
+      QMutexLocker buffer_locker(&buffer->lock);
+      buffer->events.clear();
+      buffer->events.squeeze();
+   }
+   State().used.store(0, std::memory_order_relaxed);
+   State().dropped.store(0, std::memory_order_relaxed);
+   State().origin.store(IsEnabled() ? Logger::MonotonicNs() : 0, std::memory_order_relaxed);
+}
+
+quint64 TraceRecorder::DroppedCount()
+{
+   return(State().dropped.load(std::memory_order_relaxed));
+}
+
+qint64 TraceRecorder::MemoryUsed()
+{
+   return(State().used.load(std::memory_order_relaxed));
+}
+
+/********************************************************************//*
+**   QByteArray TraceRecorder::ToJson()
+**   
+**   Returns  the  events  recorded in Chrome Trace Event format.
+**   Timestamps are in microseconds from when recording started.
+***********************************************************************/
+QByteArray TraceRecorder::ToJson()
+{
+   QByteArray rv;
+   QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+   qint64 origin = State().origin.load(std::memory_order_relaxed);
+   bool first = true;
+
+   rv += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+   QMutexLocker locker(&State().lock);
+   for (QHash<quint32, QString>::const_iterator it = State().threadNames.constBegin(); 
+        it != State().threadNames.constEnd(); ++it) 
+   {
+      if ( ! first ) 
+         rv += ",\n";
+      first = false;
+      rv += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + 
+            ",\"tid\":" + QByteArray::number(it.key()) + ",\"args\":{\"name\":";
+      AppendJsonString(rv, it.value().toUtf8());
+      rv += "}}";
+   }
+
+   foreach (TraceThreadBuffer *buffer, State().buffers)
+   {
+      QMutexLocker buffer_locker(&buffer->lock);
+      foreach (const TraceEvent &event, buffer->events)
+      {
+         if ( ! first ) 
+            rv += ",\n";
+         first = false;
+         rv += "{\"ph\":\"";
+         rv += event.phase;
+         rv += "\",\"ts\":" + QByteArray::number((event.timestamp - origin) / 1000.0, 'f', 3) +
+               ",\"pid\":" + pid + ",\"tid\":" + QByteArray::number(event.threadId);
+         if ( event.phase == 'B' ) 
+         {
+            rv += ",\"cat\":\"DbgTimer\",\"name\":";
+            AppendJsonString(rv, event.name != NULL ? QByteArray(event.name) : event.dynamicName.toUtf8());
+            rv += ",\"args\":{\"line\":" + QByteArray::number(event.line) + "}";
+         }
+         rv += "}";
+      }
+   }
+   rv += "\n]}\n";
+   return(rv);
+}
+
+/********************************************************************//*
+**   bool TraceRecorder::Export(QString filename)
+**   
+**   Writes ToJson() to filename. Returns false if the file could
+**   not be written.
+***********************************************************************/
+bool TraceRecorder::Export(QString filename)
+{
+   bool rv = false;
+   QFile file(filename);
+
+   if ( file.open(QIODevice::WriteOnly | QIODevice::Truncate) ) 
+   {
+      QByteArray json = ToJson();
+      rv = file.write(json) == json.size();
+      file.close();
+   }
+   return(rv);
+}
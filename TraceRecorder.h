@@ -0,0 +1,88 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+# include <QByteArray>
+# include <QString>
+
+# include <atomic>
+
+namespace QcjLib
+{
+   struct TraceEvent
+   {
+      qint64      timestamp;     // Logger::MonotonicNs()
+      const char *name;
+      QString     dynamicName;
+      int         line;
+      quint32     threadId;
+      char        phase;         // 'B'egin or 'E'nd
+   };
+
+   /********************************************************************//*
+   **   class TraceRecorder
+   **   
+   **   Records  the  begin  and  end  of  DbgTimer  scopes  into  a
+   **   buffer  per  thread  so  they can be exported as Chrome Trace
+   **   Event JSON, which chrome://tracing and Perfetto can load.
+   **
+   **   Recording  is  switched on and off at runtime with Start()
+   **   and  Stop().  While it is off the only cost to a DbgTimer is
+   **   the  IsEnabled() test. While it is on, no more events are
+   **   recorded once the memory budget given to Start() is used up.
+   ***********************************************************************/
+   class TraceRecorder
+   {
+   public:
+      static bool IsEnabled()
+      {
+         return(s_enabled.load(std::memory_order_relaxed));
+      }
+
+      static bool       Begin(const char *name, int line);
+      static bool       Begin(const QString &name, int line);
+      static void       Clear();
+      static quint64    DroppedCount();
+      static void       End();
+      static bool       Export(QString filename);
+      static qint64     MemoryUsed();
+      static void       Start(qint64 budget_bytes = DEFAULT_BUDGET);
+      static void       Stop();
+      static QByteArray ToJson();
+
+      static const qint64  DEFAULT_BUDGET;
+
+   private:
+      static bool Append(TraceEvent &event);
+
+      static std::atomic<bool>   s_enabled;
+   };
+}
+
+#endif
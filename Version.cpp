@@ -150,7 +150,7 @@ QString Version::GetShortVersionNumber()
 ******************************************************************************/
 void Version::ParseVersionControlStrings()
 {
-   qDebug(*log(LOG, 1)) << __FUNCTION__ << "Enter- m_Parsed = " << m_Parsed;
+   qcjDebug(LOG, 1) << __FUNCTION__ << "Enter- m_Parsed = " << m_Parsed;
    if ( ! m_Parsed ) 
    {
       m_Name.clear();
@@ -166,8 +166,8 @@ void Version::ParseVersionControlStrings()
       {
          QString rev_str = m_CmPath;
 
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << "m_PathREStr = " << m_PathREStr;
-         qDebug(*log(LOG, 1)) << __FUNCTION__ << "rev_str     = " << rev_str;
+         qcjDebug(LOG, 1) << __FUNCTION__ << "m_PathREStr = " << m_PathREStr;
+         qcjDebug(LOG, 1) << __FUNCTION__ << "rev_str     = " << rev_str;
 
          QRegExp re1(m_PathREStr);
          re1.setMinimal(true);
@@ -175,7 +175,7 @@ void Version::ParseVersionControlStrings()
          if ( re1.indexIn(rev_str) >= 0 )
          {
             QString temp1 = re1.cap(1);
-            qDebug(*log(LOG, 1)) << __FUNCTION__ << "MATCH!!!!  temp1: " << temp1 << ", rev_str: " << rev_str;
+            qcjDebug(LOG, 1) << __FUNCTION__ << "MATCH!!!!  temp1: " << temp1 << ", rev_str: " << rev_str;
 
             /***********************************************/
             /*   Next, if it came from either branches or  */
@@ -187,7 +187,7 @@ void Version::ParseVersionControlStrings()
             {
                QString type = rs[0];
                m_Name = rs[1];
-               qDebug(*log(LOG, 1)) << __FUNCTION__ << "MATCH!!!!  type: " << type << ", m_Name: " << m_Name;
+               qcjDebug(LOG, 1) << __FUNCTION__ << "MATCH!!!!  type: " << type << ", m_Name: " << m_Name;
                if ( type.toLower() == "branches") 
                {
                   m_Type = "Branch";
@@ -241,7 +241,7 @@ void Version::ParseVersionControlStrings()
          /***********************************************/
          else 
          {
-            qDebug(*log(LOG, 1)) << __FUNCTION__ << "NO match!!!!  rev_str: " << rev_str;
+            qcjDebug(LOG, 1) << __FUNCTION__ << "NO match!!!!  rev_str: " << rev_str;
          }   
       }
       if ( ! m_Revision.isEmpty() && ! m_RevREStr.isEmpty() ) 
@@ -252,12 +252,12 @@ void Version::ParseVersionControlStrings()
          if ( re1.indexIn(m_Revision) >= 0 )
          {
             m_Revision = re1.cap(1);
-            qDebug(*log(LOG, 1)) << __FUNCTION__ << "MATCH!!!! m_Revision: " << m_Revision;
+            qcjDebug(LOG, 1) << __FUNCTION__ << "MATCH!!!! m_Revision: " << m_Revision;
          }
          else 
          {
-            qDebug(*log(LOG, 1)) << __FUNCTION__ << "NO MATCH!!!! m_RevREStr: " << m_RevREStr;
-            qDebug(*log(LOG, 1)) << __FUNCTION__ << "             m_Revision: " << m_Revision;
+            qcjDebug(LOG, 1) << __FUNCTION__ << "NO MATCH!!!! m_RevREStr: " << m_RevREStr;
+            qcjDebug(LOG, 1) << __FUNCTION__ << "             m_Revision: " << m_Revision;
          }
       }
       m_Parsed = true;
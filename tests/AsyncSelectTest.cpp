@@ -0,0 +1,246 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+/********************************************************************//*
+**   @file AsyncSelectTest.cpp
+**   
+**   PROJECT QcjLib
+**   
+**   Description:  Runs  a  query  of  about  five  seconds  through
+**   SqlSortableTableModel  in  async  mode  against  an  SQLite
+**   database  and  checks  that  the  thread running the event loop
+**   keeps  handling  a 10 ms timer the whole time. The same query,
+**   shortened, is run synchronously for comparison.
+**
+**   Usage: AsyncSelectTest [QtTest options]
+***********************************************************************/
+# include "../SqlSortableTableModel.h"
+
+# include <QElapsedTimer>
+# include <QSignalSpy>
+# include <QSqlDatabase>
+# include <QSqlQuery>
+# include <QTemporaryDir>
+# include <QTimer>
+# include <QtTest>
+
+using namespace QcjLib;
+
+static const QString CONNECTION("QcjLib_async_test");
+static const qint64  SLOW_QUERY_MS = 5000;
+static const int     TICK_MS = 10;
+static const qint64  MAX_TICK_GAP_MS = 250;
+
+/********************************************************************//*
+**   class TickMonitor
+**   
+**   Notes  the  longest  gap  between  two timeouts of a short timer,
+**   which is how long the event loop was kept from running.
+***********************************************************************/
+class TickMonitor : public QObject
+{
+   Q_OBJECT
+
+public:
+   TickMonitor() :
+      m_ticks(0),
+      m_maxGap(0)
+   {
+      connect(&m_timer, SIGNAL(timeout()), this, SLOT(SlotTick()));
+   }
+
+   void Start()
+   {
+      m_ticks = 0;
+      m_maxGap = 0;
+      m_clock.start();
+      m_last = 0;
+      m_timer.start(TICK_MS);
+   }
+
+   void Stop()
+   {
+      m_timer.stop();
+      m_maxGap = qMax(m_maxGap, m_clock.elapsed() - m_last);
+   }
+
+   int      m_ticks;
+   qint64   m_maxGap;
+
+protected slots:
+   void SlotTick()
+   {
+      qint64 now = m_clock.elapsed();
+      m_maxGap = qMax(m_maxGap, now - m_last);
+      m_last = now;
+      m_ticks++;
+   }
+
+private:
+   QTimer         m_timer;
+   QElapsedTimer  m_clock;
+   qint64         m_last;
+};
+
+class AsyncSelectTest : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void initTestCase();
+   void cleanupTestCase();
+   void asyncSelectKeepsLoopResponsive();
+   void syncSelectBlocksLoop();
+   void asyncSelectOnDefaultConnection();
+
+private:
+   QString SlowQuery(qint64 ms) const;
+   QString CountQuery(qint64 rows) const;
+
+   QTemporaryDir  m_dir;
+   double         m_rowsPerMs;
+};
+
+/********************************************************************//*
+**   The  slow  query  is  a  recursive  count,  its length is measured
+**   here  so  the  query  takes  about  SLOW_QUERY_MS  on  this machine.
+***********************************************************************/
+void AsyncSelectTest::initTestCase()
+{
+   const qint64 sample = 1000000;
+
+   QVERIFY(m_dir.isValid());
+
+   QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", CONNECTION);
+   db.setDatabaseName(m_dir.filePath("async.db"));
+   QVERIFY(db.open());
+
+   QElapsedTimer timer;
+   QSqlQuery q1(db);
+   timer.start();
+   QVERIFY(q1.exec(CountQuery(sample)));
+   QVERIFY(q1.next());
+   QCOMPARE(q1.value(0).toLongLong(), sample);
+   m_rowsPerMs = (double)sample / qMax(timer.elapsed(), (qint64)1);
+}
+
+void AsyncSelectTest::cleanupTestCase()
+{
+   QSqlDatabase::database(CONNECTION).close();
+   QSqlDatabase::removeDatabase(CONNECTION);
+}
+
+QString AsyncSelectTest::SlowQuery(qint64 ms) const
+{
+   return(CountQuery(qMax((qint64)(ms * m_rowsPerMs), (qint64)1)));
+}
+
+QString AsyncSelectTest::CountQuery(qint64 rows) const
+{
+   return(QString("with recursive c(x) as (select 1 union all select x + 1 from c where x < %1) "
+                  "select max(x) as last from c").arg(rows));
+}
+
+void AsyncSelectTest::asyncSelectKeepsLoopResponsive()
+{
+   SqlSortableTableModel model;
+   QSignalSpy finished(&model, SIGNAL(SelectFinished(bool, QString)));
+   TickMonitor monitor;
+   QElapsedTimer timer;
+
+   model.SetAsync(true);
+   monitor.Start();
+   timer.start();
+   model.SetQuery(SlowQuery(SLOW_QUERY_MS), QSqlDatabase::database(CONNECTION));
+   qint64 call_ms = timer.elapsed();
+
+   QVERIFY(finished.wait(SLOW_QUERY_MS * 6));
+   qint64 total_ms = timer.elapsed();
+   monitor.Stop();
+
+   qDebug() << "select() returned after" << call_ms << "ms, query took" << total_ms << "ms,"
+            << monitor.m_ticks << "ticks, longest gap" << monitor.m_maxGap << "ms";
+   QVERIFY(finished.first().at(0).toBool());
+   QCOMPARE(model.rowCount(), 1);
+   QVERIFY(total_ms >= SLOW_QUERY_MS / 4);
+   QVERIFY(call_ms < MAX_TICK_GAP_MS);
+   QVERIFY(monitor.m_maxGap < MAX_TICK_GAP_MS);
+   QVERIFY(monitor.m_ticks >= total_ms / TICK_MS / 4);
+}
+
+/********************************************************************//*
+**   Before:  the  same  query,  a  fifth  as  long,  run on the event
+**   loop's thread. No timer is handled until it returns.
+***********************************************************************/
+void AsyncSelectTest::syncSelectBlocksLoop()
+{
+   SqlSortableTableModel model;
+   TickMonitor monitor;
+   QElapsedTimer timer;
+
+   monitor.Start();
+   timer.start();
+   model.SetQuery(SlowQuery(SLOW_QUERY_MS / 5), QSqlDatabase::database(CONNECTION));
+   qint64 call_ms = timer.elapsed();
+   QCoreApplication::processEvents();
+   monitor.Stop();
+
+   qDebug() << "select() returned after" << call_ms << "ms, longest gap" << monitor.m_maxGap << "ms";
+   QCOMPARE(model.rowCount(), 1);
+   QVERIFY(monitor.m_maxGap >= call_ms);
+}
+
+/********************************************************************//*
+**   SetQuery()  without  a database runs on the default connection,
+**   the worker has to clone that one.
+***********************************************************************/
+void AsyncSelectTest::asyncSelectOnDefaultConnection()
+{
+   {
+      QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
+      db.setDatabaseName(m_dir.filePath("async.db"));
+      QVERIFY(db.open());
+   }
+
+   {
+      SqlSortableTableModel model;
+      QSignalSpy finished(&model, SIGNAL(SelectFinished(bool, QString)));
+
+      model.SetAsync(true);
+      model.SetQuery(CountQuery(1000));
+      QVERIFY(finished.wait(10000));
+      QVERIFY2(finished.first().at(0).toBool(), qPrintable(finished.first().at(1).toString()));
+      QCOMPARE(model.rowCount(), 1);
+      QCOMPARE(model.data(model.index(0, 0)).toInt(), 1000);
+   }
+
+   QSqlDatabase::database().close();
+   QSqlDatabase::removeDatabase(QSqlDatabase::defaultConnection);
+}
+
+QTEST_GUILESS_MAIN(AsyncSelectTest)
+# include "AsyncSelectTest.moc"
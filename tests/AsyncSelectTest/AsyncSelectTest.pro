@@ -0,0 +1,4 @@
+TARGET = AsyncSelectTest
+SOURCES = ../AsyncSelectTest.cpp
+
+include(../tests.pri)
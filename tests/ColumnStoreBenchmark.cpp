@@ -0,0 +1,255 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+/********************************************************************//*
+**   @file ColumnStoreBenchmark.cpp
+**   
+**   PROJECT QcjLib
+**   
+**   Description:  Loads  a  500000  row  SQLite  report  into  a
+**   SqlSortableTableModel  kept  by  QSqlQueryModel  and  into  one
+**   in  columnar  mode,  reports  the  memory  each  takes  and
+**   benchmarks  scrolling  through  every  row  with data() and a
+**   local sort on a real and on a text column.
+**
+**   The  resident  size  is  read  from /proc, so the memory figures
+**   are  only  reported  on  Linux.  The  columnar  model is loaded
+**   first  so  the  other  one  can  not  reuse  memory  it  freed.
+**
+**   Usage: ColumnStoreBenchmark [QtTest options]
+***********************************************************************/
+# include "../MetricBuilder.h"
+# include "../SqlSortableTableModel.h"
+
+# include <QFile>
+# include <QSqlDatabase>
+# include <QSqlQuery>
+# include <QTemporaryDir>
+# include <QtTest>
+
+# ifdef Q_OS_LINUX
+#  include <unistd.h>
+# endif
+
+using namespace QcjLib;
+
+static const QString CONNECTION("QcjLib_column_store_test");
+static const QString QUERY("select id, customer, amount, placed, note from report");
+static const int     FIXTURE_ROWS = 500000;
+
+namespace
+{
+   /***********************************************/
+   /*   Resident set size in bytes, or -1 where   */
+   /*   it can not be read.                       */
+   /***********************************************/
+   qint64 ResidentBytes()
+   {
+      qint64 rv = -1;
+# ifdef Q_OS_LINUX
+      QFile statm("/proc/self/statm");
+      if ( statm.open(QIODevice::ReadOnly) ) 
+      {
+         QList<QByteArray> fields = statm.readAll().split(' ');
+         if ( fields.count() > 1 ) 
+            rv = fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+      }
+# endif
+      return(rv);
+   }
+}
+
+class ColumnStoreBenchmark : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void initTestCase();
+   void cleanupTestCase();
+   void memoryColumnar();
+   void memoryDefault();
+   void scrollDefault();
+   void scrollColumnar();
+   void sortRealDefault();
+   void sortRealColumnar();
+   void sortTextDefault();
+   void sortTextColumnar();
+
+private:
+   SqlSortableTableModel *Model(bool columnar);
+   void Scroll(SqlSortableTableModel *model);
+   void Sort(SqlSortableTableModel *model, const QString &column);
+
+   QTemporaryDir           m_dir;
+   SqlSortableTableModel   *m_default;
+   SqlSortableTableModel   *m_columnar;
+};
+
+void ColumnStoreBenchmark::initTestCase()
+{
+   m_default = NULL;
+   m_columnar = NULL;
+   QVERIFY(m_dir.isValid());
+
+   QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", CONNECTION);
+   db.setDatabaseName(m_dir.filePath("report.db"));
+   QVERIFY(db.open());
+
+   QSqlQuery q1(db);
+   QVERIFY(q1.exec("create table report (id integer primary key, customer text, amount real, "
+                   "placed integer, note text)"));
+   QVERIFY(q1.exec(QString("with recursive c(x) as (select 1 union all select x + 1 from c where x < %1) "
+                           "insert into report (customer, amount, placed, note) "
+                           "select 'customer ' || (x * 7919 % 9973), (x * 104729 % 1000000) / 100.0, "
+                           "1700000000 + x * 61, case when x % 10 = 0 then null else 'note ' || (x % 1000) end "
+                           "from c").arg(FIXTURE_ROWS)));
+}
+
+void ColumnStoreBenchmark::cleanupTestCase()
+{
+   delete m_default;
+   delete m_columnar;
+   QSqlDatabase::database(CONNECTION).close();
+   QSqlDatabase::removeDatabase(CONNECTION);
+}
+
+/********************************************************************//*
+**   Returns  the  model  of  the  kind  asked  for  with every row
+**   loaded, loading it the first time.
+***********************************************************************/
+SqlSortableTableModel *ColumnStoreBenchmark::Model(bool columnar)
+{
+   SqlSortableTableModel *&rv = columnar ? m_columnar : m_default;
+
+   if ( rv == NULL ) 
+   {
+      rv = new SqlSortableTableModel();
+      rv->setObjectName(columnar ? "columnar" : "default");
+      rv->SetColumnar(columnar);
+      rv->SetQuery(QUERY, QSqlDatabase::database(CONNECTION));
+      while ( rv->canFetchMore() ) 
+      {
+         rv->fetchMore();
+      }
+   }
+   return(rv);
+}
+
+void ColumnStoreBenchmark::memoryColumnar()
+{
+   qint64 before = ResidentBytes();
+   SqlSortableTableModel *model = Model(true);
+   qint64 after = ResidentBytes();
+   QCOMPARE(model->rowCount(), FIXTURE_ROWS);
+
+   MetricGauge store("qcjlib_model_store_bytes", QString(), "model=\"QcjLib::SqlSortableTableModel:columnar\"");
+   qDebug() << "column store:" << store.Value() << "bytes," << (double)store.Value() / FIXTURE_ROWS << "per row";
+   if ( before >= 0 ) 
+      qDebug() << "resident growth:" << after - before << "bytes," << (double)(after - before) / FIXTURE_ROWS << "per row";
+}
+
+void ColumnStoreBenchmark::memoryDefault()
+{
+   qint64 before = ResidentBytes();
+   SqlSortableTableModel *model = Model(false);
+   qint64 after = ResidentBytes();
+   QCOMPARE(model->rowCount(), FIXTURE_ROWS);
+
+   if ( before < 0 ) 
+      QSKIP("The resident size can only be read on Linux");
+   qDebug() << "resident growth:" << after - before << "bytes," << (double)(after - before) / FIXTURE_ROWS << "per row";
+}
+
+/********************************************************************//*
+**   Reads  every  cell  the  way  a  view  does  while  scrolling from
+**   the top to the bottom.
+***********************************************************************/
+void ColumnStoreBenchmark::Scroll(SqlSortableTableModel *model)
+{
+   int rows = model->rowCount();
+   int columns = model->columnCount();
+   qint64 chars = 0;
+
+   QBENCHMARK
+   {
+      for (int row = 0; row < rows; row++) 
+      {
+         for (int column = 0; column < columns; column++) 
+         {
+            chars += model->data(model->index(row, column)).toString().size();
+         }
+      }
+   }
+   QVERIFY(chars > 0);
+}
+
+void ColumnStoreBenchmark::scrollDefault()
+{
+   Scroll(Model(false));
+}
+
+void ColumnStoreBenchmark::scrollColumnar()
+{
+   Scroll(Model(true));
+}
+
+/********************************************************************//*
+**   Each  pass  flips  the  direction  of  column,  so  every pass is
+**   a full sort.
+***********************************************************************/
+void ColumnStoreBenchmark::Sort(SqlSortableTableModel *model, const QString &column)
+{
+   model->ClearOrder();
+   QBENCHMARK
+   {
+      model->SetOrder(column);
+      QVERIFY(model->SortLocally());
+   }
+}
+
+void ColumnStoreBenchmark::sortRealDefault()
+{
+   Sort(Model(false), "amount");
+}
+
+void ColumnStoreBenchmark::sortRealColumnar()
+{
+   Sort(Model(true), "amount");
+}
+
+void ColumnStoreBenchmark::sortTextDefault()
+{
+   Sort(Model(false), "customer");
+}
+
+void ColumnStoreBenchmark::sortTextColumnar()
+{
+   Sort(Model(true), "customer");
+}
+
+QTEST_GUILESS_MAIN(ColumnStoreBenchmark)
+# include "ColumnStoreBenchmark.moc"
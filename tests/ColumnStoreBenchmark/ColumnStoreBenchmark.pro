@@ -0,0 +1,7 @@
+TARGET = ColumnStoreBenchmark
+SOURCES = ../ColumnStoreBenchmark.cpp
+
+include(../tests.pri)
+
+# Too slow for make check, run it by hand
+CONFIG -= testcase
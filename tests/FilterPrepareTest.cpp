@@ -0,0 +1,194 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+/********************************************************************//*
+**   @file FilterPrepareTest.cpp
+**   
+**   PROJECT QcjLib
+**   
+**   Description:  Changes  the  filter of a SqlSortableTableModel
+**   1000  times  against  an SQLite fixture and counts the statements
+**   prepared,  with  the  values  pasted  into the where text and with
+**   a  SqlFilter  binding them, then benchmarks a filter change both
+**   ways.
+**
+**   Usage: FilterPrepareTest [QtTest options]
+***********************************************************************/
+# include "../MetricBuilder.h"
+# include "../SqlFilter.h"
+# include "../SqlSortableTableModel.h"
+
+# include <QSqlDatabase>
+# include <QSqlQuery>
+# include <QTemporaryDir>
+# include <QtTest>
+
+using namespace QcjLib;
+
+static const QString CONNECTION("QcjLib_filter_test");
+static const QString QUERY("select id, customer, amount from orders");
+static const int     FIXTURE_ROWS = 5000;
+static const int     FILTER_CHANGES = 1000;
+
+class FilterPrepareTest : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void initTestCase();
+   void cleanupTestCase();
+   void inlineFilterPrepares();
+   void boundFilterPrepares();
+   void filterChangeInline();
+   void filterChangeBound();
+
+private:
+   quint64 Prepares(const QString &model_name);
+   QString InlineWhere(int x);
+   SqlFilter BoundFilter(int x);
+
+   QTemporaryDir  m_dir;
+};
+
+void FilterPrepareTest::initTestCase()
+{
+   QVERIFY(m_dir.isValid());
+
+   QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", CONNECTION);
+   db.setDatabaseName(m_dir.filePath("filter.db"));
+   QVERIFY(db.open());
+
+   QSqlQuery q1(db);
+   QVERIFY(q1.exec("create table orders (id integer primary key, customer text, amount real)"));
+   QVERIFY(q1.exec("create index orders_customer_idx on orders (customer)"));
+   QVERIFY(q1.prepare("insert into orders (customer, amount) values (?, ?)"));
+
+   db.transaction();
+   for (int x = 0; x < FIXTURE_ROWS; x++) 
+   {
+      q1.bindValue(0, QString("customer %1").arg(x % 97));
+      q1.bindValue(1, (x * 7919) % 10000 / 100.0);
+      QVERIFY(q1.exec());
+   }
+   QVERIFY(db.commit());
+}
+
+void FilterPrepareTest::cleanupTestCase()
+{
+   QSqlDatabase::database(CONNECTION).close();
+   QSqlDatabase::removeDatabase(CONNECTION);
+}
+
+quint64 FilterPrepareTest::Prepares(const QString &model_name)
+{
+   QString labels = "model=\"QcjLib::SqlSortableTableModel:" + model_name + "\"";
+   return(MetricCounter("qcjlib_model_prepares_total", QString(), labels).Value());
+}
+
+QString FilterPrepareTest::InlineWhere(int x)
+{
+   return(QString("customer = 'customer %1' and amount > %2").arg(x % 97).arg(x % 100));
+}
+
+SqlFilter FilterPrepareTest::BoundFilter(int x)
+{
+   return(SqlFilter::Compare("customer", SqlFilter::Equal, QString("customer %1").arg(x % 97)) &&
+          SqlFilter::Compare("amount", SqlFilter::Greater, x % 100));
+}
+
+/********************************************************************//*
+**   Before:  every  value  makes  a  new  statement text, so nearly
+**   every change is prepared and planned again.
+***********************************************************************/
+void FilterPrepareTest::inlineFilterPrepares()
+{
+   SqlSortableTableModel model;
+   model.setObjectName("inline_filter");
+   model.SetQuery(QUERY, QSqlDatabase::database(CONNECTION));
+
+   quint64 prepares = Prepares("inline_filter");
+   for (int x = 0; x < FILTER_CHANGES; x++) 
+   {
+      model.SetFilter(InlineWhere(x));
+      model.select();
+   }
+   quint64 count = Prepares("inline_filter") - prepares;
+   qDebug() << FILTER_CHANGES << "inline filter changes:" << count << "prepares";
+   QVERIFY(count > (quint64)(FILTER_CHANGES / 2));
+}
+
+/********************************************************************//*
+**   After:  the  filter  keeps  its  shape,  only  the  bound  values
+**   change, so the statement is prepared once.
+***********************************************************************/
+void FilterPrepareTest::boundFilterPrepares()
+{
+   SqlSortableTableModel model;
+   model.setObjectName("bound_filter");
+   model.SetQuery(QUERY, QSqlDatabase::database(CONNECTION));
+
+   quint64 prepares = Prepares("bound_filter");
+   for (int x = 0; x < FILTER_CHANGES; x++) 
+   {
+      model.SetFilter(BoundFilter(x));
+      model.select();
+   }
+   quint64 count = Prepares("bound_filter") - prepares;
+   qDebug() << FILTER_CHANGES << "bound filter changes:" << count << "prepares";
+   QCOMPARE(count, (quint64)1);
+}
+
+void FilterPrepareTest::filterChangeInline()
+{
+   SqlSortableTableModel model;
+   model.setObjectName("inline_bench");
+   model.SetQuery(QUERY, QSqlDatabase::database(CONNECTION));
+   int x = 0;
+
+   QBENCHMARK
+   {
+      model.SetFilter(InlineWhere(x++));
+      model.select();
+   }
+}
+
+void FilterPrepareTest::filterChangeBound()
+{
+   SqlSortableTableModel model;
+   model.setObjectName("bound_bench");
+   model.SetQuery(QUERY, QSqlDatabase::database(CONNECTION));
+   int x = 0;
+
+   QBENCHMARK
+   {
+      model.SetFilter(BoundFilter(x++));
+      model.select();
+   }
+}
+
+QTEST_GUILESS_MAIN(FilterPrepareTest)
+# include "FilterPrepareTest.moc"
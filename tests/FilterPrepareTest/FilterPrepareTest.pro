@@ -0,0 +1,4 @@
+TARGET = FilterPrepareTest
+SOURCES = ../FilterPrepareTest.cpp
+
+include(../tests.pri)
@@ -0,0 +1,171 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+/********************************************************************//*
+**   @file LogLevelTest.cpp
+**   
+**   PROJECT QcjLib
+**   
+**   Description:  Checks  that  a  log's level is pushed into the
+**   enabled  state  of its Qt categories and stays there when Qt
+**   re-evaluates  its  filter  rules,  and  benchmarks the cost of a
+**   disabled  statement  with the old late filtering in the message
+**   handler against the level test of qcjDebug().
+**
+**   Usage: LogLevelTest [QtTest options]
+***********************************************************************/
+# include "../LogHandle.h"
+# include "../LogRegistery.h"
+
+# include <QLoggingCategory>
+# include <QStringList>
+# include <QtTest>
+
+using namespace QcjLib;
+
+static const QString TEST_LOG("QcjLib_test_level");
+
+namespace
+{
+   int   handled = 0;
+
+   /***********************************************/
+   /*   Stands in for myMessageOutput() dropping  */
+   /*   the message after Qt formatted it.        */
+   /***********************************************/
+   void CountingHandler(QtMsgType, const QMessageLogContext &, const QString &)
+   {
+      handled++;
+   }
+
+   QStringList Payload()
+   {
+      return(QStringList() << "alpha" << "beta" << "gamma" << "delta");
+   }
+}
+
+class LogLevelTest : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void initTestCase();
+   void cleanupTestCase();
+   void levelGatesCategory();
+   void gateSurvivesFilterRules();
+   void disabledBefore();
+   void disabledAfter();
+
+private:
+   QtMessageHandler  m_previous;
+};
+
+void LogLevelTest::initTestCase()
+{
+   LogRegistery::instance()->RegisterLog(TEST_LOG, 2, "Level test log");
+   LogRegistery::instance()->SetLogLevel(TEST_LOG, 1);
+   m_previous = qInstallMessageHandler(CountingHandler);
+}
+
+void LogLevelTest::cleanupTestCase()
+{
+   qInstallMessageHandler(m_previous);
+}
+
+void LogLevelTest::levelGatesCategory()
+{
+   LogRegistery::instance()->SetLogLevel(TEST_LOG, 1);
+   QVERIFY(QcjLib::log(TEST_LOG, 1)->isDebugEnabled());
+   QVERIFY(! QcjLib::log(TEST_LOG, 2)->isDebugEnabled());
+
+   LogRegistery::instance()->SetLogLevel(TEST_LOG, 2);
+   QVERIFY(QcjLib::log(TEST_LOG, 2)->isDebugEnabled());
+
+   LogRegistery::instance()->SetLogLevel(TEST_LOG, 1);
+   handled = 0;
+   qDebug(*QcjLib::log(TEST_LOG, 2)) << "dropped";
+   qDebug(*QcjLib::log(TEST_LOG, 1)) << "written";
+   QCOMPARE(handled, 1);
+}
+
+/********************************************************************//*
+**   Qt  recomputes  every  category  when  the  rules change, the
+**   registry's filter has to put the level back.
+***********************************************************************/
+void LogLevelTest::gateSurvivesFilterRules()
+{
+   LogRegistery::instance()->SetLogLevel(TEST_LOG, 1);
+   QLoggingCategory::setFilterRules("*.debug=true");
+   QVERIFY(! QcjLib::log(TEST_LOG, 2)->isDebugEnabled());
+
+   QLoggingCategory late("QcjLib_test_late_category");
+   QVERIFY(! QcjLib::log(TEST_LOG, 2)->isDebugEnabled());
+   QVERIFY(late.isDebugEnabled());
+   QLoggingCategory::setFilterRules(QString());
+}
+
+/********************************************************************//*
+**   Before:  the  category  is  enabled  in  Qt  and  the handler
+**   drops  the  message,  so  the stream arguments are formatted
+**   for nothing.
+***********************************************************************/
+void LogLevelTest::disabledBefore()
+{
+   QLoggingCategory category("QcjLib_test_before");
+   category.setEnabled(QtDebugMsg, true);
+   QStringList payload = Payload();
+   int x = 0;
+
+   QBENCHMARK
+   {
+      qDebug(category) << "row" << x++ << "of" << payload << QString::number(3.14159, 'f', 4);
+   }
+}
+
+/********************************************************************//*
+**   After:  qcjDebug()  tests  the  log's  level before building the
+**   QDebug,  so  none  of  the  stream arguments are evaluated. A
+**   plain  qDebug(category)  would  still  format them all and only
+**   skip the handler.
+***********************************************************************/
+void LogLevelTest::disabledAfter()
+{
+   LogRegistery::instance()->SetLogLevel(TEST_LOG, 1);
+   QStringList payload = Payload();
+   int x = 0;
+
+   handled = 0;
+   QBENCHMARK
+   {
+      qcjDebug(TEST_LOG, 2) << "row" << x++ << "of" << payload << QString::number(3.14159, 'f', 4);
+   }
+   QCOMPARE(handled, 0);
+   QCOMPARE(x, 0);
+}
+
+QTEST_MAIN(LogLevelTest)
+# include "LogLevelTest.moc"
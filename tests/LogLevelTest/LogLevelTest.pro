@@ -0,0 +1,4 @@
+TARGET = LogLevelTest
+SOURCES = ../LogLevelTest.cpp
+
+include(../tests.pri)
@@ -0,0 +1,195 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+/********************************************************************//*
+**   @file LogRegisteryStressTest.cpp
+**   
+**   PROJECT QcjLib
+**   
+**   Description:  Logs  from  several  threads  while  the  main
+**   thread  keeps  changing  the  levels,  limits  and  registering
+**   new  logs,  checking  that  readers  only  ever  see consistent
+**   snapshots.  Reports  the  messages  per second reached and
+**   benchmarks the lock free lookups.
+**
+**   Usage: LogRegisteryStressTest [QtTest options]
+***********************************************************************/
+# include "../LogHandle.h"
+# include "../LogRegistery.h"
+
+# include <QElapsedTimer>
+# include <QThread>
+# include <QVector>
+# include <QtTest>
+
+# include <atomic>
+
+using namespace QcjLib;
+
+static const QString STRESS_LOG("QcjLib_test_stress");
+
+namespace
+{
+   const int   THREADS = 8;
+   const int   RUN_MS = 3000;
+
+   std::atomic<quint64>  handled(0);
+   std::atomic<quint64>  foreign(0);
+
+   /***********************************************/
+   /*   Counts  messages and checks each came     */
+   /*   from a category the registry knows.       */
+   /***********************************************/
+   void CountingHandler(QtMsgType, const QMessageLogContext &context, const QString &)
+   {
+      if ( LogRegistery::instance()->CategoryInfo(context.category) != NULL ) 
+      {
+         handled.fetch_add(1, std::memory_order_relaxed);
+      }
+      else 
+      {
+         foreign.fetch_add(1, std::memory_order_relaxed);
+      }
+   }
+}
+
+class LogRegisteryStressTest : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void initTestCase();
+   void cleanupTestCase();
+   void logWhileToggling();
+   void levelLookup();
+   void handleCheck();
+
+private:
+   QtMessageHandler  m_previous;
+};
+
+void LogRegisteryStressTest::initTestCase()
+{
+   LogRegistery::instance()->RegisterLog(STRESS_LOG, 3, "Stress test log");
+   m_previous = qInstallMessageHandler(CountingHandler);
+}
+
+void LogRegisteryStressTest::cleanupTestCase()
+{
+   qInstallMessageHandler(m_previous);
+}
+
+void LogRegisteryStressTest::logWhileToggling()
+{
+   std::atomic<bool> stop(false);
+   std::atomic<quint64> checks(0);
+   std::atomic<quint64> errors(0);
+   QVector<QThread*> threads;
+
+   handled.store(0);
+   foreign.store(0);
+   for (int x = 0; x < THREADS; x++) 
+   {
+      threads.append(QThread::create([&stop, &checks, &errors]()
+      {
+         quint64 count = 0;
+         while ( ! stop.load(std::memory_order_relaxed) ) 
+         {
+            qcjDebug(STRESS_LOG, 1) << "level one" << count;
+            qcjDebug(STRESS_LOG, 3) << "level three" << count;
+            unsigned int level = LogRegistery::instance()->LogLevel(STRESS_LOG);
+            const LogCategoryInfo *info = LogRegistery::instance()->CategoryInfo(
+                                             LogRegistery::instance()->category(STRESS_LOG, 2)->categoryName());
+            if ( level < 1 || level > 3 || info == NULL || info->level != 2 ) 
+            {
+               errors.fetch_add(1);
+            }
+            count++;
+         }
+         checks.fetch_add(count);
+      }));
+      threads.last()->start();
+   }
+
+   QElapsedTimer timer;
+   int changes = 0;
+   timer.start();
+   while ( timer.elapsed() < RUN_MS ) 
+   {
+      LogRegistery::instance()->SetLogLevel(STRESS_LOG, (changes % 3) + 1);
+
+      LogLimitsMap_t limits;
+      limits[STRESS_LOG].sample = (changes % 2) ? 2 : 0;
+      LogRegistery::instance()->SetLogLimits(limits);
+
+      if ( changes % 50 == 0 ) 
+      {
+         LogRegistery::instance()->RegisterLog(STRESS_LOG + "_" + QString::number(changes), 2, "Stress test extra log");
+      }
+      changes++;
+      QThread::usleep(100);
+   }
+   stop.store(true);
+
+   foreach (QThread *thread, threads)
+   {
+      QVERIFY(thread->wait(10000));
+      delete thread;
+   }
+
+   double seconds = timer.elapsed() / 1000.0;
+   qInstallMessageHandler(m_previous);
+   qInfo("%d threads, %d level changes, %.0f checks/s, %.0f messages/s", 
+         THREADS, changes, checks.load() / seconds, handled.load() / seconds);
+   qInstallMessageHandler(CountingHandler);
+
+   QCOMPARE(errors.load(), (quint64)0);
+   QVERIFY(handled.load() > 0);
+   QCOMPARE(foreign.load(), (quint64)0);
+}
+
+void LogRegisteryStressTest::levelLookup()
+{
+   QBENCHMARK
+   {
+      LogRegistery::instance()->LogLevel(STRESS_LOG);
+   }
+}
+
+void LogRegisteryStressTest::handleCheck()
+{
+   LogRegistery::instance()->SetLogLevel(STRESS_LOG, 1);
+   handled.store(0);
+   QBENCHMARK
+   {
+      qcjDebug(STRESS_LOG, 3) << "never written";
+   }
+   QCOMPARE(handled.load(), (quint64)0);
+}
+
+QTEST_MAIN(LogRegisteryStressTest)
+# include "LogRegisteryStressTest.moc"
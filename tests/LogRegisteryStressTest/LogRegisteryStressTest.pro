@@ -0,0 +1,4 @@
+TARGET = LogRegisteryStressTest
+SOURCES = ../LogRegisteryStressTest.cpp
+
+include(../tests.pri)
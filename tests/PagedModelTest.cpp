@@ -0,0 +1,186 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+/********************************************************************//*
+**   @file PagedModelTest.cpp
+**   
+**   PROJECT QcjLib
+**   
+**   Description:  Pages  through  an  SQLite  table  whose sort column
+**   holds  NULLs  and  duplicates with SqlPagedTableModel, forwards
+**   and  backwards  in  both  directions,  and checks every row comes
+**   back  once,  in  the  order  the  database itself returns them.
+**   Also  checks  the  placeholders  filled  in  for  the  PostgreSQL
+**   planner estimate.
+**
+**   Usage: PagedModelTest [QtTest options]
+***********************************************************************/
+# include "../SqlPagedTableModel.h"
+
+# include <QSqlDatabase>
+# include <QSqlDriver>
+# include <QSqlQuery>
+# include <QTemporaryDir>
+# include <QtTest>
+
+using namespace QcjLib;
+
+static const QString CONNECTION("QcjLib_paged_test");
+static const QString QUERY("select id, amount from items");
+static const int     FIXTURE_ROWS = 2000;
+
+namespace
+{
+   class PagedModel : public SqlPagedTableModel
+   {
+   public:
+      using SqlPagedTableModel::InlineValues;
+   };
+}
+
+class PagedModelTest : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void initTestCase();
+   void cleanupTestCase();
+   void pageAcrossNulls_data();
+   void pageAcrossNulls();
+   void inlineValues();
+
+private:
+   QVector<int> Expected(bool descending);
+
+   QTemporaryDir  m_dir;
+};
+
+/********************************************************************//*
+**   A  third  of  the  amounts  are  NULL  and  the  rest  repeat, so
+**   page boundaries fall inside runs of equal keys and of NULLs.
+***********************************************************************/
+void PagedModelTest::initTestCase()
+{
+   QVERIFY(m_dir.isValid());
+
+   QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", CONNECTION);
+   db.setDatabaseName(m_dir.filePath("paged.db"));
+   QVERIFY(db.open());
+
+   QSqlQuery q1(db);
+   QVERIFY(q1.exec("create table items (id integer primary key, amount integer)"));
+   QVERIFY(q1.prepare("insert into items (id, amount) values (?, ?)"));
+
+   db.transaction();
+   for (int x = 1; x <= FIXTURE_ROWS; x++) 
+   {
+      q1.bindValue(0, x);
+      q1.bindValue(1, (x % 3 == 0) ? QVariant(QVariant::Int) : QVariant((x * 7) % 50));
+      QVERIFY(q1.exec());
+   }
+   QVERIFY(db.commit());
+}
+
+void PagedModelTest::cleanupTestCase()
+{
+   QSqlDatabase::database(CONNECTION).close();
+   QSqlDatabase::removeDatabase(CONNECTION);
+}
+
+QVector<int> PagedModelTest::Expected(bool descending)
+{
+   QVector<int> rv;
+   QSqlQuery q1(QSqlDatabase::database(CONNECTION));
+   q1.exec(QUERY + (descending ? " order by amount desc, id asc" : " order by amount asc, id asc"));
+   while ( q1.next() ) 
+   {
+      rv.append(q1.value(0).toInt());
+   }
+   return(rv);
+}
+
+void PagedModelTest::pageAcrossNulls_data()
+{
+   QTest::addColumn<bool>("descending");
+   QTest::addColumn<bool>("backwards");
+
+   QTest::newRow("asc forwards") << false << false;
+   QTest::newRow("asc backwards") << false << true;
+   QTest::newRow("desc forwards") << true << false;
+   QTest::newRow("desc backwards") << true << true;
+}
+
+/********************************************************************//*
+**   Reading  backwards  starts  with  the last page, read by offset,
+**   and then each page is found by keyset from the one after it.
+***********************************************************************/
+void PagedModelTest::pageAcrossNulls()
+{
+   QFETCH(bool, descending);
+   QFETCH(bool, backwards);
+
+   SqlPagedTableModel model;
+   model.SetKeyColumn("id");
+   model.SetQuery(QUERY, QSqlDatabase::database(CONNECTION));
+   model.SetOrder("amount");
+   if ( descending ) 
+   {
+      model.SetOrder("amount");
+   }
+   model.select();
+   QCOMPARE(model.rowCount(), FIXTURE_ROWS);
+
+   int id_column = model.record().indexOf("id");
+   int pages = (FIXTURE_ROWS + SqlPagedTableModel::PAGE_SIZE - 1) / SqlPagedTableModel::PAGE_SIZE;
+   QVector<int> ids(FIXTURE_ROWS, 0);
+   for (int p = 0; p < pages; p++) 
+   {
+      int page = backwards ? pages - 1 - p : p;
+      int last = qMin((page + 1) * SqlPagedTableModel::PAGE_SIZE, FIXTURE_ROWS);
+      for (int row = page * SqlPagedTableModel::PAGE_SIZE; row < last; row++) 
+      {
+         ids[row] = model.data(model.index(row, id_column)).toInt();
+      }
+   }
+   QCoreApplication::processEvents();
+
+   QCOMPARE(model.rowCount(), FIXTURE_ROWS);
+   QCOMPARE(ids, Expected(descending));
+}
+
+void PagedModelTest::inlineValues()
+{
+   const QSqlDriver *driver = QSqlDatabase::database(CONNECTION).driver();
+   QVariantList values;
+   values << 42 << "it's" << QVariant(QVariant::String);
+
+   QCOMPARE(PagedModel::InlineValues("a = ? and b = '?' and \"c?\" = ? and d is ?", values, driver), 
+            QString("a = 42 and b = '?' and \"c?\" = 'it''s' and d is NULL"));
+}
+
+QTEST_GUILESS_MAIN(PagedModelTest)
+# include "PagedModelTest.moc"
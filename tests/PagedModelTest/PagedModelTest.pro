@@ -0,0 +1,4 @@
+TARGET = PagedModelTest
+SOURCES = ../PagedModelTest.cpp
+
+include(../tests.pri)
@@ -0,0 +1,231 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+/********************************************************************//*
+**   @file SortRoundTripTest.cpp
+**   
+**   PROJECT QcjLib
+**   
+**   Description:  Counts  the  statements  SqlSortableTableModel
+**   prepares  and  executes  for  each  header  click  against  an
+**   SQLite  fixture,  using  the  model's  qcjlib_model_queries_total
+**   and  qcjlib_model_prepares_total  counters,  and  benchmarks a
+**   sort click against the old setQuery() plus prepared re-execution.
+**   Also  checks  a  local  sort  orders  rows  as  SQLite  does  and
+**   record(int) follows it.
+**
+**   Usage: SortRoundTripTest [QtTest options]
+***********************************************************************/
+# include "../MetricBuilder.h"
+# include "../SqlSortableTableModel.h"
+
+# include <QSqlDatabase>
+# include <QSqlQuery>
+# include <QSqlQueryModel>
+# include <QTemporaryDir>
+# include <QtTest>
+
+using namespace QcjLib;
+
+static const QString CONNECTION("QcjLib_sort_test");
+static const QString QUERY("select id, customer, amount, placed from orders");
+static const int     FIXTURE_ROWS = 20000;
+
+class SortRoundTripTest : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void initTestCase();
+   void cleanupTestCase();
+   void sortClickRoundTrips();
+   void localSortRoundTrips();
+   void localSortOrder();
+   void sortClickBefore();
+   void sortClickAfter();
+
+private:
+   quint64 ModelCounter(const QString &metric, const QString &model_name);
+
+   QTemporaryDir  m_dir;
+};
+
+void SortRoundTripTest::initTestCase()
+{
+   QVERIFY(m_dir.isValid());
+
+   QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", CONNECTION);
+   db.setDatabaseName(m_dir.filePath("orders.db"));
+   QVERIFY(db.open());
+
+   QSqlQuery q1(db);
+   QVERIFY(q1.exec("create table orders (id integer primary key, customer text, amount real, placed integer)"));
+   QVERIFY(q1.prepare("insert into orders (customer, amount, placed) values (?, ?, ?)"));
+
+   db.transaction();
+   for (int x = 0; x < FIXTURE_ROWS; x++) 
+   {
+      q1.bindValue(0, QString("customer %1").arg(x % 997));
+      q1.bindValue(1, (x * 7919) % 100000 / 100.0);
+      q1.bindValue(2, 1700000000 + (x * 104729) % 31536000);
+      QVERIFY(q1.exec());
+   }
+   QVERIFY(db.commit());
+
+   QVERIFY(q1.exec("create table big (id integer primary key, serial integer, name text)"));
+   QVERIFY(q1.exec("insert into big (serial, name) values "
+                   "(9007199254740993, 'b'), (null, 'B'), (9007199254740992, 'a'), (9007199254740994, null)"));
+}
+
+void SortRoundTripTest::cleanupTestCase()
+{
+   QSqlDatabase::database(CONNECTION).close();
+   QSqlDatabase::removeDatabase(CONNECTION);
+}
+
+quint64 SortRoundTripTest::ModelCounter(const QString &metric, const QString &model_name)
+{
+   QString labels = "model=\"QcjLib::SqlSortableTableModel:" + model_name + "\"";
+   return(MetricCounter(metric, QString(), labels).Value());
+}
+
+/********************************************************************//*
+**   Only  the  first  rows  are  fetched,  so  every click goes back
+**   to  the  database.  Each  click  must  be  one execution, and
+**   flipping  between  ascending  and  descending  must only prepare
+**   each order by once.
+***********************************************************************/
+void SortRoundTripTest::sortClickRoundTrips()
+{
+   SqlSortableTableModel model;
+   model.setObjectName("sort_click");
+   model.SetQuery(QUERY, QSqlDatabase::database(CONNECTION));
+   QVERIFY(model.canFetchMore());
+
+   quint64 queries = ModelCounter("qcjlib_model_queries_total", "sort_click");
+   quint64 prepares = ModelCounter("qcjlib_model_prepares_total", "sort_click");
+   QCOMPARE(queries, (quint64)1);
+   QCOMPARE(prepares, (quint64)1);
+
+   for (int click = 1; click <= 10; click++) 
+   {
+      model.SetOrder("amount");
+      model.ApplyOrder();
+      QCOMPARE(ModelCounter("qcjlib_model_queries_total", "sort_click"), queries + click);
+   }
+   QCOMPARE(ModelCounter("qcjlib_model_prepares_total", "sort_click"), prepares + 2);
+   qDebug() << "10 clicks:" << ModelCounter("qcjlib_model_queries_total", "sort_click") - queries << "executions,"
+            << ModelCounter("qcjlib_model_prepares_total", "sort_click") - prepares << "prepares";
+}
+
+/********************************************************************//*
+**   Once  every  row  has  been  fetched  a  click  is  sorted  in
+**   the model, without a round trip.
+***********************************************************************/
+void SortRoundTripTest::localSortRoundTrips()
+{
+   SqlSortableTableModel model;
+   model.setObjectName("local_sort");
+   model.SetQuery(QUERY, QSqlDatabase::database(CONNECTION));
+   while ( model.canFetchMore() ) 
+   {
+      model.fetchMore();
+   }
+   QCOMPARE(model.rowCount(), FIXTURE_ROWS);
+
+   quint64 queries = ModelCounter("qcjlib_model_queries_total", "local_sort");
+   model.SetOrder("customer");
+   model.ApplyOrder();
+   QCOMPARE(ModelCounter("qcjlib_model_queries_total", "local_sort"), queries);
+
+   int column = model.record().indexOf("customer");
+   QCOMPARE(model.record(0).value("customer"), model.data(model.index(0, column)));
+   QCOMPARE(model.record(FIXTURE_ROWS - 1).value("customer"), model.data(model.index(FIXTURE_ROWS - 1, column)));
+}
+
+/********************************************************************//*
+**   A  local  sort  must  give  the same order as SQLite: NULLs first,
+**   integers  past  2^53  kept  apart  and  strings  by  character
+**   code.
+***********************************************************************/
+void SortRoundTripTest::localSortOrder()
+{
+   QSqlDatabase db = QSqlDatabase::database(CONNECTION);
+
+   foreach (QString column, QStringList() << "serial" << "name")
+   {
+      SqlSortableTableModel model;
+      model.SetQuery("select id, serial, name from big", db);
+      model.SetOrder(column);
+      QVERIFY(model.SortLocally());
+
+      QSqlQuery q1(db);
+      QVERIFY(q1.exec("select id from big order by " + column + ", id"));
+      for (int row = 0; q1.next(); row++) 
+      {
+         QCOMPARE(model.record(row).value("id").toInt(), q1.value(0).toInt());
+      }
+   }
+}
+
+/********************************************************************//*
+**   Before:  setQuery()  executes  the  statement and the model then
+**   prepares and executes it again to keep it.
+***********************************************************************/
+void SortRoundTripTest::sortClickBefore()
+{
+   QSqlDatabase db = QSqlDatabase::database(CONNECTION);
+   QSqlQueryModel model;
+   bool descending = false;
+
+   QBENCHMARK
+   {
+      QString sql = QUERY + (descending ? " order by amount desc" : " order by amount asc");
+      descending = ! descending;
+
+      model.setQuery(sql, db);
+      QSqlQuery kept(db);
+      kept.prepare(sql);
+      kept.exec();
+   }
+}
+
+void SortRoundTripTest::sortClickAfter()
+{
+   SqlSortableTableModel model;
+   model.setObjectName("sort_bench");
+   model.SetQuery(QUERY, QSqlDatabase::database(CONNECTION));
+
+   QBENCHMARK
+   {
+      model.SetOrder("amount");
+      model.ApplyOrder();
+   }
+}
+
+QTEST_GUILESS_MAIN(SortRoundTripTest)
+# include "SortRoundTripTest.moc"
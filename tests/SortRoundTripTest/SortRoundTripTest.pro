@@ -0,0 +1,4 @@
+TARGET = SortRoundTripTest
+SOURCES = ../SortRoundTripTest.cpp
+
+include(../tests.pri)
@@ -0,0 +1,156 @@
+/******************************************************************************/
+/* $Id$                              */
+/*                                                                            */
+/* Author: Joe Croft, joe@croftj.net 2023-2024                                     */
+/*                                                                            */
+/* This is free and unencumbered software released into the public domain.    */
+/*                                                                            */
+/* Anyone is free to copy, modify, publish, use, compile, sell, or distribute */
+/* this software, either in source code form or as a compiled binary,         */
+/* for any purpose, commercial or non-commercial, and by any means.           */
+/*                                                                            */
+/* In jurisdictions that recognize copyright laws, the author or authors of   */
+/* this software dedicate any and all copyright interest in the software to   */
+/* the public domain. We make this dedication for the benefit of the public   */
+/* at large and to the detriment of our heirs and successors. We intend       */
+/* this dedication to be an overt act of relinquishment in perpetuity of      */
+/* all present and future rights to this software under copyright law.        */
+/*                                                                            */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL   */
+/* THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER   */
+/* IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+/*                                                                            */
+/* For more information, please refer to <http://unlicense.org/>              */
+/******************************************************************************/
+/********************************************************************//*
+**   @file StallDetectorTest.cpp
+**   
+**   PROJECT QcjLib
+**   
+**   Description:  Runs  the  StallDetector  against a headless event
+**   loop,  blocks  the  loop  on  purpose  and checks that the stall
+**   is  counted and reported once while it is blocked and once when
+**   it  catches up, that an idle loop is left alone and that Stop()
+**   joins the watch thread.
+**
+**   Usage: StallDetectorTest [QtTest options]
+***********************************************************************/
+# include "../DbgTimer.h"
+# include "../LogRegistery.h"
+# include "../StallDetector.h"
+
+# include <QAtomicInt>
+# include <QThread>
+# include <QtTest>
+
+using namespace QcjLib;
+
+namespace
+{
+   QAtomicInt  blocked_warnings;
+   QAtomicInt  stalled_warnings;
+
+   /***********************************************/
+   /*   Called from the watch thread, so only     */
+   /*   counts the detector's warnings.           */
+   /***********************************************/
+   void CountingHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+   {
+      if ( type != QtWarningMsg || ! QString(context.category).startsWith(StallDetector::LOG) ) 
+         return;
+
+      if ( msg.startsWith("GUI event loop blocked") ) 
+         blocked_warnings.fetchAndAddRelaxed(1);
+      else if ( msg.startsWith("GUI event loop stalled") ) 
+         stalled_warnings.fetchAndAddRelaxed(1);
+   }
+
+   void BlockEventLoop(unsigned long ms)
+   {
+      QCJ_TIME_SCOPE("stall test block");
+      QThread::msleep(ms);
+   }
+}
+
+class StallDetectorTest : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void initTestCase();
+   void cleanupTestCase();
+   void idleLoopIsQuiet();
+   void blockedLoopIsReported();
+   void stopJoinsWatcher();
+
+private:
+   QtMessageHandler  m_previous;
+};
+
+void StallDetectorTest::initTestCase()
+{
+   m_previous = qInstallMessageHandler(CountingHandler);
+}
+
+void StallDetectorTest::cleanupTestCase()
+{
+   StallDetector::instance()->Stop();
+   qInstallMessageHandler(m_previous);
+}
+
+void StallDetectorTest::idleLoopIsQuiet()
+{
+   StallDetector *detector = StallDetector::instance();
+
+   detector->Start(200, 10);
+   QVERIFY(detector->IsRunning());
+
+   quint64 stalls = detector->StallCount();
+   QTest::qWait(500);
+   QCOMPARE(detector->StallCount(), stalls);
+}
+
+/********************************************************************//*
+**   The  GUI  thread  sleeps  well  past  the  threshold. The watch
+**   thread  warns  to  the  stall  log  while  it  is  asleep  and
+**   again  once  the  late  heartbeat is handled. The log's level
+**   only gates debug output, so turning it off keeps the warnings.
+***********************************************************************/
+void StallDetectorTest::blockedLoopIsReported()
+{
+   StallDetector *detector = StallDetector::instance();
+   LogRegistery::instance()->SetLogLevel(StallDetector::LOG, 0);
+
+   detector->Start(50, 10);
+   QTest::qWait(100);
+
+   quint64 stalls = detector->StallCount();
+   blocked_warnings.storeRelaxed(0);
+   stalled_warnings.storeRelaxed(0);
+
+   BlockEventLoop(400);
+   QTRY_COMPARE_WITH_TIMEOUT(detector->StallCount(), stalls + 1, 2000);
+   QCOMPARE(blocked_warnings.loadRelaxed(), 1);
+   QCOMPARE(stalled_warnings.loadRelaxed(), 1);
+   LogRegistery::instance()->SetLogLevel(StallDetector::LOG, 1);
+}
+
+void StallDetectorTest::stopJoinsWatcher()
+{
+   StallDetector *detector = StallDetector::instance();
+
+   detector->Start(50, 10);
+   detector->Stop();
+   QVERIFY(! detector->IsRunning());
+
+   quint64 stalls = detector->StallCount();
+   BlockEventLoop(200);
+   QTest::qWait(100);
+   QCOMPARE(detector->StallCount(), stalls);
+}
+
+QTEST_GUILESS_MAIN(StallDetectorTest)
+# include "StallDetectorTest.moc"
@@ -0,0 +1,4 @@
+TARGET = StallDetectorTest
+SOURCES = ../StallDetectorTest.cpp
+
+include(../tests.pri)
@@ -0,0 +1,51 @@
+#
+# The  logging,  metrics  and SQL model sources of QcjLib, compiled
+# into  every  test  so  that  each  LogBuilder  registration  is
+# linked in.
+#
+SRC = $$PWD/..
+INCLUDEPATH += $$SRC
+
+HEADERS += $$SRC/BinaryLogFormat.h \
+           $$SRC/BinaryLogWriter.h \
+           $$SRC/DbgTimer.h \
+           $$SRC/FlightRecorder.h \
+           $$SRC/LogBuilder.h \
+           $$SRC/LogHandle.h \
+           $$SRC/LogRecord.h \
+           $$SRC/LogRegistery.h \
+           $$SRC/LogRingBuffer.h \
+           $$SRC/Logger.h \
+           $$SRC/MetricBuilder.h \
+           $$SRC/MetricsRegistery.h \
+           $$SRC/QueryCache.h \
+           $$SRC/ScopeProfiler.h \
+           $$SRC/ScopeStack.h \
+           $$SRC/SqlColumnStore.h \
+           $$SRC/SqlFilter.h \
+           $$SRC/SqlLogSink.h \
+           $$SRC/SqlPagedTableModel.h \
+           $$SRC/SqlQueryWorker.h \
+           $$SRC/SqlSortableTableModel.h \
+           $$SRC/StallDetector.h \
+           $$SRC/StructuredLog.h \
+           $$SRC/TraceRecorder.h
+
+SOURCES += $$SRC/BinaryLogWriter.cpp \
+           $$SRC/DbgTimer.cpp \
+           $$SRC/FlightRecorder.cpp \
+           $$SRC/LogRegistery.cpp \
+           $$SRC/Logger.cpp \
+           $$SRC/MetricsRegistery.cpp \
+           $$SRC/QueryCache.cpp \
+           $$SRC/ScopeProfiler.cpp \
+           $$SRC/ScopeStack.cpp \
+           $$SRC/SqlColumnStore.cpp \
+           $$SRC/SqlFilter.cpp \
+           $$SRC/SqlLogSink.cpp \
+           $$SRC/SqlPagedTableModel.cpp \
+           $$SRC/SqlQueryWorker.cpp \
+           $$SRC/SqlSortableTableModel.cpp \
+           $$SRC/StallDetector.cpp \
+           $$SRC/StructuredLog.cpp \
+           $$SRC/TraceRecorder.cpp
@@ -0,0 +1,11 @@
+#
+# Settings  shared  by  the  test  programs. Each test directory holds
+# only  a  .pro  naming  its  source  one  level  up  and  including
+# this file.
+#
+TEMPLATE = app
+CONFIG += console testcase c++11
+CONFIG -= app_bundle
+QT = core network sql testlib
+
+include(qcjlib.pri)
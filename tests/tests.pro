@@ -0,0 +1,20 @@
+#
+# Builds  the  QcjLib  tests  with  the non GUI sources of the
+# library. From a build directory:
+#
+#    qmake /path/to/QcjLib/tests/tests.pro && make && make check
+#
+# make  check  runs every test but ColumnStoreBenchmark, which loads
+# a half million row report and is run by hand.
+#
+TEMPLATE = subdirs
+
+SUBDIRS = AsyncSelectTest \
+          ColumnStoreBenchmark \
+          FilterPrepareTest \
+          LogLevelTest \
+          LogRegisteryStressTest \
+          PagedModelTest \
+          SortRoundTripTest \
+          StallDetectorTest
+